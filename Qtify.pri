@@ -1,15 +1,20 @@
 HEADERS += \
     $$files($$PWD/models/*.h)  \
     $$files($$PWD/private/*.h) \
-    $$PWD/RequestHandler.h
+    $$PWD/RequestHandler.h \
+    $$PWD/RequestHandlerPool.h \
+    $$PWD/RequestStatistics.h \
+    $$PWD/RetryPolicy.h \
+    $$PWD/SpotifyApiRequest.h
 
 SOURCES += \
     $$files($$PWD/models/*.cpp)  \
     $$files($$PWD/private/*.cpp) \
-    $$PWD/RequestHandler.cpp
+    $$PWD/RequestHandler.cpp \
+    $$PWD/RequestHandlerPool.cpp
 
 INCLUDEPATH += $$PWD
 
 CONFIG += c++14
 
-QT += networkauth
+QT += gui networkauth
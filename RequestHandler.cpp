@@ -3,10 +3,10 @@
 #include <QThread>
 #include <QtGlobal>
 
-#include "private/RequestHandlerPrivate.h"
+#include <functional>
+#include <memory>
 
-Q_DECLARE_METATYPE(QSharedPointer<Qtify::User>);
-Q_DECLARE_METATYPE(QSharedPointer<Qtify::CurrentPlayback>);
+#include "private/RequestHandlerPrivate.h"
 
 namespace Qtify
 {
@@ -18,20 +18,32 @@ namespace Qtify
     * invokeMethod uses a lambda with the worker object as context so that the lambda is executed in the
     * worker thread.
     *   Queued signal parameters require to be declared with Q_DECLARE_METATYPE, which requires the type
-    * to be default constructible. We don't want the API types to be default constructible so a
-    * QSharedPointer is used to communicate with the worker object. The pointer is dereferenced in order
-    * to provide a non-pointer object to the user of the API.
+    * to be default constructible. The API types emitted by the worker have an empty default state for
+    * that purpose. They are implicitly shared, so passing them between threads only costs a reference
+    * count increment.
     ***************************************************************************************************/
 
     struct RequestHandler::RequestHandlerData
     {
         // The object actually doing all the work.
-        RequestHandlerPrivate requestHandlerImpl;
+        RequestHandlerPrivate    requestHandlerImpl;
+        // The thread of the worker when it is not shared with other workers.
+        std::unique_ptr<QThread> ownedThread;
         // The thread in which the worker is ran.
-        QThread               requestHandlerThread;
+        QThread                 *requestHandlerThread;
 
         RequestHandlerData(const QString &clientId, const QString &clientSecret, int replyPort):
-            requestHandlerImpl(clientId, clientSecret, replyPort)
+            requestHandlerImpl(clientId, clientSecret, replyPort),
+            ownedThread(new QThread),
+            requestHandlerThread(ownedThread.get())
+        {
+
+        }
+
+        RequestHandlerData(const QString &clientId, const QString &clientSecret, int replyPort,
+                           QThread *thread, QNetworkAccessManager *networkAccessManager):
+            requestHandlerImpl(clientId, clientSecret, replyPort, networkAccessManager),
+            requestHandlerThread(thread)
         {
 
         }
@@ -48,33 +60,87 @@ namespace Qtify
     * @param[in]    parent: The QObject parent.
     ***************************************************************************************************/
     RequestHandler::RequestHandler(const QString &clientId, const QString &clientSecret, int replyPort, QObject *parent) :
+        RequestHandler(new RequestHandlerData(clientId, clientSecret, replyPort), parent)
+    {
+
+    }
+
+    /** ************************************************************************************************
+    * @brief        Constructor of a worker hosted by a RequestHandlerPool.
+    *
+    * @param[in]    thread: The running thread shared by the workers of the pool.
+    * @param[in]    networkAccessManager: The network access manager living in that thread.
+    ***************************************************************************************************/
+    RequestHandler::RequestHandler(const QString &clientId, const QString &clientSecret, int replyPort,
+                                   QThread *thread, QNetworkAccessManager *networkAccessManager, QObject *parent) :
+        RequestHandler(new RequestHandlerData(clientId, clientSecret, replyPort, thread, networkAccessManager), parent)
+    {
+
+    }
+
+    /** ************************************************************************************************
+    * @brief        Constructor doing the actual initialization.
+    ***************************************************************************************************/
+    RequestHandler::RequestHandler(RequestHandlerData *data, QObject *parent) :
         QObject(parent),
-        m_data(new RequestHandlerData(clientId, clientSecret, replyPort))
+        m_data(data)
     {
-        qRegisterMetaType<QSharedPointer<User>>("QSharedPointer<User>");
-        qRegisterMetaType<QSharedPointer<CurrentPlayback>>("QSharedPointer<CurrentPlayback>");
+        qRegisterMetaType<User>("User");
+        qRegisterMetaType<CurrentPlayback>("CurrentPlayback");
+        qRegisterMetaType<std::vector<Track>>("std::vector<Track>");
+        qRegisterMetaType<std::vector<Album>>("std::vector<Album>");
+        qRegisterMetaType<std::vector<Artist>>("std::vector<Artist>");
 
         connect(&m_data->requestHandlerImpl, &RequestHandlerPrivate::accessGranted,
                 this,                        &RequestHandler::accessGranted);
         connect(&m_data->requestHandlerImpl, &RequestHandlerPrivate::tokenRefreshed,
                 this,                        &RequestHandler::tokenRefreshed);
-        connect(&m_data->requestHandlerImpl, &RequestHandlerPrivate::userDataAvailable, this,
-                [this](const QSharedPointer<User> &user)
-                {
-                    emit userDataAvailable(*user);
-                });
-        connect(&m_data->requestHandlerImpl, &RequestHandlerPrivate::currentPlaybackUpdated, this,
-                [this](const QSharedPointer<CurrentPlayback> &playback)
-                {
-                    emit currentPlaybackUpdated(*playback);
-                });
+        connect(&m_data->requestHandlerImpl, &RequestHandlerPrivate::userDataAvailable,
+                this,                        &RequestHandler::userDataAvailable);
+        connect(&m_data->requestHandlerImpl, &RequestHandlerPrivate::currentPlaybackUpdated,
+                this,                        &RequestHandler::currentPlaybackUpdated);
+        connect(&m_data->requestHandlerImpl, &RequestHandlerPrivate::tracksAvailable,
+                this,                        &RequestHandler::tracksAvailable);
+        connect(&m_data->requestHandlerImpl, &RequestHandlerPrivate::albumsAvailable,
+                this,                        &RequestHandler::albumsAvailable);
+        connect(&m_data->requestHandlerImpl, &RequestHandlerPrivate::artistsAvailable,
+                this,                        &RequestHandler::artistsAvailable);
+        connect(&m_data->requestHandlerImpl, &RequestHandlerPrivate::savedTracksPageAvailable,
+                this,                        &RequestHandler::savedTracksPageAvailable);
+        connect(&m_data->requestHandlerImpl, &RequestHandlerPrivate::albumTracksPageAvailable,
+                this,                        &RequestHandler::albumTracksPageAvailable);
+        connect(&m_data->requestHandlerImpl, &RequestHandlerPrivate::playlistTracksPageAvailable,
+                this,                        &RequestHandler::playlistTracksPageAvailable);
+        connect(&m_data->requestHandlerImpl, &RequestHandlerPrivate::savedTracksFetchFinished,
+                this,                        &RequestHandler::savedTracksFetchFinished);
+        connect(&m_data->requestHandlerImpl, &RequestHandlerPrivate::albumTracksFetchFinished,
+                this,                        &RequestHandler::albumTracksFetchFinished);
+        connect(&m_data->requestHandlerImpl, &RequestHandlerPrivate::playlistTracksFetchFinished,
+                this,                        &RequestHandler::playlistTracksFetchFinished);
+        connect(&m_data->requestHandlerImpl, &RequestHandlerPrivate::albumArtAvailable,
+                this,                        &RequestHandler::albumArtAvailable);
+        connect(&m_data->requestHandlerImpl, &RequestHandlerPrivate::schedulerStatusChanged,
+                this,                        &RequestHandler::schedulerStatusChanged);
 
         // Move the worker to a separate thread and initialize it from this thread.
-        m_data->requestHandlerImpl.moveToThread(&m_data->requestHandlerThread);
-        m_data->requestHandlerThread.start();
+        m_data->requestHandlerImpl.moveToThread(m_data->requestHandlerThread);
+        if (m_data->ownedThread)
+        {
+            m_data->ownedThread->start();
+        }
         QMetaObject::invokeMethod(&m_data->requestHandlerImpl, &RequestHandlerPrivate::init);
     }
 
+    /** ************************************************************************************************
+    * @brief        Connect to the Spotify servers in advance so that the first request is faster.
+    *
+    * @details      Call this right after construction, typically at application start up.
+    ***************************************************************************************************/
+    void RequestHandler::prewarmConnections()
+    {
+        QMetaObject::invokeMethod(&m_data->requestHandlerImpl, &RequestHandlerPrivate::prewarmConnections);
+    }
+
     /** ************************************************************************************************
     * @brief        Request to grant access to the API for.
     *
@@ -115,6 +181,113 @@ namespace Qtify
         QMetaObject::invokeMethod(&m_data->requestHandlerImpl, &RequestHandlerPrivate::getCurrentPlaybackInformation);
     }
 
+    /** ************************************************************************************************
+    * @brief        Subscribe to playback updates.
+    *
+    * @details      The current playback is polled until every subscription is removed with
+    *               unsubscribePlayback(). The polling rate adapts to the playback state: faster near the
+    *               end of a track, slower while paused and backing off while no device is active.
+    *               Updates are received with the signal currentPlaybackUpdated.
+    ***************************************************************************************************/
+    void RequestHandler::subscribePlayback()
+    {
+        QMetaObject::invokeMethod(&m_data->requestHandlerImpl, &RequestHandlerPrivate::subscribePlayback);
+    }
+
+    /** ************************************************************************************************
+    * @brief        Remove a subscription added with subscribePlayback().
+    ***************************************************************************************************/
+    void RequestHandler::unsubscribePlayback()
+    {
+        QMetaObject::invokeMethod(&m_data->requestHandlerImpl, &RequestHandlerPrivate::unsubscribePlayback);
+    }
+
+    /** ************************************************************************************************
+    * @brief        Get tracks by id.
+    *
+    * @details      Any number of ids can be given: they are sent in as few requests as the API allows,
+    *               and in parallel. The tracks are received with the signal tracksAvailable, in the order
+    *               of the ids.
+    ***************************************************************************************************/
+    void RequestHandler::getTracks(const QStringList &ids)
+    {
+        QMetaObject::invokeMethod(&m_data->requestHandlerImpl,
+                                  std::bind(&RequestHandlerPrivate::getTracks, &m_data->requestHandlerImpl, ids));
+    }
+
+    /** ************************************************************************************************
+    * @brief        Get albums by id.
+    *
+    * @details      The albums are received with the signal albumsAvailable, in the order of the ids.
+    ***************************************************************************************************/
+    void RequestHandler::getAlbums(const QStringList &ids)
+    {
+        QMetaObject::invokeMethod(&m_data->requestHandlerImpl,
+                                  std::bind(&RequestHandlerPrivate::getAlbums, &m_data->requestHandlerImpl, ids));
+    }
+
+    /** ************************************************************************************************
+    * @brief        Get artists by id.
+    *
+    * @details      The artists are received with the signal artistsAvailable, in the order of the ids.
+    ***************************************************************************************************/
+    void RequestHandler::getArtists(const QStringList &ids)
+    {
+        QMetaObject::invokeMethod(&m_data->requestHandlerImpl,
+                                  std::bind(&RequestHandlerPrivate::getArtists, &m_data->requestHandlerImpl, ids));
+    }
+
+    /** ************************************************************************************************
+    * @brief        Get all the tracks saved in the library of the user.
+    *
+    * @details      The pages are fetched in parallel and received with the signal savedTracksPageAvailable
+    *               as soon as each one arrives, so they may arrive out of order. Use the offset of each
+    *               page to place its tracks. savedTracksFetchFinished is emitted once all the pages are
+    *               received, with success set to false if any of them failed.
+    ***************************************************************************************************/
+    void RequestHandler::getSavedTracks()
+    {
+        QMetaObject::invokeMethod(&m_data->requestHandlerImpl, &RequestHandlerPrivate::getSavedTracks);
+    }
+
+    /** ************************************************************************************************
+    * @brief        Get all the tracks of an album.
+    *
+    * @details      The pages are received with the signal albumTracksPageAvailable, possibly out of order.
+    *               albumTracksFetchFinished is emitted once all the pages are received or failed.
+    ***************************************************************************************************/
+    void RequestHandler::getAlbumTracks(const QString &albumId)
+    {
+        QMetaObject::invokeMethod(&m_data->requestHandlerImpl,
+                                  std::bind(&RequestHandlerPrivate::getAlbumTracks, &m_data->requestHandlerImpl, albumId));
+    }
+
+    /** ************************************************************************************************
+    * @brief        Get all the tracks of a playlist.
+    *
+    * @details      The pages are received with the signal playlistTracksPageAvailable, possibly out of
+    *               order. playlistTracksFetchFinished is emitted once all the pages are received or failed.
+    ***************************************************************************************************/
+    void RequestHandler::getPlaylistTracks(const QString &playlistId)
+    {
+        QMetaObject::invokeMethod(&m_data->requestHandlerImpl,
+                                  std::bind(&RequestHandlerPrivate::getPlaylistTracks, &m_data->requestHandlerImpl, playlistId));
+    }
+
+    /** ************************************************************************************************
+    * @brief        Get the artwork of an album, decoded outside of the calling thread.
+    *
+    * @details      The smallest image of the album covering the given size is downloaded, or the largest
+    *               one if none is large enough. The image is received with the signal albumArtAvailable,
+    *               null if the album has no image or if it could not be loaded. Decoded images are
+    *               cached, and the artwork of the current track is prefetched while playback is polled.
+    ***************************************************************************************************/
+    void RequestHandler::getAlbumArt(const Album &album, const QSize &size)
+    {
+        QMetaObject::invokeMethod(&m_data->requestHandlerImpl,
+                                  std::bind(&RequestHandlerPrivate::getAlbumArt, &m_data->requestHandlerImpl, album, size));
+    }
+
     /** ************************************************************************************************
     * @brief        Resume the current playing track.
     ***************************************************************************************************/
@@ -160,12 +333,236 @@ namespace Qtify
                                   std::bind(&RequestHandlerPrivate::seek, &m_data->requestHandlerImpl, positionMs));
     }
 
+    /** ************************************************************************************************
+    * @brief        Send the requests to other servers than the Spotify ones, such as a local mock of the
+    *               Web API for offline load tests.
+    *
+    * @details      Any of the URLs can be empty to keep the Spotify one. The API URL is the base to which
+    *               paths such as "v1/me/player" are appended.
+    ***************************************************************************************************/
+    void RequestHandler::setServiceUrls(const QUrl &apiUrl, const QUrl &authorizationUrl, const QUrl &tokenUrl)
+    {
+        QMetaObject::invokeMethod(&m_data->requestHandlerImpl,
+                                  std::bind(&RequestHandlerPrivate::setServiceUrls,
+                                            &m_data->requestHandlerImpl, apiUrl, authorizationUrl, tokenUrl));
+    }
+
+    /** ************************************************************************************************
+    * @brief        Set the maximum rate at which requests are sent to the API.
+    *
+    * @details      Requests are queued and sent according to a token bucket. When the API answers
+    *               "429 Too Many Requests", sending is paused for the time given by "Retry-After" and
+    *               the request is sent again. The signal schedulerStatusChanged reports the number of
+    *               queued requests and the total time spent throttled.
+    *
+    * @param[in]    requestsPerSecond: The average number of requests per second. 0 to disable the limit.
+    * @param[in]    burst: The maximum number of requests sent at once.
+    ***************************************************************************************************/
+    void RequestHandler::setRateLimit(double requestsPerSecond, int burst)
+    {
+        QMetaObject::invokeMethod(&m_data->requestHandlerImpl,
+                                  std::bind(&RequestHandlerPrivate::setRateLimit,
+                                            &m_data->requestHandlerImpl, requestsPerSecond, burst));
+    }
+
+    /** ************************************************************************************************
+    * @brief        Set the maximum number of data reads (background requests) waiting for a reply.
+    *
+    * @details      Playback commands (interactive requests) are always sent first and are not limited,
+    *               so a backlog of reads does not delay them.
+    ***************************************************************************************************/
+    void RequestHandler::setMaxBackgroundRequests(int maxRequests)
+    {
+        QMetaObject::invokeMethod(&m_data->requestHandlerImpl,
+                                  std::bind(&RequestHandlerPrivate::setMaxBackgroundRequests,
+                                            &m_data->requestHandlerImpl, maxRequests));
+    }
+
+    /** ************************************************************************************************
+    * @brief        Set how requests of the given type are retried after a transient network error or a
+    *               server error.
+    *
+    * @details      Track skips are not retried by default since they are not idempotent.
+    ***************************************************************************************************/
+    void RequestHandler::setRetryPolicy(SpotifyApiRequest requestType, const RetryPolicy &policy)
+    {
+        QMetaObject::invokeMethod(&m_data->requestHandlerImpl,
+                                  std::bind(&RequestHandlerPrivate::setRetryPolicy,
+                                            &m_data->requestHandlerImpl, requestType, policy));
+    }
+
+    /** ************************************************************************************************
+    * @brief        Store the tracks, albums and artists received in a file, so that later lookups are
+    *               answered without requests, including after a restart.
+    *
+    * @details      The file is memory-mapped. Objects are requested again after timeToLive. The file is
+    *               compacted when it grows over maxSize bytes. An empty path disables the cache.
+    ***************************************************************************************************/
+    void RequestHandler::setCatalogCache(const QString &path, qint64 maxSize, std::chrono::seconds timeToLive)
+    {
+        QMetaObject::invokeMethod(&m_data->requestHandlerImpl,
+                                  std::bind(&RequestHandlerPrivate::setCatalogCache,
+                                            &m_data->requestHandlerImpl, path, maxSize, timeToLive));
+    }
+
+    /** ************************************************************************************************
+    * @brief        Set the budget in bytes of the in-memory cache of parsed tracks, albums and artists.
+    *
+    * @details      The least recently used objects are evicted when the estimated size of the cached
+    *               objects exceeds the budget. A budget of 0 disables the cache.
+    ***************************************************************************************************/
+    void RequestHandler::setCatalogMemoryCacheSize(int maxSize)
+    {
+        QMetaObject::invokeMethod(&m_data->requestHandlerImpl,
+                                  std::bind(&RequestHandlerPrivate::setCatalogMemoryCacheSize,
+                                            &m_data->requestHandlerImpl, maxSize));
+    }
+
+    /** ************************************************************************************************
+    * @brief        Remove the track, album or artist with the given id from the in-memory and persistent
+    *               caches, so that the next lookup requests it again.
+    ***************************************************************************************************/
+    void RequestHandler::invalidateCatalogObject(const QString &id)
+    {
+        QMetaObject::invokeMethod(&m_data->requestHandlerImpl,
+                                  std::bind(&RequestHandlerPrivate::invalidateCatalogObject,
+                                            &m_data->requestHandlerImpl, id));
+    }
+
+    /** ************************************************************************************************
+    * @brief        Set the budget in bytes of the cache of decoded album artwork.
+    ***************************************************************************************************/
+    void RequestHandler::setAlbumArtCacheSize(int maxSize)
+    {
+        QMetaObject::invokeMethod(&m_data->requestHandlerImpl,
+                                  std::bind(&RequestHandlerPrivate::setAlbumArtCacheSize,
+                                            &m_data->requestHandlerImpl, maxSize));
+    }
+
+    /** ************************************************************************************************
+    * @brief        Set the size of the artwork prefetched when the current track changes. An empty size
+    *               disables prefetching.
+    ***************************************************************************************************/
+    void RequestHandler::setAlbumArtPrefetchSize(const QSize &size)
+    {
+        QMetaObject::invokeMethod(&m_data->requestHandlerImpl,
+                                  std::bind(&RequestHandlerPrivate::setAlbumArtPrefetchSize,
+                                            &m_data->requestHandlerImpl, size));
+    }
+
+    /** ************************************************************************************************
+    * @brief        Serve the metrics in the Prometheus text format on the given local port.
+    *
+    * @details      The exporter only listens on the loopback interface and answers GET requests on
+    *               "/metrics". It exposes the request, error and byte counters and the latency
+    *               histograms of each endpoint, the requests queued and in flight, retries, throttling,
+    *               token refreshes and cache usage. A port of 0 stops the exporter.
+    ***************************************************************************************************/
+    void RequestHandler::setMetricsPort(int port)
+    {
+        QMetaObject::invokeMethod(&m_data->requestHandlerImpl,
+                                  std::bind(&RequestHandlerPrivate::setMetricsPort, &m_data->requestHandlerImpl, port));
+    }
+
+    /** ************************************************************************************************
+    * @brief        Get the number of requests that were merged into an identical request already in
+    *               flight instead of being sent again.
+    ***************************************************************************************************/
+    int RequestHandler::getCoalescedRequestCount() const
+    {
+        return m_data->requestHandlerImpl.getCoalescedRequestCount();
+    }
+
+    /** ************************************************************************************************
+    * @brief        Get the time between queuing a request and receiving its reply for the given lane.
+    ***************************************************************************************************/
+    LatencyStatistics RequestHandler::getLatencyStatistics(RequestLane lane) const
+    {
+        return m_data->requestHandlerImpl.getLatencyStatistics(lane);
+    }
+
+    /** ************************************************************************************************
+    * @brief        Get the number of retries and of requests that failed after their last attempt.
+    ***************************************************************************************************/
+    RetryStatistics RequestHandler::getRetryStatistics(SpotifyApiRequest requestType) const
+    {
+        return m_data->requestHandlerImpl.getRetryStatistics(requestType);
+    }
+
+    /** ************************************************************************************************
+    * @brief        Get the hits, misses, evictions and size of the in-memory catalog cache.
+    ***************************************************************************************************/
+    CacheStatistics RequestHandler::getCatalogMemoryCacheStatistics() const
+    {
+        return m_data->requestHandlerImpl.getCatalogMemoryCacheStatistics();
+    }
+
+    /** ************************************************************************************************
+    * @brief        Get the hits, misses, evictions and size of the cache of decoded album artwork.
+    ***************************************************************************************************/
+    CacheStatistics RequestHandler::getAlbumArtCacheStatistics() const
+    {
+        return m_data->requestHandlerImpl.getAlbumArtCacheStatistics();
+    }
+
+    /** ************************************************************************************************
+    * @brief        Get the request count, errors, bytes received and latency histograms of each request
+    *               type, for each action that sent it.
+    *
+    * @details      The latencies are split into the time spent in the queue (rate limit, throttling,
+    *               background limit), on the network and in the processing of the reply, so that a slow
+    *               reply can be attributed to the client, the network or the API.
+    ***************************************************************************************************/
+    std::vector<EndpointMetrics> RequestHandler::getEndpointMetrics() const
+    {
+        return m_data->requestHandlerImpl.getEndpointMetrics();
+    }
+
+    /** ************************************************************************************************
+    * @brief        Get the number of successful and failed refreshes of the access token.
+    ***************************************************************************************************/
+    TokenRefreshStatistics RequestHandler::getTokenRefreshStatistics() const
+    {
+        return m_data->requestHandlerImpl.getTokenRefreshStatistics();
+    }
+
+    /** ************************************************************************************************
+    * @brief        Write the metrics of the worker, for the exporter of a RequestHandlerPool.
+    *
+    * @details      The metrics are read in the thread of the worker, which blocks the calling thread until
+    *               they are written. It must not be called from another worker thread of the pool.
+    ***************************************************************************************************/
+    void RequestHandler::collectMetrics(MetricFamilies &families) const
+    {
+        if (QThread::currentThread() == m_data->requestHandlerThread)
+        {
+            m_data->requestHandlerImpl.collectMetrics(families);
+            return;
+        }
+
+        QMetaObject::invokeMethod(&m_data->requestHandlerImpl,
+                                  std::bind(&RequestHandlerPrivate::collectMetrics,
+                                            &m_data->requestHandlerImpl, std::ref(families)),
+                                  Qt::BlockingQueuedConnection);
+    }
+
     /** ************************************************************************************************
     * @brief        Destructor.
     ***************************************************************************************************/
     RequestHandler::~RequestHandler()
     {
-        m_data->requestHandlerThread.quit();
-        m_data->requestHandlerThread.wait();
+        if (m_data->ownedThread)
+        {
+            m_data->ownedThread->quit();
+            m_data->ownedThread->wait();
+        }
+        else
+        {
+            // The shared thread keeps running: bring the worker back to this thread to destroy it.
+            QMetaObject::invokeMethod(&m_data->requestHandlerImpl,
+                                      std::bind(&RequestHandlerPrivate::shutdown,
+                                                &m_data->requestHandlerImpl, QThread::currentThread()),
+                                      Qt::BlockingQueuedConnection);
+        }
     }
 }
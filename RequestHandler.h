@@ -2,13 +2,27 @@
 #define REQUESTHANDLER_H
 
 #include <QObject>
+#include <QImage>
 #include <QScopedPointer>
+#include <QSize>
+#include <QUrl>
 
 #include "models/User.h"
 #include "models/CurrentPlayback.h"
+#include "models/Track.h"
+#include "models/Album.h"
+#include "models/Artist.h"
+#include "RequestStatistics.h"
+#include "RetryPolicy.h"
+#include "SpotifyApiRequest.h"
+
+class QNetworkAccessManager;
+class QThread;
 
 namespace Qtify
 {
+    class MetricFamilies;
+
     /** ************************************************************************************************
     * @class    RequestHandler
     *
@@ -20,30 +34,77 @@ namespace Qtify
         Q_OBJECT
 
         struct RequestHandlerData;
+        friend class RequestHandlerPool;
 
         public:
             explicit RequestHandler(const QString &clientId, const QString &clientSecret, int replyPort, QObject *parent = nullptr);
             ~RequestHandler();
 
+            void prewarmConnections();
             void grant();
             void restoreTokens(const QString &accessToken, const QString &refreshToken);
 
             void getCurrentUserInformation();
             void getCurrentPlayback();
+            void subscribePlayback();
+            void unsubscribePlayback();
+            void getTracks(const QStringList &ids);
+            void getAlbums(const QStringList &ids);
+            void getArtists(const QStringList &ids);
+            void getSavedTracks();
+            void getAlbumTracks(const QString &albumId);
+            void getPlaylistTracks(const QString &playlistId);
+            void getAlbumArt(const Album &album, const QSize &size);
             void resumePlayback();
             void pausePlayback();
             void nextTrack();
             void previousTrack();
             void seek(int positionMs);
 
+            void setServiceUrls(const QUrl &apiUrl, const QUrl &authorizationUrl, const QUrl &tokenUrl);
+            void setRateLimit(double requestsPerSecond, int burst);
+            void setMaxBackgroundRequests(int maxRequests);
+            void setRetryPolicy(SpotifyApiRequest requestType, const RetryPolicy &policy);
+            void setCatalogCache(const QString &path, qint64 maxSize, std::chrono::seconds timeToLive);
+            void setCatalogMemoryCacheSize(int maxSize);
+            void invalidateCatalogObject(const QString &id);
+            void setAlbumArtCacheSize(int maxSize);
+            void setAlbumArtPrefetchSize(const QSize &size);
+            void setMetricsPort(int port);
+
+            int getCoalescedRequestCount() const;
+            LatencyStatistics getLatencyStatistics(RequestLane lane) const;
+            RetryStatistics getRetryStatistics(SpotifyApiRequest requestType) const;
+            CacheStatistics getCatalogMemoryCacheStatistics() const;
+            CacheStatistics getAlbumArtCacheStatistics() const;
+            std::vector<EndpointMetrics> getEndpointMetrics() const;
+            TokenRefreshStatistics getTokenRefreshStatistics() const;
+
         signals:
             void accessGranted(const QString &accessToken, const QString &refreshToken);
             void accessDenied(const QString &error);
             void tokenRefreshed(const QString &refreshToken);
             void userDataAvailable(const User &user);
             void currentPlaybackUpdated(const CurrentPlayback &playback);
+            void tracksAvailable(const std::vector<Track> &tracks);
+            void albumsAvailable(const std::vector<Album> &albums);
+            void artistsAvailable(const std::vector<Artist> &artists);
+            void savedTracksPageAvailable(int offset, int total, const std::vector<Track> &tracks);
+            void albumTracksPageAvailable(const QString &albumId, int offset, int total, const std::vector<Track> &tracks);
+            void playlistTracksPageAvailable(const QString &playlistId, int offset, int total, const std::vector<Track> &tracks);
+            void savedTracksFetchFinished(bool success);
+            void albumTracksFetchFinished(const QString &albumId, bool success);
+            void playlistTracksFetchFinished(const QString &playlistId, bool success);
+            void albumArtAvailable(const QString &albumId, const QSize &size, const QImage &image);
+            void schedulerStatusChanged(int queuedRequests, qint64 throttledMilliseconds);
 
         private:
+            RequestHandler(const QString &clientId, const QString &clientSecret, int replyPort,
+                           QThread *thread, QNetworkAccessManager *networkAccessManager, QObject *parent);
+            RequestHandler(RequestHandlerData *data, QObject *parent);
+
+            void collectMetrics(MetricFamilies &families) const;
+
             QScopedPointer<RequestHandlerData> m_data;
     };
 }
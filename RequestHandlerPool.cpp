@@ -0,0 +1,166 @@
+#include "RequestHandlerPool.h"
+
+#include <QNetworkAccessManager>
+#include <QPointer>
+#include <QThread>
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include "private/MetricsExporter.h"
+
+namespace Qtify
+{
+    struct RequestHandlerPool::RequestHandlerPoolData
+    {
+        struct Worker
+        {
+            // The thread shared by the handlers assigned to this worker.
+            QThread thread;
+            // The network access manager shared by these handlers. It lives in the thread.
+            std::unique_ptr<QNetworkAccessManager> networkAccessManager;
+        };
+
+        struct Account
+        {
+            QPointer<RequestHandler> requestHandler;
+            // Value of the "account" label of the metrics of the handler.
+            QString name;
+        };
+
+        std::vector<std::unique_ptr<Worker>> workers;
+        // Worker to which the next handler is assigned.
+        size_t nextWorker = 0;
+        // Handlers created by the pool, in creation order. Deleted handlers are dropped when metrics are
+        // collected.
+        std::vector<Account> accounts;
+        // Number of handlers created, used to name the accounts without a name.
+        int createdCount = 0;
+        std::unique_ptr<MetricsExporter> metricsExporter;
+    };
+
+    /** ************************************************************************************************
+    * @brief        Constructor.
+    *
+    * @details      Start the worker threads.
+    *
+    * @param[in]    threadCount: The number of worker threads shared by the handlers.
+    * @param[in]    parent: The QObject parent.
+    ***************************************************************************************************/
+    RequestHandlerPool::RequestHandlerPool(int threadCount, QObject *parent) :
+        QObject(parent),
+        m_data(new RequestHandlerPoolData)
+    {
+        const int count = std::max(threadCount, 1);
+        m_data->workers.reserve(static_cast<size_t>(count));
+
+        for (int i = 0; i < count; ++i)
+        {
+            auto worker = std::make_unique<RequestHandlerPoolData::Worker>();
+            worker->networkAccessManager = std::make_unique<QNetworkAccessManager>();
+            worker->networkAccessManager->moveToThread(&worker->thread);
+            worker->thread.start();
+            m_data->workers.push_back(std::move(worker));
+        }
+    }
+
+    /** ************************************************************************************************
+    * @brief        Destructor.
+    *
+    * @details      The handlers still alive are destroyed before the threads are stopped.
+    ***************************************************************************************************/
+    RequestHandlerPool::~RequestHandlerPool()
+    {
+        m_data->metricsExporter.reset();
+        qDeleteAll(findChildren<RequestHandler*>(QString(), Qt::FindDirectChildrenOnly));
+
+        for (const auto &worker : m_data->workers)
+        {
+            worker->thread.quit();
+            worker->thread.wait();
+        }
+    }
+
+    /** ************************************************************************************************
+    * @brief        Create a handler for an account.
+    *
+    * @details      Handlers are assigned to the worker threads in turn. The handler is a child of the pool
+    *               and can be deleted at any time, but not from a worker thread of the pool.
+    *               The reply port is only opened if grant() is called: handlers restoring saved tokens do
+    *               not listen on any port, so they can all be given the same one.
+    *
+    * @param[in]    clientId: The client ID of the Spotify application.
+    * @param[in]    clientSecret: The client secret of the Spotify application.
+    * @param[in]    replyPort: The port on which the API will send authorization replies.
+    * @param[in]    account: The value of the "account" label of the metrics of the handler. Defaults to the
+    *               number of the handler, in creation order. Several accounts usually share the same
+    *               client ID, so it cannot be used instead.
+    ***************************************************************************************************/
+    RequestHandler *RequestHandlerPool::createRequestHandler(const QString &clientId, const QString &clientSecret, int replyPort,
+                                                             const QString &account)
+    {
+        const auto &worker = m_data->workers[m_data->nextWorker];
+        m_data->nextWorker = (m_data->nextWorker + 1) % m_data->workers.size();
+
+        RequestHandler *requestHandler = new RequestHandler(clientId, clientSecret, replyPort,
+                                                            &worker->thread, worker->networkAccessManager.get(), this);
+
+        m_data->accounts.push_back({requestHandler,
+                                    account.isEmpty() ? QString::number(m_data->createdCount) : account});
+        ++m_data->createdCount;
+
+        return requestHandler;
+    }
+
+    /** ************************************************************************************************
+    * @brief        Get the number of worker threads.
+    ***************************************************************************************************/
+    int RequestHandlerPool::getThreadCount() const
+    {
+        return static_cast<int>(m_data->workers.size());
+    }
+
+    /** ************************************************************************************************
+    * @brief        Serve the metrics of all the handlers in the Prometheus text format on the given local
+    *               port. A port of 0 stops the exporter.
+    *
+    * @details      The metrics are those of RequestHandler::setMetricsPort(), with an "account" label
+    *               added to every sample. Each metric is written once, with the samples of all the
+    *               handlers. The metrics of a handler are read in its worker thread, so the thread of the
+    *               pool waits for each handler while the metrics are built.
+    ***************************************************************************************************/
+    void RequestHandlerPool::setMetricsPort(int port)
+    {
+        if (port <= 0 || port > 65535)
+        {
+            m_data->metricsExporter.reset();
+            return;
+        }
+
+        if (!m_data->metricsExporter)
+        {
+            m_data->metricsExporter = std::make_unique<MetricsExporter>([this]()
+            {
+                auto &accounts = m_data->accounts;
+                accounts.erase(std::remove_if(accounts.begin(), accounts.end(),
+                                              [](const RequestHandlerPoolData::Account &account)
+                                              {
+                                                  return account.requestHandler.isNull();
+                                              }),
+                               accounts.end());
+
+                MetricFamilies families;
+                for (const auto &account : accounts)
+                {
+                    families.setLabels(MetricsExporter::label("account", account.name));
+                    account.requestHandler->collectMetrics(families);
+                }
+
+                return families.toText();
+            }, this);
+        }
+
+        m_data->metricsExporter->listen(static_cast<quint16>(port));
+    }
+}
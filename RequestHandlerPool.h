@@ -0,0 +1,45 @@
+#ifndef REQUESTHANDLERPOOL_H
+#define REQUESTHANDLERPOOL_H
+
+#include <QObject>
+#include <QScopedPointer>
+
+#include "RequestHandler.h"
+
+namespace Qtify
+{
+    /** ************************************************************************************************
+    * @class    RequestHandlerPool
+    *
+    * @brief    Hosts the RequestHandler of many accounts on a fixed number of worker threads.
+    *
+    * @details  A standalone RequestHandler runs its own thread and network access manager. The handlers
+    *           created by a pool share the threads of the pool and one network access manager per
+    *           thread, so connections to the Spotify servers are reused between accounts. Each handler
+    *           still has its own tokens, request queues and signals.
+    *           The pool can serve the metrics of all its handlers on a single port, each sample being
+    *           labelled with the account of its handler.
+    ***************************************************************************************************/
+    class RequestHandlerPool : public QObject
+    {
+        Q_OBJECT
+
+        struct RequestHandlerPoolData;
+
+        public:
+            explicit RequestHandlerPool(int threadCount, QObject *parent = nullptr);
+            ~RequestHandlerPool();
+
+            RequestHandler *createRequestHandler(const QString &clientId, const QString &clientSecret, int replyPort,
+                                                 const QString &account = QString());
+
+            int getThreadCount() const;
+
+            void setMetricsPort(int port);
+
+        private:
+            QScopedPointer<RequestHandlerPoolData> m_data;
+    };
+}
+
+#endif // REQUESTHANDLERPOOL_H
@@ -0,0 +1,136 @@
+#ifndef REQUESTSTATISTICS_H
+#define REQUESTSTATISTICS_H
+
+#include <QtGlobal>
+#include <QMap>
+#include <QString>
+
+#include "SpotifyApiRequest.h"
+
+namespace Qtify
+{
+    /** ************************************************************************************************
+    * @enum     RequestLane
+    *
+    * @brief    Priority classes of the requests sent to the API.
+    *
+    * @details  Interactive requests (playback commands) are always sent before background requests
+    *           (data reads), and the number of concurrent background requests is limited.
+    ***************************************************************************************************/
+    enum RequestLane
+    {
+        RequestLane_Interactive,
+        RequestLane_Background,
+
+        RequestLane_Count, // Number of lanes.
+    };
+
+    /** ************************************************************************************************
+    * @struct   LatencyStatistics
+    *
+    * @brief    Time between queuing a request and receiving its reply.
+    ***************************************************************************************************/
+    struct LatencyStatistics
+    {
+        int    count               = 0; /// Number of replies received.
+        qint64 lastMilliseconds    = 0; /// Latency of the last reply.
+        qint64 averageMilliseconds = 0; /// Average latency.
+        qint64 maximumMilliseconds = 0; /// Maximum latency.
+    };
+
+    /** ************************************************************************************************
+    * @struct   RetryStatistics
+    *
+    * @brief    Retries of requests that failed with a transient error.
+    ***************************************************************************************************/
+    struct RetryStatistics
+    {
+        int retries   = 0; /// Number of times a request was sent again.
+        int exhausted = 0; /// Number of retried requests that still failed after the maximum number of attempts.
+    };
+
+    /** ************************************************************************************************
+    * @struct   CacheStatistics
+    *
+    * @brief    Usage of an in-memory cache: catalog objects or album artwork.
+    ***************************************************************************************************/
+    struct CacheStatistics
+    {
+        int hits       = 0; /// Lookups answered by the cache.
+        int misses     = 0; /// Lookups not found in the cache.
+        int evictions  = 0; /// Objects removed to stay within the budget.
+        int rejections = 0; /// Objects not stored because they are larger than the budget.
+        int count      = 0; /// Number of objects in the cache.
+        int size       = 0; /// Estimated size of the objects in the cache, in bytes.
+        int maxSize    = 0; /// Budget of the cache, in bytes.
+    };
+
+    /** ************************************************************************************************
+    * @struct   TokenRefreshStatistics
+    *
+    * @brief    Outcomes of the refreshes of the access token.
+    ***************************************************************************************************/
+    struct TokenRefreshStatistics
+    {
+        int successes = 0; /// Number of new access tokens received.
+        int failures  = 0; /// Number of refresh requests that failed.
+    };
+
+    /// Upper bounds of the buckets of a LatencyHistogram, in microseconds. A last bucket counts the
+    /// longer durations.
+    const qint64 LATENCY_HISTOGRAM_BOUNDS[]
+    {
+        100, 250, 500, 1000, 2500, 5000, 10000, 25000, 50000,
+        100000, 250000, 500000, 1000000, 2500000, 5000000, 10000000,
+    };
+    const int LATENCY_HISTOGRAM_BUCKET_COUNT{sizeof(LATENCY_HISTOGRAM_BOUNDS) / sizeof(LATENCY_HISTOGRAM_BOUNDS[0]) + 1};
+
+    /** ************************************************************************************************
+    * @struct   LatencyHistogram
+    *
+    * @brief    Distribution of durations in the buckets bounded by LATENCY_HISTOGRAM_BOUNDS.
+    ***************************************************************************************************/
+    struct LatencyHistogram
+    {
+        int    count             = 0;  /// Number of durations recorded.
+        qint64 totalMicroseconds = 0;  /// Sum of the durations.
+        int    buckets[LATENCY_HISTOGRAM_BUCKET_COUNT] = {}; /// Number of durations in each bucket.
+
+        void record(qint64 microseconds)
+        {
+            int bucket = 0;
+            while (bucket < LATENCY_HISTOGRAM_BUCKET_COUNT - 1 && microseconds > LATENCY_HISTOGRAM_BOUNDS[bucket])
+            {
+                ++bucket;
+            }
+
+            ++buckets[bucket];
+            ++count;
+            totalMicroseconds += microseconds;
+        }
+    };
+
+    /** ************************************************************************************************
+    * @struct   EndpointMetrics
+    *
+    * @brief    Activity of one request type sent for one action.
+    *
+    * @details  Every reply is counted, including the ones of requests sent again after a throttling, a
+    *           token refresh or a transient error.
+    ***************************************************************************************************/
+    struct EndpointMetrics
+    {
+        SpotifyApiRequest request = SpotifyApiRequest::SpotifyRequest_Count;
+        QString context;               /// Name of the action that sent the request.
+        int requests          = 0;     /// Number of replies received.
+        int errors            = 0;     /// Number of replies with an error.
+        QMap<int, int> errorsByStatus; /// Number of errors by HTTP status, 0 for network errors.
+        qint64 bytesReceived  = 0;     /// Size of the reply bodies.
+        LatencyHistogram queueTime;    /// From the last queuing of the request to sending it.
+        LatencyHistogram networkTime;  /// From sending the request to receiving the reply.
+        LatencyHistogram parseTime;    /// Processing of the reply, JSON parsing included.
+        LatencyHistogram backoffTime;  /// Delay before sending again after a transient error.
+    };
+}
+
+#endif // REQUESTSTATISTICS_H
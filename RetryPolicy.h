@@ -0,0 +1,38 @@
+#ifndef RETRYPOLICY_H
+#define RETRYPOLICY_H
+
+#include <chrono>
+
+#include <QList>
+#include <QNetworkReply>
+
+namespace Qtify
+{
+    /** ************************************************************************************************
+    * @struct   RetryPolicy
+    *
+    * @brief    How a request failing with a transient error is sent again.
+    *
+    * @details  The delay before the retry n (starting at 1) is baseDelay * 2^(n-1), limited to maxDelay,
+    *           and randomly increased or decreased by up to jitter * delay.
+    *           An error is transient if its HTTP status is in retryableStatusCodes or, when there is no
+    *           HTTP status, if the network error is in retryableErrors.
+    ***************************************************************************************************/
+    struct RetryPolicy
+    {
+        int maxAttempts = 3; /// Maximum number of times the request is sent. 1 disables retries.
+        std::chrono::milliseconds baseDelay{500};
+        std::chrono::milliseconds maxDelay{std::chrono::seconds(10)};
+        double jitter = 0.2;
+        QList<int> retryableStatusCodes{500, 502, 503, 504};
+        QList<QNetworkReply::NetworkError> retryableErrors{
+            QNetworkReply::RemoteHostClosedError,
+            QNetworkReply::TimeoutError,
+            QNetworkReply::TemporaryNetworkFailureError,
+            QNetworkReply::NetworkSessionFailedError,
+            QNetworkReply::UnknownNetworkError,
+        };
+    };
+}
+
+#endif // RETRYPOLICY_H
@@ -0,0 +1,31 @@
+#ifndef SPOTIFYAPIREQUEST_H
+#define SPOTIFYAPIREQUEST_H
+
+namespace Qtify
+{
+    /** ************************************************************************************************
+    * @enum     SpotifyApiRequest
+    *
+    * @brief    List of requests the API can handle.
+    ***************************************************************************************************/
+    enum class SpotifyApiRequest
+    {
+        SpotifyRequest_UserInformation, /// Data of the user currently logged in.
+        SpotifyRequest_CurrentPlayback, /// Current Spotify client playback.
+        SpotifyRequest_PausePlayback,   /// Pause current Spotify client playback.
+        SpotifyRequest_ResumePlayback,  /// Resume current Spotify client playback.
+        SpotifyRequest_NextTrack,       /// Go to the next track.
+        SpotifyRequest_PreviousTrack,   /// Go to the previous track.
+        SpotifyRequest_Seek,            /// Go to a position in the current track.
+        SpotifyRequest_Tracks,          /// Several tracks by id.
+        SpotifyRequest_Albums,          /// Several albums by id.
+        SpotifyRequest_Artists,         /// Several artists by id.
+        SpotifyRequest_SavedTracks,     /// Tracks saved in the library of the user (paginated).
+        SpotifyRequest_AlbumTracks,     /// Tracks of an album (paginated).
+        SpotifyRequest_PlaylistTracks,  /// Tracks of a playlist (paginated).
+
+        SpotifyRequest_Count /// Number of available request types.
+    };
+}
+
+#endif // SPOTIFYAPIREQUEST_H
@@ -1,8 +1,11 @@
 #include "Album.h"
 
 #include <QMap>
-#include <QJsonArray>
-#include <QVariant>
+
+#include "JsonReader.h"
+#include "Lazy.h"
+#include "Serialization.h"
+#include "StringPool.h"
 
 namespace Qtify
 {
@@ -31,94 +34,246 @@ namespace Qtify
         {"day"  , ReleaseDataPrecision_Day   },
     };
 
+    class AlbumData : public QSharedData
+    {
+        public:
+            AlbumData(const QJsonObject &json):
+                album_group(ALBUMGROUP_STRINGS.value(json["album_group"].toString(), AlbumGroup_Unknown)),
+                album_type(ALBUMTYPE_STRINGS.value(json["album_type"].toString(), AlbumType_Unknown)),
+                artists(json["artists"], &decodeArray<Artist>),
+                available_markets(json["available_markets"].toArray()),
+                external_urls(json["external_urls"].toObject()),
+                href(StringPool::intern(json["href"].toString())),
+                id(StringPool::intern(json["id"].toString())),
+                images(json["images"], &decodeArray<Image>),
+                name(json["name"].toString()),
+                release_date(json["release_date"].toString()),
+                release_date_precision(RELEASEDATEPRECISION_STRINGS.value(json["release_date_precision"].toString(), ReleaseDataPrecision_Unknown)),
+                restrictions(json["restrictions"].toObject()),
+                uri(StringPool::intern(json["uri"].toString()))
+            {
+
+            }
+
+            AlbumData(QDataStream &stream):
+                album_group(Serialization::readEnum(stream, AlbumGroup_Unknown)),
+                album_type(Serialization::readEnum(stream, AlbumType_Unknown)),
+                artists(Serialization::readVector<Artist>(stream)),
+                available_markets(stream),
+                external_urls(stream),
+                href(StringPool::intern(Serialization::readString(stream))),
+                id(StringPool::intern(Serialization::readString(stream))),
+                images(Serialization::readVector<Image>(stream)),
+                name(Serialization::readString(stream)),
+                release_date(Serialization::readString(stream)),
+                release_date_precision(Serialization::readEnum(stream, ReleaseDataPrecision_Unknown)),
+                restrictions(stream),
+                uri(StringPool::intern(Serialization::readString(stream)))
+            {
+
+            }
+
+            AlbumData(JsonReader &reader):
+                AlbumData(QJsonObject())
+            {
+                if (reader.enterObject())
+                {
+                    while (reader.nextKey())
+                    {
+                        if (reader.isKey("album_group"))
+                        {
+                            album_group = ALBUMGROUP_STRINGS.value(reader.readString(), AlbumGroup_Unknown);
+                        }
+                        else if (reader.isKey("album_type"))
+                        {
+                            album_type = ALBUMTYPE_STRINGS.value(reader.readString(), AlbumType_Unknown);
+                        }
+                        else if (reader.isKey("artists"))
+                        {
+                            artists.set(readArray<Artist>(reader));
+                        }
+                        else if (reader.isKey("available_markets"))
+                        {
+                            available_markets = Markets(reader);
+                        }
+                        else if (reader.isKey("external_urls"))
+                        {
+                            external_urls = ExternalUrl(reader);
+                        }
+                        else if (reader.isKey("href"))
+                        {
+                            href = StringPool::intern(reader.readString());
+                        }
+                        else if (reader.isKey("id"))
+                        {
+                            id = StringPool::intern(reader.readString());
+                        }
+                        else if (reader.isKey("images"))
+                        {
+                            images.set(readArray<Image>(reader));
+                        }
+                        else if (reader.isKey("name"))
+                        {
+                            name = reader.readString();
+                        }
+                        else if (reader.isKey("release_date"))
+                        {
+                            release_date = reader.readString();
+                        }
+                        else if (reader.isKey("release_date_precision"))
+                        {
+                            release_date_precision = RELEASEDATEPRECISION_STRINGS.value(reader.readString(), ReleaseDataPrecision_Unknown);
+                        }
+                        else if (reader.isKey("restrictions"))
+                        {
+                            restrictions = Restrictions(reader);
+                        }
+                        else if (reader.isKey("uri"))
+                        {
+                            uri = StringPool::intern(reader.readString());
+                        }
+                        else
+                        {
+                            reader.skipValue();
+                        }
+                    }
+                }
+            }
+
+            AlbumGroup album_group;
+            AlbumType  album_type;
+            Lazy<std::vector<Artist>> artists; // Need to use std::vector because QVector doesn't support emplace_back
+            Markets available_markets;
+            ExternalUrl external_urls;
+            QString href;
+            QString id;
+            Lazy<std::vector<Image>> images; // Need to use std::vector because QVector doesn't support emplace_back
+            QString name;
+            QString release_date;
+            ReleaseDatePrecision release_date_precision;
+            Restrictions restrictions;
+            QString uri;
+    };
+
+    Album::Album():
+        d(new AlbumData(QJsonObject()))
+    {
+
+    }
+
     Album::Album(const QJsonObject &json):
-        album_group(ALBUMGROUP_STRINGS.value(json["album_group"].toString(), AlbumGroup_Unknown)),
-        album_type(ALBUMTYPE_STRINGS.value(json["album_type"].toString(), AlbumType_Unknown)),
-        available_markets(json["available_markets"].toVariant().toStringList()),
-        external_urls(json["external_urls"].toObject()),
-        href(json["href"].toString()),
-        id(json["id"].toString()),
-        name(json["name"].toString()),
-        release_date(json["release_date"].toString()),
-        release_date_precision(RELEASEDATEPRECISION_STRINGS.value(json["release_date_precision"].toString(), ReleaseDataPrecision_Unknown)),
-        restrictions(json["restrictions"].toObject()),
-        uri(json["uri"].toString())
-    {
-        auto jsonArtists = json["artists"].toArray();
-        for (const auto &jsonArtist : jsonArtists)
-        {
-            artists.emplace_back(jsonArtist.toObject());
-        }
-
-        auto jsonImages = json["images"].toArray();
-        for (const auto &jsonImage : jsonImages)
-        {
-            images.emplace_back(jsonImage.toObject());
-        }
+        d(new AlbumData(json))
+    {
+
+    }
+
+    Album::Album(QDataStream &stream):
+        d(new AlbumData(stream))
+    {
+
+    }
+
+    Album::Album(JsonReader &reader):
+        d(new AlbumData(reader))
+    {
+
+    }
+
+    Album::Album(const Album &other) = default;
+    Album::Album(Album &&other) noexcept = default;
+    Album::~Album() = default;
+    Album &Album::operator=(const Album &other) = default;
+    Album &Album::operator=(Album &&other) noexcept = default;
+
+    void Album::serialize(QDataStream &stream) const
+    {
+        stream << static_cast<qint32>(d->album_group);
+        stream << static_cast<qint32>(d->album_type);
+        Serialization::writeVector(stream, d->artists.get());
+        d->available_markets.serialize(stream);
+        d->external_urls.serialize(stream);
+        Serialization::writeString(stream, d->href);
+        Serialization::writeString(stream, d->id);
+        Serialization::writeVector(stream, d->images.get());
+        Serialization::writeString(stream, d->name);
+        Serialization::writeString(stream, d->release_date);
+        stream << static_cast<qint32>(d->release_date_precision);
+        d->restrictions.serialize(stream);
+        Serialization::writeString(stream, d->uri);
     }
 
     AlbumGroup Album::getAlbumGroup() const
     {
-        return album_group;
+        return d->album_group;
     }
 
     AlbumType Album::getAlbumType() const
     {
-        return album_type;
+        return d->album_type;
     }
 
     const std::vector<Artist> &Album::getArtists() const
     {
-        return artists;
+        return d->artists.get();
+    }
+
+    const Markets &Album::getMarkets() const
+    {
+        return d->available_markets;
+    }
+
+    QStringList Album::getAvailableMarkets() const
+    {
+        return d->available_markets.toStringList();
     }
 
-    const QStringList &Album::getAvailableMarkets() const
+    bool Album::isAvailableIn(const QString &market) const
     {
-        return available_markets;
+        return d->available_markets.isAvailableIn(market);
     }
 
     const ExternalUrl &Album::getExternalUrl() const
     {
-        return external_urls;
+        return d->external_urls;
     }
 
     const QString &Album::getApiEndPoint() const
     {
-        return href;
+        return d->href;
     }
 
     const QString &Album::getId() const
     {
-        return id;
+        return d->id;
     }
 
     const std::vector<Image> &Album::getImages() const
     {
-        return images;
+        return d->images.get();
     }
 
     const QString &Album::getName() const
     {
-        return name;
+        return d->name;
     }
 
     const QString &Album::getReleaseDate() const
     {
-        return release_date;
+        return d->release_date;
     }
 
     ReleaseDatePrecision Album::getReleaseDatePrecision() const
     {
-        return release_date_precision;
+        return d->release_date_precision;
     }
 
     const Restrictions &Album::getRestrictions() const
     {
-        return restrictions;
+        return d->restrictions;
     }
 
     const QString &Album::getUri() const
     {
-        return uri;
+        return d->uri;
     }
 }
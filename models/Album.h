@@ -4,12 +4,15 @@
 #include <vector>
 
 #include <QStringList>
+#include <QMetaType>
+#include <QSharedDataPointer>
 
 #include "ExternalUrl.h"
 #include "ExternalId.h"
 #include "Artist.h"
 #include "Image.h"
 #include "Restrictions.h"
+#include "Markets.h"
 
 namespace Qtify
 {
@@ -38,6 +41,9 @@ namespace Qtify
         ReleaseDataPrecision_Unknown,
     };
 
+    class JsonReader;
+    class AlbumData;
+
     /** ************************************************************************************************
     * @class    Album
     *
@@ -45,16 +51,33 @@ namespace Qtify
     *
     * @details  More info on
     *           https://developer.spotify.com/documentation/web-api/reference/object-model/#album-object-simplified
+    *           Artists and images are only decoded when first requested. Markets are decoded at once into a
+    *           small bitmap, so that the JSON array is not kept. An album built with a JsonReader decodes all
+    *           its members at once, as no JSON is kept.
+    *           The data is implicitly shared: copies are cheap.
     ***************************************************************************************************/
     class Album
     {
         public:
+            Album();
             Album(const QJsonObject &json);
+            explicit Album(QDataStream &stream);
+            explicit Album(JsonReader &reader);
+            Album(const Album &other);
+            Album(Album &&other) noexcept;
+            ~Album();
+
+            Album &operator=(const Album &other);
+            Album &operator=(Album &&other) noexcept;
+
+            void serialize(QDataStream &stream) const;
 
             AlbumGroup getAlbumGroup() const;
             AlbumType  getAlbumType() const;
             const std::vector<Artist> &getArtists() const;
-            const QStringList &getAvailableMarkets() const;
+            const Markets &getMarkets() const;
+            QStringList getAvailableMarkets() const;
+            bool isAvailableIn(const QString &market) const;
             const ExternalUrl &getExternalUrl() const;
             const QString &getApiEndPoint() const;
             const QString &getId() const;
@@ -66,21 +89,12 @@ namespace Qtify
             const QString &getUri() const;
 
         private:
-            AlbumGroup album_group;
-            AlbumType  album_type;
-            std::vector<Artist> artists; // Need to use std::vector because QVector doesn't support emplace_back
-            QStringList available_markets;
-            ExternalUrl external_urls;
-            QString href;
-            QString id;
-            std::vector<Image> images; // Need to use std::vector because QVector doesn't support emplace_back
-            QString name;
-            QString release_date;
-            ReleaseDatePrecision release_date_precision;
-            Restrictions restrictions;
-            QString uri;
+            QSharedDataPointer<AlbumData> d;
     };
 
 }
 
+Q_DECLARE_METATYPE(Qtify::Album)
+Q_DECLARE_METATYPE(std::vector<Qtify::Album>)
+
 #endif // ALBUM_H
@@ -1,39 +1,137 @@
 #include "Artist.h"
 
+#include "JsonReader.h"
+#include "Serialization.h"
+#include "StringPool.h"
+
 namespace Qtify
 {
+    class ArtistData : public QSharedData
+    {
+        public:
+            ArtistData(const QJsonObject &json):
+                external_urls(json["external_urls"].toObject()),
+                href(StringPool::intern(json["href"].toString())),
+                id(StringPool::intern(json["id"].toString())),
+                name(json["name"].toString()),
+                uri(StringPool::intern(json["uri"].toString()))
+            {
+
+            }
+
+            ArtistData(QDataStream &stream):
+                external_urls(stream),
+                href(StringPool::intern(Serialization::readString(stream))),
+                id(StringPool::intern(Serialization::readString(stream))),
+                name(Serialization::readString(stream)),
+                uri(StringPool::intern(Serialization::readString(stream)))
+            {
+
+            }
+
+            ArtistData(JsonReader &reader):
+                ArtistData(QJsonObject())
+            {
+                if (reader.enterObject())
+                {
+                    while (reader.nextKey())
+                    {
+                        if (reader.isKey("external_urls"))
+                        {
+                            external_urls = ExternalUrl(reader);
+                        }
+                        else if (reader.isKey("href"))
+                        {
+                            href = StringPool::intern(reader.readString());
+                        }
+                        else if (reader.isKey("id"))
+                        {
+                            id = StringPool::intern(reader.readString());
+                        }
+                        else if (reader.isKey("name"))
+                        {
+                            name = reader.readString();
+                        }
+                        else if (reader.isKey("uri"))
+                        {
+                            uri = StringPool::intern(reader.readString());
+                        }
+                        else
+                        {
+                            reader.skipValue();
+                        }
+                    }
+                }
+            }
+
+            ExternalUrl external_urls;
+            QString href;
+            QString id;
+            QString name;
+            QString uri;
+    };
+
+    Artist::Artist():
+        d(new ArtistData(QJsonObject()))
+    {
+
+    }
+
     Artist::Artist(const QJsonObject &json):
-        external_urls(json["external_urls"].toObject()),
-        href(json["href"].toString()),
-        id(json["id"].toString()),
-        name(json["name"].toString()),
-        uri(json["uri"].toString())
+        d(new ArtistData(json))
     {
 
     }
 
+    Artist::Artist(QDataStream &stream):
+        d(new ArtistData(stream))
+    {
+
+    }
+
+    Artist::Artist(JsonReader &reader):
+        d(new ArtistData(reader))
+    {
+
+    }
+
+    Artist::Artist(const Artist &other) = default;
+    Artist::Artist(Artist &&other) noexcept = default;
+    Artist::~Artist() = default;
+    Artist &Artist::operator=(const Artist &other) = default;
+    Artist &Artist::operator=(Artist &&other) noexcept = default;
+
+    void Artist::serialize(QDataStream &stream) const
+    {
+        d->external_urls.serialize(stream);
+        Serialization::writeString(stream, d->href);
+        Serialization::writeString(stream, d->id);
+        Serialization::writeString(stream, d->name);
+        Serialization::writeString(stream, d->uri);
+    }
+
     const ExternalUrl &Artist::getExternalUrl() const
     {
-        return external_urls;
+        return d->external_urls;
     }
 
     const QString &Artist::getApiEndPoint() const
     {
-        return href;
+        return d->href;
     }
 
     const QString &Artist::getId() const
     {
-        return id;
+        return d->id;
     }
 
     const QString &Artist::getName() const
     {
-        return name;
+        return d->name;
     }
 
     const QString &Artist::getUri() const
     {
-        return uri;
+        return d->uri;
     }
 }
@@ -1,10 +1,18 @@
 #ifndef ARTIST_H
 #define ARTIST_H
 
+#include <vector>
+
+#include <QMetaType>
+#include <QSharedDataPointer>
+
 #include "ExternalUrl.h"
 
 namespace Qtify
 {
+    class JsonReader;
+    class ArtistData;
+
     /** ************************************************************************************************
     * @class    Artist
     *
@@ -12,11 +20,23 @@ namespace Qtify
     *
     * @details  More info on
     *           https://developer.spotify.com/documentation/web-api/reference/object-model/#artist-object-simplified
+    *           The data is implicitly shared: copies are cheap.
     ***************************************************************************************************/
     class Artist
     {
         public:
+            Artist();
             Artist(const QJsonObject &json);
+            explicit Artist(QDataStream &stream);
+            explicit Artist(JsonReader &reader);
+            Artist(const Artist &other);
+            Artist(Artist &&other) noexcept;
+            ~Artist();
+
+            Artist &operator=(const Artist &other);
+            Artist &operator=(Artist &&other) noexcept;
+
+            void serialize(QDataStream &stream) const;
 
             const ExternalUrl &getExternalUrl() const;
             const QString &getApiEndPoint() const;
@@ -25,12 +45,11 @@ namespace Qtify
             const QString &getUri() const;
 
         private:
-            ExternalUrl external_urls;
-            QString href;
-            QString id;
-            QString name;
-            QString uri;
+            QSharedDataPointer<ArtistData> d;
     };
 }
 
+Q_DECLARE_METATYPE(Qtify::Artist)
+Q_DECLARE_METATYPE(std::vector<Qtify::Artist>)
+
 #endif // ARTIST_H
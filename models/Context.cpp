@@ -2,6 +2,10 @@
 
 #include <QMap>
 
+#include "JsonReader.h"
+#include "Serialization.h"
+#include "StringPool.h"
+
 namespace Qtify
 {
     // To convert a string to a ContextType.
@@ -12,32 +16,113 @@ namespace Qtify
         {"playlist", Context_Playlist },
     };
 
+    class ContextData : public QSharedData
+    {
+        public:
+            ContextData(const QJsonObject &json):
+                uri(StringPool::intern(json["uri"].toString())),
+                href(StringPool::intern(json["href"].toString())),
+                external_urls(json["external_urls"].toObject()),
+                type(CONTEXT_TYPE_STRINGS.value(json["type"].toString(), Context_Unknown))
+            {
+
+            }
+
+            ContextData(QDataStream &stream):
+                uri(StringPool::intern(Serialization::readString(stream))),
+                href(StringPool::intern(Serialization::readString(stream))),
+                external_urls(stream),
+                type(Serialization::readEnum(stream, Context_Unknown))
+            {
+
+            }
+
+            ContextData(JsonReader &reader):
+                ContextData(QJsonObject())
+            {
+                if (reader.enterObject())
+                {
+                    while (reader.nextKey())
+                    {
+                        if (reader.isKey("uri"))
+                        {
+                            uri = StringPool::intern(reader.readString());
+                        }
+                        else if (reader.isKey("href"))
+                        {
+                            href = StringPool::intern(reader.readString());
+                        }
+                        else if (reader.isKey("external_urls"))
+                        {
+                            external_urls = ExternalUrl(reader);
+                        }
+                        else if (reader.isKey("type"))
+                        {
+                            type = CONTEXT_TYPE_STRINGS.value(reader.readString(), Context_Unknown);
+                        }
+                        else
+                        {
+                            reader.skipValue();
+                        }
+                    }
+                }
+            }
+
+            QString uri;
+            QString href;
+            ExternalUrl external_urls;
+            ContextType type;
+    };
+
     Context::Context(const QJsonObject &json):
-        uri(json["uri"].toString()),
-        href(json["href"].toString()),
-        external_urls(json["external_urls"].toObject()),
-        type(CONTEXT_TYPE_STRINGS.value(json["type"].toString(), Context_Unknown))
+        d(new ContextData(json))
     {
 
     }
 
+    Context::Context(QDataStream &stream):
+        d(new ContextData(stream))
+    {
+
+    }
+
+    Context::Context(JsonReader &reader):
+        d(new ContextData(reader))
+    {
+
+    }
+
+    Context::Context(const Context &other) = default;
+    Context::Context(Context &&other) noexcept = default;
+    Context::~Context() = default;
+    Context &Context::operator=(const Context &other) = default;
+    Context &Context::operator=(Context &&other) noexcept = default;
+
+    void Context::serialize(QDataStream &stream) const
+    {
+        Serialization::writeString(stream, d->uri);
+        Serialization::writeString(stream, d->href);
+        d->external_urls.serialize(stream);
+        stream << static_cast<qint32>(d->type);
+    }
+
     const QString &Qtify::Context::getUri() const
     {
-        return uri;
+        return d->uri;
     }
 
     const QString &Qtify::Context::getHref() const
     {
-        return href;
+        return d->href;
     }
 
     const Qtify::ExternalUrl &Qtify::Context::getExternalUrl() const
     {
-        return external_urls;
+        return d->external_urls;
     }
 
     Qtify::ContextType Qtify::Context::getType() const
     {
-        return type;
+        return d->type;
     }
 }
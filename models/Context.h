@@ -2,6 +2,7 @@
 #define CONTEXT_H
 
 #include <QString>
+#include <QSharedDataPointer>
 
 #include "ExternalUrl.h"
 
@@ -15,6 +16,9 @@ namespace Qtify
         Context_Unknown,
     };
 
+    class JsonReader;
+    class ContextData;
+
     /** ************************************************************************************************
     * @class    Context
     *
@@ -22,11 +26,22 @@ namespace Qtify
     *
     * @details  More info on
     *           https://developer.spotify.com/documentation/web-api/reference/object-model/#context-object
+    *           The data is implicitly shared: copies are cheap.
     ***************************************************************************************************/
     class Context
     {
         public:
             Context(const QJsonObject &json);
+            explicit Context(QDataStream &stream);
+            explicit Context(JsonReader &reader);
+            Context(const Context &other);
+            Context(Context &&other) noexcept;
+            ~Context();
+
+            Context &operator=(const Context &other);
+            Context &operator=(Context &&other) noexcept;
+
+            void serialize(QDataStream &stream) const;
 
             const QString &getUri() const;
             const QString &getHref() const;
@@ -34,10 +49,7 @@ namespace Qtify
             ContextType getType() const;
 
         private:
-            QString uri;
-            QString href;
-            ExternalUrl external_urls;
-            ContextType type;
+            QSharedDataPointer<ContextData> d;
     };
 
 }
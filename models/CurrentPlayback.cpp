@@ -1,5 +1,8 @@
 #include "CurrentPlayback.h"
 
+#include "JsonReader.h"
+#include "Serialization.h"
+
 #include <QMap>
 
 namespace Qtify
@@ -21,62 +24,184 @@ namespace Qtify
         {"context", Repeat_Context }
     };
 
+    class CurrentPlaybackData : public QSharedData
+    {
+        public:
+            CurrentPlaybackData(const QJsonObject &json):
+                device(json["device"].toObject()),
+                repeat_state(REPEAT_TYPE_STRINGS.value(json["repeat_state"].toString(), Repeat_Unknown)),
+                shuffle_state(json["shuffle_state"].toBool(false)),
+                context(json["context"].toObject()),
+                timestamp(json["timestamp"].toInt(0)),
+                progress_ms(json["progress_ms"].toInt(0)),
+                is_playing(json["is_playing"].toBool(false)),
+                item(json["item"].toObject()),
+                currently_playing_type(PLAYING_TYPE_STRINGS.value(json["currently_playing_type"].toString(), Type_Unknown))
+            {
+
+            }
+
+            CurrentPlaybackData(QDataStream &stream):
+                device(stream),
+                repeat_state(Serialization::readEnum(stream, Repeat_Unknown)),
+                shuffle_state(Serialization::readValue<bool>(stream)),
+                context(stream),
+                timestamp(Serialization::readValue<qint32>(stream)),
+                progress_ms(Serialization::readValue<qint32>(stream)),
+                is_playing(Serialization::readValue<bool>(stream)),
+                item(stream),
+                currently_playing_type(Serialization::readEnum(stream, Type_Unknown))
+            {
+
+            }
+
+            CurrentPlaybackData(JsonReader &reader):
+                CurrentPlaybackData(QJsonObject())
+            {
+                if (reader.enterObject())
+                {
+                    while (reader.nextKey())
+                    {
+                        if (reader.isKey("device"))
+                        {
+                            device = Device(reader);
+                        }
+                        else if (reader.isKey("repeat_state"))
+                        {
+                            repeat_state = REPEAT_TYPE_STRINGS.value(reader.readString(), Repeat_Unknown);
+                        }
+                        else if (reader.isKey("shuffle_state"))
+                        {
+                            shuffle_state = reader.readBool(false);
+                        }
+                        else if (reader.isKey("context"))
+                        {
+                            context = Context(reader);
+                        }
+                        else if (reader.isKey("timestamp"))
+                        {
+                            timestamp = reader.readInt(0);
+                        }
+                        else if (reader.isKey("progress_ms"))
+                        {
+                            progress_ms = reader.readInt(0);
+                        }
+                        else if (reader.isKey("is_playing"))
+                        {
+                            is_playing = reader.readBool(false);
+                        }
+                        else if (reader.isKey("item"))
+                        {
+                            item = Track(reader);
+                        }
+                        else if (reader.isKey("currently_playing_type"))
+                        {
+                            currently_playing_type = PLAYING_TYPE_STRINGS.value(reader.readString(), Type_Unknown);
+                        }
+                        else
+                        {
+                            reader.skipValue();
+                        }
+                    }
+                }
+            }
+
+            Device device;
+            RepeatState repeat_state;
+            bool shuffle_state;
+            Context context;
+            int timestamp;
+            int progress_ms;
+            bool is_playing;
+            Track item;
+            CurrentlyPlayingType currently_playing_type;
+    };
+
+    CurrentPlayback::CurrentPlayback():
+        d(new CurrentPlaybackData(QJsonObject()))
+    {
+
+    }
+
     CurrentPlayback::CurrentPlayback(const QJsonObject &json):
-        device(json["device"].toObject()),
-        repeat_state(REPEAT_TYPE_STRINGS.value(json["repeat_state"].toString(), Repeat_Unknown)),
-        shuffle_state(json["shuffle_state"].toBool(false)),
-        context(json["context"].toObject()),
-        timestamp(json["timestamp"].toInt(0)),
-        progress_ms(json["progress_ms"].toInt(0)),
-        is_playing(json["is_playing"].toBool(false)),
-        item(json["item"].toObject()),
-        currently_playing_type(PLAYING_TYPE_STRINGS.value(json["currently_playing_type"].toString(), Type_Unknown))
+        d(new CurrentPlaybackData(json))
     {
 
     }
 
+    CurrentPlayback::CurrentPlayback(QDataStream &stream):
+        d(new CurrentPlaybackData(stream))
+    {
+
+    }
+
+    CurrentPlayback::CurrentPlayback(JsonReader &reader):
+        d(new CurrentPlaybackData(reader))
+    {
+
+    }
+
+    CurrentPlayback::CurrentPlayback(const CurrentPlayback &other) = default;
+    CurrentPlayback::CurrentPlayback(CurrentPlayback &&other) noexcept = default;
+    CurrentPlayback::~CurrentPlayback() = default;
+    CurrentPlayback &CurrentPlayback::operator=(const CurrentPlayback &other) = default;
+    CurrentPlayback &CurrentPlayback::operator=(CurrentPlayback &&other) noexcept = default;
+
+    void CurrentPlayback::serialize(QDataStream &stream) const
+    {
+        d->device.serialize(stream);
+        stream << static_cast<qint32>(d->repeat_state);
+        stream << d->shuffle_state;
+        d->context.serialize(stream);
+        stream << static_cast<qint32>(d->timestamp);
+        stream << static_cast<qint32>(d->progress_ms);
+        stream << d->is_playing;
+        d->item.serialize(stream);
+        stream << static_cast<qint32>(d->currently_playing_type);
+    }
+
     const Device &CurrentPlayback::getDevice() const
     {
-        return device;
+        return d->device;
     }
 
     RepeatState CurrentPlayback::getRepeatState() const
     {
-        return repeat_state;
+        return d->repeat_state;
     }
 
     bool CurrentPlayback::isShuffleEnabled() const
     {
-        return shuffle_state;
+        return d->shuffle_state;
     }
 
     const Context &CurrentPlayback::getContext() const
     {
-        return context;
+        return d->context;
     }
 
     int CurrentPlayback::getDataTimeStamp() const
     {
-        return timestamp;
+        return d->timestamp;
     }
 
     int CurrentPlayback::getProgressMilliseconds() const
     {
-        return progress_ms;
+        return d->progress_ms;
     }
 
     bool CurrentPlayback::isPlaying() const
     {
-        return is_playing;
+        return d->is_playing;
     }
 
     const Track &CurrentPlayback::getTrack() const
     {
-        return item;
+        return d->item;
     }
 
     CurrentlyPlayingType CurrentPlayback::getCurrentlyPlayingType() const
     {
-        return currently_playing_type;
+        return d->currently_playing_type;
     }
 }
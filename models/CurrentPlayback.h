@@ -2,6 +2,8 @@
 #define CURRENTPLAYBACK_H
 
 #include <QJsonObject>
+#include <QMetaType>
+#include <QSharedDataPointer>
 
 #include "Context.h"
 #include "Track.h"
@@ -25,6 +27,9 @@ namespace Qtify
         Repeat_Unknown,
     };
 
+    class JsonReader;
+    class CurrentPlaybackData;
+
     /** ************************************************************************************************
     * @class    CurrentPlayback
     *
@@ -32,11 +37,25 @@ namespace Qtify
     *
     * @details  More info on
     *           https://developer.spotify.com/documentation/web-api/reference/player/get-the-users-currently-playing-track/
+    *           The data is implicitly shared: copies are cheap.
+    *           The default constructor builds an empty playback. It is only needed for the meta type
+    *           system.
     ***************************************************************************************************/
     class CurrentPlayback
     {
         public:
+            CurrentPlayback();
             CurrentPlayback(const QJsonObject &json);
+            explicit CurrentPlayback(QDataStream &stream);
+            explicit CurrentPlayback(JsonReader &reader);
+            CurrentPlayback(const CurrentPlayback &other);
+            CurrentPlayback(CurrentPlayback &&other) noexcept;
+            ~CurrentPlayback();
+
+            CurrentPlayback &operator=(const CurrentPlayback &other);
+            CurrentPlayback &operator=(CurrentPlayback &&other) noexcept;
+
+            void serialize(QDataStream &stream) const;
 
             const Device &getDevice() const;
             RepeatState getRepeatState() const;
@@ -49,16 +68,10 @@ namespace Qtify
             CurrentlyPlayingType getCurrentlyPlayingType() const;
 
         private:
-            Device device;
-            RepeatState repeat_state;
-            bool shuffle_state;
-            Context context;
-            int timestamp;
-            int progress_ms;
-            bool is_playing;
-            Track item;
-            CurrentlyPlayingType currently_playing_type;
+            QSharedDataPointer<CurrentPlaybackData> d;
     };
 }
 
+Q_DECLARE_METATYPE(Qtify::CurrentPlayback)
+
 #endif // CURRENTPLAYBACK_H
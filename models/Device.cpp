@@ -1,52 +1,157 @@
 #include "Device.h"
 
+#include "JsonReader.h"
+#include "Serialization.h"
+
 namespace Qtify
 {
+    class DeviceData : public QSharedData
+    {
+        public:
+            DeviceData(const QJsonObject &json):
+                id(json["id"].toString()),
+                is_active(json["is_active"].toBool()),
+                is_private_session(json["is_private_session"].toBool()),
+                is_restricted(json["is_restricted"].toBool()),
+                name(json["name"].toString()),
+                type(json["type"].toString()),
+                volume_percent(json["volume_percent"].toInt())
+            {
+
+            }
+
+            DeviceData(QDataStream &stream):
+                id(Serialization::readString(stream)),
+                is_active(Serialization::readValue<bool>(stream)),
+                is_private_session(Serialization::readValue<bool>(stream)),
+                is_restricted(Serialization::readValue<bool>(stream)),
+                name(Serialization::readString(stream)),
+                type(Serialization::readString(stream)),
+                volume_percent(Serialization::readValue<qint32>(stream))
+            {
+
+            }
+
+            DeviceData(JsonReader &reader):
+                DeviceData(QJsonObject())
+            {
+                if (reader.enterObject())
+                {
+                    while (reader.nextKey())
+                    {
+                        if (reader.isKey("id"))
+                        {
+                            id = reader.readString();
+                        }
+                        else if (reader.isKey("is_active"))
+                        {
+                            is_active = reader.readBool();
+                        }
+                        else if (reader.isKey("is_private_session"))
+                        {
+                            is_private_session = reader.readBool();
+                        }
+                        else if (reader.isKey("is_restricted"))
+                        {
+                            is_restricted = reader.readBool();
+                        }
+                        else if (reader.isKey("name"))
+                        {
+                            name = reader.readString();
+                        }
+                        else if (reader.isKey("type"))
+                        {
+                            type = reader.readString();
+                        }
+                        else if (reader.isKey("volume_percent"))
+                        {
+                            volume_percent = reader.readInt();
+                        }
+                        else
+                        {
+                            reader.skipValue();
+                        }
+                    }
+                }
+            }
+
+            QString id;
+            bool is_active;
+            bool is_private_session;
+            bool is_restricted;
+            QString name;
+            QString type;
+            int volume_percent;
+    };
+
     Device::Device(const QJsonObject &json):
-        id(json["id"].toString()),
-        is_active(json["is_active"].toBool()),
-        is_private_session(json["is_private_session"].toBool()),
-        is_restricted(json["is_restricted"].toBool()),
-        name(json["name"].toString()),
-        type(json["type"].toString()),
-        volume_percent(json["volume_percent"].toInt())
+        d(new DeviceData(json))
+    {
+
+    }
+
+    Device::Device(QDataStream &stream):
+        d(new DeviceData(stream))
+    {
+
+    }
+
+    Device::Device(JsonReader &reader):
+        d(new DeviceData(reader))
     {
 
     }
 
+    Device::Device(const Device &other) = default;
+    Device::Device(Device &&other) noexcept = default;
+    Device::~Device() = default;
+    Device &Device::operator=(const Device &other) = default;
+    Device &Device::operator=(Device &&other) noexcept = default;
+
+    void Device::serialize(QDataStream &stream) const
+    {
+        Serialization::writeString(stream, d->id);
+        stream << d->is_active;
+        stream << d->is_private_session;
+        stream << d->is_restricted;
+        Serialization::writeString(stream, d->name);
+        Serialization::writeString(stream, d->type);
+        stream << static_cast<qint32>(d->volume_percent);
+    }
+
     const QString &Device::getId() const
     {
-        return id;
+        return d->id;
     }
 
     bool Device::isActive() const
     {
-        return is_active;
+        return d->is_active;
     }
 
     bool Device::isPrivateSession() const
     {
-        return is_private_session;
+        return d->is_private_session;
     }
 
     bool Device::isRestricted() const
     {
-        return is_restricted;
+        return d->is_restricted;
     }
 
     const QString &Device::getName() const
     {
-        return name;
+        return d->name;
     }
 
     const QString &Device::getType() const
     {
-        return type;
+        return d->type;
     }
 
     int Device::getVolumePercent() const
     {
-        return volume_percent;
+        return d->volume_percent;
     }
 
 }
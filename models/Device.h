@@ -1,10 +1,15 @@
 #ifndef DEVICE_H
 #define DEVICE_H
 
+#include <QDataStream>
 #include <QJsonObject>
+#include <QSharedDataPointer>
 
 namespace Qtify
 {
+    class JsonReader;
+    class DeviceData;
+
     /** ************************************************************************************************
     * @class    Device
     *
@@ -12,11 +17,22 @@ namespace Qtify
     *
     * @details  More info on
     *           https://developer.spotify.com/documentation/web-api/reference/player/get-a-users-available-devices/
+    *           The data is implicitly shared: copies are cheap.
     ***************************************************************************************************/
     class Device
     {
         public:
             Device(const QJsonObject &json);
+            explicit Device(QDataStream &stream);
+            explicit Device(JsonReader &reader);
+            Device(const Device &other);
+            Device(Device &&other) noexcept;
+            ~Device();
+
+            Device &operator=(const Device &other);
+            Device &operator=(Device &&other) noexcept;
+
+            void serialize(QDataStream &stream) const;
 
             const QString &getId() const;
             bool isActive() const;
@@ -27,13 +43,7 @@ namespace Qtify
             int getVolumePercent() const;
 
         private:
-            QString id;
-            bool is_active;
-            bool is_private_session;
-            bool is_restricted;
-            QString name;
-            QString type;
-            int volume_percent;
+            QSharedDataPointer<DeviceData> d;
     };
 }
 
@@ -2,10 +2,13 @@
 #define EXTERNALID_H
 
 #include <QString>
+#include <QDataStream>
 #include <QJsonObject>
 
 namespace Qtify
 {
+    class JsonReader;
+
     /** ************************************************************************************************
     * @class    ExternalId
     *
@@ -18,6 +21,10 @@ namespace Qtify
     {
         public:
             ExternalId(const QJsonObject &json);
+            explicit ExternalId(QDataStream &stream);
+            explicit ExternalId(JsonReader &reader);
+
+            void serialize(QDataStream &stream) const;
 
             const QString &getKey() const;
             const QString &getValue() const;
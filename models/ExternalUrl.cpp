@@ -1,5 +1,8 @@
 #include "ExternalUrl.h"
 
+#include "JsonReader.h"
+#include "Serialization.h"
+
 namespace Qtify
 {
     ExternalUrl::ExternalUrl(const QJsonObject &json)
@@ -12,6 +15,43 @@ namespace Qtify
         }
     }
 
+    ExternalUrl::ExternalUrl(QDataStream &stream):
+        key(Serialization::readString(stream)),
+        value(Serialization::readString(stream))
+    {
+
+    }
+
+    /** ************************************************************************************************
+    * @brief        Read the object like the JSON constructor does: QJsonObject sorts its keys, so the
+    *               smallest key is kept.
+    ***************************************************************************************************/
+    ExternalUrl::ExternalUrl(JsonReader &reader)
+    {
+        if (reader.enterObject())
+        {
+            while (reader.nextKey())
+            {
+                const QString name = reader.key();
+                if (key.isNull() || name < key)
+                {
+                    key   = name;
+                    value = reader.readString();
+                }
+                else
+                {
+                    reader.skipValue();
+                }
+            }
+        }
+    }
+
+    void ExternalUrl::serialize(QDataStream &stream) const
+    {
+        Serialization::writeString(stream, key);
+        Serialization::writeString(stream, value);
+    }
+
     const QString &Qtify::ExternalUrl::getKey() const
     {
         return key;
@@ -2,10 +2,13 @@
 #define EXTERNALURL_H
 
 #include <QString>
+#include <QDataStream>
 #include <QJsonObject>
 
 namespace Qtify
 {
+    class JsonReader;
+
     /** ************************************************************************************************
     * @class    ExternalUrl
     *
@@ -18,6 +21,10 @@ namespace Qtify
     {
         public:
             ExternalUrl(const QJsonObject &json);
+            explicit ExternalUrl(QDataStream &stream);
+            explicit ExternalUrl(JsonReader &reader);
+
+            void serialize(QDataStream &stream) const;
 
             const QString &getKey() const;
             const QString &getValue() const;
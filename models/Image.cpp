@@ -1,27 +1,104 @@
 #include "Image.h"
 
+#include "JsonReader.h"
+#include "Serialization.h"
+
 namespace Qtify
 {
+    class ImageData : public QSharedData
+    {
+        public:
+            ImageData(const QJsonObject &json):
+                height(json["height"].toInt()),
+                url(json["url"].toString()),
+                width(json["width"].toInt())
+            {
+
+            }
+
+            ImageData(QDataStream &stream):
+                height(Serialization::readValue<qint32>(stream)),
+                url(Serialization::readString(stream)),
+                width(Serialization::readValue<qint32>(stream))
+            {
+
+            }
+
+            ImageData(JsonReader &reader):
+                ImageData(QJsonObject())
+            {
+                if (reader.enterObject())
+                {
+                    while (reader.nextKey())
+                    {
+                        if (reader.isKey("height"))
+                        {
+                            height = reader.readInt();
+                        }
+                        else if (reader.isKey("url"))
+                        {
+                            url = reader.readString();
+                        }
+                        else if (reader.isKey("width"))
+                        {
+                            width = reader.readInt();
+                        }
+                        else
+                        {
+                            reader.skipValue();
+                        }
+                    }
+                }
+            }
+
+            int height;
+            QString url;
+            int width;
+    };
+
     Image::Image(const QJsonObject &json):
-        height(json["height"].toInt()),
-        url(json["url"].toString()),
-        width(json["width"].toInt())
+        d(new ImageData(json))
+    {
+
+    }
+
+    Image::Image(QDataStream &stream):
+        d(new ImageData(stream))
+    {
+
+    }
+
+    Image::Image(JsonReader &reader):
+        d(new ImageData(reader))
     {
 
     }
 
+    Image::Image(const Image &other) = default;
+    Image::Image(Image &&other) noexcept = default;
+    Image::~Image() = default;
+    Image &Image::operator=(const Image &other) = default;
+    Image &Image::operator=(Image &&other) noexcept = default;
+
+    void Image::serialize(QDataStream &stream) const
+    {
+        stream << static_cast<qint32>(d->height);
+        Serialization::writeString(stream, d->url);
+        stream << static_cast<qint32>(d->width);
+    }
+
     int Image::getHeight() const
     {
-        return height;
+        return d->height;
     }
 
     const QString &Image::getUrl() const
     {
-        return url;
+        return d->url;
     }
 
     int Image::getWidth() const
     {
-        return width;
+        return d->width;
     }
 }
@@ -2,10 +2,15 @@
 #define IMAGE_H
 
 #include <QString>
+#include <QDataStream>
 #include <QJsonObject>
+#include <QSharedDataPointer>
 
 namespace Qtify
 {
+    class JsonReader;
+    class ImageData;
+
     /** ************************************************************************************************
     * @class    Image
     *
@@ -13,20 +18,29 @@ namespace Qtify
     *
     * @details  More info on
     *           https://developer.spotify.com/documentation/web-api/reference/object-model/#image-object
+    *           The data is implicitly shared: copies are cheap.
     ***************************************************************************************************/
     class Image
     {
         public:
             Image(const QJsonObject &json);
+            explicit Image(QDataStream &stream);
+            explicit Image(JsonReader &reader);
+            Image(const Image &other);
+            Image(Image &&other) noexcept;
+            ~Image();
+
+            Image &operator=(const Image &other);
+            Image &operator=(Image &&other) noexcept;
+
+            void serialize(QDataStream &stream) const;
 
             int getHeight() const;
             const QString &getUrl() const;
             int getWidth() const;
 
         private:
-            int height;
-            QString url;
-            int width;
+            QSharedDataPointer<ImageData> d;
     };
 }
 
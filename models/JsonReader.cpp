@@ -0,0 +1,632 @@
+#include "JsonReader.h"
+
+#include <cmath>
+#include <limits>
+
+namespace Qtify
+{
+    namespace
+    {
+        /// Maximum number of nested objects and arrays, like QJsonDocument.
+        const int JSON_MAX_DEPTH{1024};
+        /// Maximum number of digits of an integer accumulated without overflow.
+        const int JSON_MAX_INTEGER_DIGITS{18};
+
+        /** ********************************************************************************************
+        * @brief        Get the value of a hexadecimal digit, -1 if the character is not one.
+        ***********************************************************************************************/
+        int hexadecimalValue(char character)
+        {
+            if (character >= '0' && character <= '9')
+            {
+                return character - '0';
+            }
+            if (character >= 'a' && character <= 'f')
+            {
+                return character - 'a' + 10;
+            }
+            if (character >= 'A' && character <= 'F')
+            {
+                return character - 'A' + 10;
+            }
+            return -1;
+        }
+
+        /** ********************************************************************************************
+        * @brief        Decode the content of a JSON string holding escape sequences.
+        *
+        * @details      The bounds are checked by JsonReader::readStringBounds(), so every backslash is
+        *               followed by a valid escape sequence. \u escapes are UTF-16 code units, so
+        *               surrogate pairs are appended as they are.
+        ***********************************************************************************************/
+        QString decodeEscapedString(const char *begin, const char *end)
+        {
+            QString string;
+            string.reserve(static_cast<int>(end - begin));
+
+            const char *run = begin;
+            for (const char *character = begin; character < end; ++character)
+            {
+                if (*character != '\\')
+                {
+                    continue;
+                }
+
+                string.append(QString::fromUtf8(run, static_cast<int>(character - run)));
+                ++character;
+
+                switch (*character)
+                {
+                    case 'b': string.append(QChar('\b')); break;
+                    case 'f': string.append(QChar('\f')); break;
+                    case 'n': string.append(QChar('\n')); break;
+                    case 'r': string.append(QChar('\r')); break;
+                    case 't': string.append(QChar('\t')); break;
+                    case 'u':
+                    {
+                        ushort code = 0;
+                        for (int digit = 1; digit <= 4; ++digit)
+                        {
+                            code = static_cast<ushort>(code * 16 + hexadecimalValue(character[digit]));
+                        }
+                        string.append(QChar(code));
+                        character += 4;
+                        break;
+                    }
+                    default: string.append(QLatin1Char(*character)); break; // '"', '\\' and '/'.
+                }
+
+                run = character + 1;
+            }
+
+            string.append(QString::fromUtf8(run, static_cast<int>(end - run)));
+            return string;
+        }
+    }
+
+    JsonReader::JsonReader(const QByteArray &data):
+        data(data),
+        position(this->data.constData()),
+        end(this->data.constData() + this->data.size())
+    {
+
+    }
+
+    /** ************************************************************************************************
+    * @brief        Enter the next value if it is an object.
+    *
+    * @return       True if the value is an object: read its keys with nextKey(). Otherwise the value is
+    *               skipped.
+    ***************************************************************************************************/
+    bool JsonReader::enterObject()
+    {
+        if (!isObject())
+        {
+            skipValue();
+            return false;
+        }
+
+        if (++depth > JSON_MAX_DEPTH)
+        {
+            fail();
+            return false;
+        }
+
+        ++position;
+        first = true;
+        return true;
+    }
+
+    /** ************************************************************************************************
+    * @brief        Read the next key of the current object.
+    *
+    * @return       True if a key is read: check it with isKey(), then read or skip its value. False at the
+    *               end of the object, which is left.
+    ***************************************************************************************************/
+    bool JsonReader::nextKey()
+    {
+        if (!skipWhitespace())
+        {
+            fail();
+            return false;
+        }
+
+        if (*position == '}')
+        {
+            ++position;
+            --depth;
+            first = false; // The object was an item of its parent.
+            return false;
+        }
+
+        if (!first)
+        {
+            if (*position != ',')
+            {
+                fail();
+                return false;
+            }
+            ++position;
+            skipWhitespace();
+        }
+        first = false;
+
+        const char *keyEnd = nullptr;
+        if (!readStringBounds(keyBegin, keyEnd, keyEscaped) || !skipWhitespace() || *position != ':')
+        {
+            fail();
+            return false;
+        }
+
+        keySize = static_cast<int>(keyEnd - keyBegin);
+        ++position;
+        return true;
+    }
+
+    /** ************************************************************************************************
+    * @brief        Get the key read by the last call to nextKey(), with its escape sequences decoded.
+    ***************************************************************************************************/
+    QString JsonReader::key() const
+    {
+        return keyEscaped ? decodeEscapedString(keyBegin, keyBegin + keySize)
+                          : QString::fromUtf8(keyBegin, keySize);
+    }
+
+    /** ************************************************************************************************
+    * @brief        Enter the next value if it is an array.
+    *
+    * @return       True if the value is an array: read its items with nextItem(). Otherwise the value is
+    *               skipped.
+    ***************************************************************************************************/
+    bool JsonReader::enterArray()
+    {
+        if (!skipWhitespace() || *position != '[')
+        {
+            skipValue();
+            return false;
+        }
+
+        if (++depth > JSON_MAX_DEPTH)
+        {
+            fail();
+            return false;
+        }
+
+        ++position;
+        first = true;
+        return true;
+    }
+
+    /** ************************************************************************************************
+    * @brief        Move to the next item of the current array.
+    *
+    * @return       True if there is another item: read or skip it. False at the end of the array, which
+    *               is left.
+    ***************************************************************************************************/
+    bool JsonReader::nextItem()
+    {
+        if (!skipWhitespace())
+        {
+            fail();
+            return false;
+        }
+
+        if (*position == ']')
+        {
+            ++position;
+            --depth;
+            first = false; // The array was an item of its parent.
+            return false;
+        }
+
+        if (!first)
+        {
+            if (*position != ',')
+            {
+                fail();
+                return false;
+            }
+            ++position;
+        }
+        first = false;
+
+        return true;
+    }
+
+    /** ************************************************************************************************
+    * @brief        Check whether the next value is an object, without reading it.
+    ***************************************************************************************************/
+    bool JsonReader::isObject()
+    {
+        return skipWhitespace() && *position == '{';
+    }
+
+    /** ************************************************************************************************
+    * @brief        Check whether the next value is null, without reading it.
+    ***************************************************************************************************/
+    bool JsonReader::isNull()
+    {
+        return skipWhitespace() && *position == 'n';
+    }
+
+    /** ************************************************************************************************
+    * @brief        Read the next value as a string, a null string if it is not one.
+    ***************************************************************************************************/
+    QString JsonReader::readString()
+    {
+        const char *begin = nullptr;
+        const char *stringEnd = nullptr;
+        bool escaped = false;
+
+        if (!skipWhitespace() || *position != '"')
+        {
+            skipValue();
+            return QString();
+        }
+        if (!readStringBounds(begin, stringEnd, escaped))
+        {
+            fail();
+            return QString();
+        }
+
+        return escaped ? decodeEscapedString(begin, stringEnd)
+                       : QString::fromUtf8(begin, static_cast<int>(stringEnd - begin));
+    }
+
+    /** ************************************************************************************************
+    * @brief        Read the next value as a string, without decoding it or copying it.
+    *
+    * @details      The string is given as written in the data, escape sequences included. It is only
+    *               valid while the data is. This is meant for short codes compared right away, such as
+    *               markets.
+    ***************************************************************************************************/
+    QLatin1String JsonReader::readRawString()
+    {
+        const char *begin = nullptr;
+        const char *stringEnd = nullptr;
+        bool escaped = false;
+
+        if (!skipWhitespace() || *position != '"')
+        {
+            skipValue();
+            return QLatin1String();
+        }
+        if (!readStringBounds(begin, stringEnd, escaped))
+        {
+            fail();
+            return QLatin1String();
+        }
+
+        return QLatin1String(begin, static_cast<int>(stringEnd - begin));
+    }
+
+    /** ************************************************************************************************
+    * @brief        Read the next value as an integer.
+    *
+    * @return       The value, or defaultValue if it is not a number with an integer value in the range of
+    *               int, like QJsonValue::toInt().
+    ***************************************************************************************************/
+    int JsonReader::readInt(int defaultValue)
+    {
+        if (!skipWhitespace() || (*position != '-' && (*position < '0' || *position > '9')))
+        {
+            skipValue();
+            return defaultValue;
+        }
+
+        double number = 0;
+        if (!readNumber(number))
+        {
+            fail();
+            return defaultValue;
+        }
+
+        if (   number < std::numeric_limits<int>::min() || number > std::numeric_limits<int>::max()
+            || std::floor(number) != number)
+        {
+            return defaultValue;
+        }
+
+        return static_cast<int>(number);
+    }
+
+    /** ************************************************************************************************
+    * @brief        Read the next value as a boolean, defaultValue if it is not one.
+    ***************************************************************************************************/
+    bool JsonReader::readBool(bool defaultValue)
+    {
+        if (!skipWhitespace() || (*position != 't' && *position != 'f'))
+        {
+            skipValue();
+            return defaultValue;
+        }
+
+        const bool value = *position == 't';
+        return readLiteral(value ? "true" : "false") ? value : defaultValue;
+    }
+
+    /** ************************************************************************************************
+    * @brief        Skip the next value, checking that it is valid.
+    ***************************************************************************************************/
+    void JsonReader::skipValue()
+    {
+        if (!skipWhitespace())
+        {
+            fail();
+            return;
+        }
+
+        switch (*position)
+        {
+            case '{':
+                if (enterObject())
+                {
+                    while (nextKey())
+                    {
+                        skipValue();
+                    }
+                }
+                break;
+
+            case '[':
+                if (enterArray())
+                {
+                    while (nextItem())
+                    {
+                        skipValue();
+                    }
+                }
+                break;
+
+            case '"':
+                readRawString();
+                break;
+
+            case 't':
+                readLiteral("true");
+                break;
+
+            case 'f':
+                readLiteral("false");
+                break;
+
+            case 'n':
+                readLiteral("null");
+                break;
+
+            default:
+            {
+                double number = 0;
+                if (!readNumber(number))
+                {
+                    fail();
+                }
+                break;
+            }
+        }
+    }
+
+    /** ************************************************************************************************
+    * @brief        Check that the whole data is read and valid.
+    *
+    * @details      Call it once the top level value is read. Trailing data other than white spaces is
+    *               an error.
+    ***************************************************************************************************/
+    bool JsonReader::finish()
+    {
+        if (skipWhitespace())
+        {
+            fail();
+        }
+
+        return !error;
+    }
+
+    bool JsonReader::hasError() const
+    {
+        return error;
+    }
+
+    /** ************************************************************************************************
+    * @brief        Get the offset in the data at which the parsing stopped, for error messages.
+    ***************************************************************************************************/
+    int JsonReader::errorOffset() const
+    {
+        return error ? static_cast<int>(position - data.constData()) : -1;
+    }
+
+    /** ************************************************************************************************
+    * @brief        Skip white spaces.
+    *
+    * @return       False if the end of the data is reached, or after an error.
+    ***************************************************************************************************/
+    bool JsonReader::skipWhitespace()
+    {
+        while (position < end && (*position == ' ' || *position == '\n' || *position == '\r' || *position == '\t'))
+        {
+            ++position;
+        }
+
+        return !error && position < end;
+    }
+
+    /** ************************************************************************************************
+    * @brief        Read the string at the current position, which must be a quote, and give the bounds
+    *               of its content.
+    *
+    * @param[out]   escaped: Whether the content holds escape sequences.
+    *
+    * @return       False if the string is invalid.
+    ***************************************************************************************************/
+    bool JsonReader::readStringBounds(const char *&begin, const char *&stringEnd, bool &escaped)
+    {
+        if (position >= end || *position != '"')
+        {
+            return false;
+        }
+
+        begin = ++position;
+        escaped = false;
+
+        while (position < end)
+        {
+            const char character = *position;
+
+            if (character == '"')
+            {
+                stringEnd = position++;
+                return true;
+            }
+            if (static_cast<unsigned char>(character) < 0x20)
+            {
+                return false;
+            }
+            if (character == '\\')
+            {
+                escaped = true;
+                if (++position >= end)
+                {
+                    return false;
+                }
+
+                if (*position == 'u')
+                {
+                    if (end - position < 5)
+                    {
+                        return false;
+                    }
+                    for (int digit = 1; digit <= 4; ++digit)
+                    {
+                        if (hexadecimalValue(position[digit]) < 0)
+                        {
+                            return false;
+                        }
+                    }
+                    position += 4;
+                }
+                else if (!std::strchr("\"\\/bfnrt", *position) || *position == '\0')
+                {
+                    return false;
+                }
+            }
+
+            ++position;
+        }
+
+        return false;
+    }
+
+    /** ************************************************************************************************
+    * @brief        Read the given literal (true, false or null), failing if the data does not match.
+    *
+    * @return       True if the literal is read.
+    ***************************************************************************************************/
+    bool JsonReader::readLiteral(const char *literal)
+    {
+        const size_t size = std::strlen(literal);
+
+        if (static_cast<size_t>(end - position) < size || std::memcmp(position, literal, size) != 0)
+        {
+            fail();
+            return false;
+        }
+
+        position += size;
+        return true;
+    }
+
+    /** ************************************************************************************************
+    * @brief        Read the number at the current position.
+    *
+    * @details      Integers, by far the most common numbers of the API, are accumulated directly. Other
+    *               numbers are converted by Qt, which does not depend on the locale.
+    *
+    * @return       False if the number is invalid.
+    ***************************************************************************************************/
+    bool JsonReader::readNumber(double &number)
+    {
+        const char *begin = position;
+        bool integer = true;
+
+        if (position < end && *position == '-')
+        {
+            ++position;
+        }
+
+        // Integer part: 0 or digits not starting with 0.
+        if (position < end && *position == '0')
+        {
+            ++position;
+        }
+        else if (position < end && *position >= '1' && *position <= '9')
+        {
+            while (position < end && *position >= '0' && *position <= '9')
+            {
+                ++position;
+            }
+        }
+        else
+        {
+            return false;
+        }
+
+        if (position < end && *position == '.')
+        {
+            integer = false;
+            const char *fraction = ++position;
+            while (position < end && *position >= '0' && *position <= '9')
+            {
+                ++position;
+            }
+            if (position == fraction)
+            {
+                return false;
+            }
+        }
+
+        if (position < end && (*position == 'e' || *position == 'E'))
+        {
+            integer = false;
+            ++position;
+            if (position < end && (*position == '+' || *position == '-'))
+            {
+                ++position;
+            }
+            const char *exponent = position;
+            while (position < end && *position >= '0' && *position <= '9')
+            {
+                ++position;
+            }
+            if (position == exponent)
+            {
+                return false;
+            }
+        }
+
+        const int size = static_cast<int>(position - begin);
+        const bool negative = *begin == '-';
+
+        if (integer && size - (negative ? 1 : 0) <= JSON_MAX_INTEGER_DIGITS)
+        {
+            qint64 value = 0;
+            for (const char *digit = begin + (negative ? 1 : 0); digit < position; ++digit)
+            {
+                value = value * 10 + (*digit - '0');
+            }
+            number = static_cast<double>(negative ? -value : value);
+            return true;
+        }
+
+        bool ok = false;
+        number = QByteArray::fromRawData(begin, size).toDouble(&ok);
+        return ok;
+    }
+
+    /** ************************************************************************************************
+    * @brief        Stop the parsing: the following reads give default values.
+    ***************************************************************************************************/
+    void JsonReader::fail()
+    {
+        error = true;
+    }
+}
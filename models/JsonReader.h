@@ -0,0 +1,107 @@
+#ifndef JSONREADER_H
+#define JSONREADER_H
+
+#include <cstring>
+#include <vector>
+
+#include <QByteArray>
+#include <QLatin1String>
+#include <QString>
+
+namespace Qtify
+{
+    /** ************************************************************************************************
+    * @class    JsonReader
+    *
+    * @brief    Pull parser reading JSON values one after the other, straight from the bytes of a reply.
+    *
+    * @details  No document is built: the models read the keys they know and skip the other values, so
+    *           a reply is parsed in a single pass and only the members of the models are allocated.
+    *           Objects are read with enterObject() then nextKey() until it returns false, the value of
+    *           each key being read or skipped before the next call. Arrays are read the same way with
+    *           enterArray() and nextItem().
+    *           The read functions behave like the QJsonValue conversions: a value of another type is
+    *           skipped and gives the default value. Invalid JSON stops the parsing, after which all
+    *           reads give default values and hasError() is true.
+    *           The data must be kept alive while it is read.
+    ***************************************************************************************************/
+    class JsonReader
+    {
+        public:
+            explicit JsonReader(const QByteArray &data);
+
+            bool enterObject();
+            bool nextKey();
+            template<int Size>
+            bool isKey(const char (&name)[Size]) const;
+            QString key() const;
+
+            bool enterArray();
+            bool nextItem();
+
+            bool isObject();
+            bool isNull();
+            QString readString();
+            QLatin1String readRawString();
+            int readInt(int defaultValue = 0);
+            bool readBool(bool defaultValue = false);
+            void skipValue();
+
+            bool finish();
+            bool hasError() const;
+            int errorOffset() const;
+
+        private:
+            bool skipWhitespace();
+            bool readStringBounds(const char *&begin, const char *&end, bool &escaped);
+            bool readLiteral(const char *literal);
+            bool readNumber(double &number);
+            void fail();
+
+            QByteArray data;
+            const char *position;
+            const char *end;
+            // Key read by the last call to nextKey(), as written in the data.
+            const char *keyBegin = nullptr;
+            int keySize = 0;
+            bool keyEscaped = false;
+            // No item has been read yet in the object or array just entered.
+            bool first = false;
+            // Number of objects and arrays entered and not left yet.
+            int depth = 0;
+            bool error = false;
+    };
+
+    /** ************************************************************************************************
+    * @brief        Check whether the key read by the last call to nextKey() is the given one.
+    *
+    * @details      Keys are compared as written in the data: a key with escape sequences never matches,
+    *               which is fine for the keys of the API.
+    ***************************************************************************************************/
+    template<int Size>
+    bool JsonReader::isKey(const char (&name)[Size]) const
+    {
+        return !keyEscaped && keySize == Size - 1 && std::memcmp(keyBegin, name, Size - 1) == 0;
+    }
+
+    /** ************************************************************************************************
+    * @brief        Read a JSON array of objects into a vector of models built from the reader.
+    ***************************************************************************************************/
+    template<typename T>
+    std::vector<T> readArray(JsonReader &reader)
+    {
+        std::vector<T> items;
+
+        if (reader.enterArray())
+        {
+            while (reader.nextItem())
+            {
+                items.emplace_back(reader);
+            }
+        }
+
+        return items;
+    }
+}
+
+#endif // JSONREADER_H
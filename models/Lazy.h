@@ -0,0 +1,119 @@
+#ifndef LAZY_H
+#define LAZY_H
+
+#include <atomic>
+#include <utility>
+#include <vector>
+
+#include <QJsonArray>
+#include <QJsonValue>
+#include <QMutex>
+
+namespace Qtify
+{
+    /** ************************************************************************************************
+    * @class    Lazy
+    *
+    * @brief    Member of a model decoded from JSON on first access instead of at construction.
+    *
+    * @details  The JSON value is kept (it is implicitly shared, so this is cheap) until the value is
+    *           requested. Decoding is protected by a mutex so that a model can be read from any thread.
+    ***************************************************************************************************/
+    template<typename T>
+    class Lazy
+    {
+        public:
+            using Decoder = T (*)(const QJsonValue &json);
+
+            Lazy(const QJsonValue &json, Decoder decoder):
+                json(json),
+                decoder(decoder),
+                decoded(false)
+            {
+
+            }
+
+            explicit Lazy(T value):
+                decoder(nullptr),
+                value(std::move(value)),
+                decoded(true)
+            {
+
+            }
+
+            Lazy(const Lazy &other):
+                decoded(false)
+            {
+                QMutexLocker locker(&other.mutex);
+                json    = other.json;
+                decoder = other.decoder;
+                value   = other.value;
+                decoded = other.decoded.load();
+            }
+
+            Lazy &operator=(const Lazy &other)
+            {
+                if (this != &other)
+                {
+                    Lazy copy(other);
+                    QMutexLocker locker(&mutex);
+                    json    = copy.json;
+                    decoder = copy.decoder;
+                    value   = copy.value;
+                    decoded = copy.decoded.load();
+                }
+                return *this;
+            }
+
+            // Replace the value by one decoded elsewhere, e.g. read with a JsonReader.
+            void set(T newValue)
+            {
+                QMutexLocker locker(&mutex);
+                json    = QJsonValue();
+                value   = std::move(newValue);
+                decoded.store(true, std::memory_order_release);
+            }
+
+            const T &get() const
+            {
+                if (!decoded.load(std::memory_order_acquire))
+                {
+                    QMutexLocker locker(&mutex);
+                    if (!decoded.load(std::memory_order_relaxed))
+                    {
+                        value = decoder(json);
+                        json  = QJsonValue(); // Not needed anymore.
+                        decoded.store(true, std::memory_order_release);
+                    }
+                }
+                return value;
+            }
+
+        private:
+            mutable QMutex mutex;
+            mutable QJsonValue json;
+            Decoder decoder;
+            mutable T value;
+            mutable std::atomic<bool> decoded;
+    };
+
+    /** ************************************************************************************************
+    * @brief        Decode a JSON array of objects into a vector of models.
+    ***************************************************************************************************/
+    template<typename T>
+    std::vector<T> decodeArray(const QJsonValue &json)
+    {
+        std::vector<T> items;
+        const QJsonArray jsonItems = json.toArray();
+        items.reserve(static_cast<size_t>(jsonItems.size()));
+
+        for (const auto &jsonItem : jsonItems)
+        {
+            items.emplace_back(jsonItem.toObject());
+        }
+
+        return items;
+    }
+}
+
+#endif // LAZY_H
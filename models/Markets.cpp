@@ -0,0 +1,128 @@
+#include "Markets.h"
+
+#include "JsonReader.h"
+#include "Serialization.h"
+
+namespace Qtify
+{
+    Markets::Markets() = default;
+
+    Markets::Markets(const QJsonArray &json)
+    {
+        for (const auto &jsonMarket : json)
+        {
+            const int marketIndex = index(jsonMarket.toString());
+            if (marketIndex >= 0)
+            {
+                markets.set(static_cast<size_t>(marketIndex));
+            }
+        }
+    }
+
+    Markets::Markets(QDataStream &stream)
+    {
+        const QByteArray bits = Serialization::readValue<QByteArray>(stream);
+
+        for (size_t marketIndex = 0; marketIndex < markets.size(); ++marketIndex)
+        {
+            const int byte = static_cast<int>(marketIndex / 8);
+            if (byte < bits.size() && (bits[byte] & (1 << (marketIndex % 8))))
+            {
+                markets.set(marketIndex);
+            }
+        }
+    }
+
+    /** ************************************************************************************************
+    * @brief        Read the codes without building a string for each of them.
+    ***************************************************************************************************/
+    Markets::Markets(JsonReader &reader)
+    {
+        if (reader.enterArray())
+        {
+            while (reader.nextItem())
+            {
+                const QLatin1String market = reader.readRawString();
+                const int marketIndex = market.size() == 2
+                                        ? index(QLatin1Char(market.data()[0]), QLatin1Char(market.data()[1]))
+                                        : -1;
+                if (marketIndex >= 0)
+                {
+                    markets.set(static_cast<size_t>(marketIndex));
+                }
+            }
+        }
+    }
+
+    /** ************************************************************************************************
+    * @brief        Write the bitmap as bytes, 8 markets per byte.
+    ***************************************************************************************************/
+    void Markets::serialize(QDataStream &stream) const
+    {
+        QByteArray bits(static_cast<int>((markets.size() + 7) / 8), 0);
+
+        for (size_t marketIndex = 0; marketIndex < markets.size(); ++marketIndex)
+        {
+            if (markets.test(marketIndex))
+            {
+                bits[static_cast<int>(marketIndex / 8)] = static_cast<char>(bits[static_cast<int>(marketIndex / 8)] | (1 << (marketIndex % 8)));
+            }
+        }
+
+        stream << bits;
+    }
+
+    bool Markets::isAvailableIn(const QString &market) const
+    {
+        const int marketIndex = index(market);
+        return marketIndex >= 0 && markets.test(static_cast<size_t>(marketIndex));
+    }
+
+    int Markets::count() const
+    {
+        return static_cast<int>(markets.count());
+    }
+
+    QStringList Markets::toStringList() const
+    {
+        QStringList list;
+        list.reserve(count());
+
+        for (size_t marketIndex = 0; marketIndex < markets.size(); ++marketIndex)
+        {
+            if (markets.test(marketIndex))
+            {
+                const QChar code[] {
+                    QChar(static_cast<ushort>('A' + marketIndex / 26)),
+                    QChar(static_cast<ushort>('A' + marketIndex % 26)),
+                };
+                list.append(QString(code, 2));
+            }
+        }
+
+        return list;
+    }
+
+    /** ************************************************************************************************
+    * @brief        Get the bit index of a market code, -1 if the code is invalid.
+    ***************************************************************************************************/
+    int Markets::index(const QString &market)
+    {
+        return market.size() == 2 ? index(market[0], market[1]) : -1;
+    }
+
+    /** ************************************************************************************************
+    * @brief        Get the bit index of the market made of the two given letters, -1 if they are invalid.
+    ***************************************************************************************************/
+    int Markets::index(QChar firstLetter, QChar secondLetter)
+    {
+        const int first  = firstLetter.toUpper().unicode() - 'A';
+        const int second = secondLetter.toUpper().unicode() - 'A';
+        if (first < 0 || first >= 26 || second < 0 || second >= 26)
+        {
+            return -1;
+        }
+
+        return first * 26 + second;
+    }
+}
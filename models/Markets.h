@@ -0,0 +1,44 @@
+#ifndef MARKETS_H
+#define MARKETS_H
+
+#include <bitset>
+
+#include <QDataStream>
+#include <QJsonArray>
+#include <QStringList>
+
+namespace Qtify
+{
+    class JsonReader;
+
+    /** ************************************************************************************************
+    * @class    Markets
+    *
+    * @brief    Set of markets (ISO 3166-1 alpha-2 country codes) in which an item is available.
+    *
+    * @details  Stored as a 26x26 bitmap: one bit per possible two-letter code. This takes less than
+    *           100 bytes and availability checks are constant time.
+    ***************************************************************************************************/
+    class Markets
+    {
+        public:
+            Markets();
+            Markets(const QJsonArray &json);
+            explicit Markets(QDataStream &stream);
+            explicit Markets(JsonReader &reader);
+
+            void serialize(QDataStream &stream) const;
+
+            bool isAvailableIn(const QString &market) const;
+            int count() const;
+            QStringList toStringList() const;
+
+        private:
+            static int index(const QString &market);
+            static int index(QChar firstLetter, QChar secondLetter);
+
+            std::bitset<26 * 26> markets;
+    };
+}
+
+#endif // MARKETS_H
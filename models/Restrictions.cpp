@@ -1,5 +1,8 @@
 #include "Restrictions.h"
 
+#include "JsonReader.h"
+#include "Serialization.h"
+
 namespace Qtify
 {
     Restrictions::Restrictions(const QJsonObject &json):
@@ -8,6 +11,35 @@ namespace Qtify
 
     }
 
+    Restrictions::Restrictions(QDataStream &stream):
+        reason(Serialization::readString(stream))
+    {
+
+    }
+
+    Restrictions::Restrictions(JsonReader &reader)
+    {
+        if (reader.enterObject())
+        {
+            while (reader.nextKey())
+            {
+                if (reader.isKey("reason"))
+                {
+                    reason = reader.readString();
+                }
+                else
+                {
+                    reader.skipValue();
+                }
+            }
+        }
+    }
+
+    void Restrictions::serialize(QDataStream &stream) const
+    {
+        Serialization::writeString(stream, reason);
+    }
+
     const QString &Restrictions::getReason() const
     {
         return reason;
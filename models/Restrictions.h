@@ -2,10 +2,13 @@
 #define RESTRICTIONS_H
 
 #include <QString>
+#include <QDataStream>
 #include <QJsonObject>
 
 namespace Qtify
 {
+    class JsonReader;
+
     /** ************************************************************************************************
     * @class    Restrictions
     *
@@ -18,6 +21,10 @@ namespace Qtify
     {
         public:
             Restrictions(const QJsonObject &json);
+            explicit Restrictions(QDataStream &stream);
+            explicit Restrictions(JsonReader &reader);
+
+            void serialize(QDataStream &stream) const;
 
             const QString &getReason() const;
 
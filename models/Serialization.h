@@ -0,0 +1,136 @@
+#ifndef SERIALIZATION_H
+#define SERIALIZATION_H
+
+#include <vector>
+
+#include <QByteArray>
+#include <QDataStream>
+#include <QJsonObject>
+#include <QString>
+
+namespace Qtify
+{
+    /** ************************************************************************************************
+    *   Binary serialization of the models.
+    *   A serialized model starts with the format version, followed by the fields of the model in
+    * declaration order: integers and booleans as QDataStream writes them, strings as UTF-8 prefixed with
+    * their size, vectors as their size followed by their items.
+    *   Each model has a constructor reading a QDataStream and a serialize() function writing it. Fields
+    * are read in the constructor initializer list, so they must be written in declaration order.
+    *   Bump SERIALIZATION_VERSION whenever a model changes its fields: data with another version is
+    * rejected, like data with enumeration values out of range.
+    ***************************************************************************************************/
+    namespace Serialization
+    {
+        /// Version of the format, written before the data.
+        const quint16 SERIALIZATION_VERSION{1};
+        /// Version of QDataStream used for the data.
+        const QDataStream::Version SERIALIZATION_STREAM_VERSION{QDataStream::Qt_5_6};
+
+        inline void writeString(QDataStream &stream, const QString &string)
+        {
+            stream << string.toUtf8();
+        }
+
+        inline QString readString(QDataStream &stream)
+        {
+            QByteArray data;
+            stream >> data;
+            return QString::fromUtf8(data);
+        }
+
+        template<typename T>
+        T readValue(QDataStream &stream)
+        {
+            T value{};
+            stream >> value;
+            return value;
+        }
+
+        /** ********************************************************************************************
+        * @brief        Read an enumeration value, whose valid values range from 0 to last.
+        *
+        * @details      An out of range value marks the stream as corrupted, so that the model is rejected,
+        *               and last is returned.
+        ***********************************************************************************************/
+        template<typename T>
+        T readEnum(QDataStream &stream, T last)
+        {
+            const qint32 value = readValue<qint32>(stream);
+            if (value < 0 || value > static_cast<qint32>(last))
+            {
+                stream.setStatus(QDataStream::ReadCorruptData);
+                return last;
+            }
+
+            return static_cast<T>(value);
+        }
+
+        template<typename T>
+        void writeVector(QDataStream &stream, const std::vector<T> &items)
+        {
+            stream << static_cast<quint32>(items.size());
+            for (const T &item : items)
+            {
+                item.serialize(stream);
+            }
+        }
+
+        template<typename T>
+        std::vector<T> readVector(QDataStream &stream)
+        {
+            const quint32 size = readValue<quint32>(stream);
+            std::vector<T> items;
+
+            for (quint32 i = 0; i < size && stream.status() == QDataStream::Ok; ++i)
+            {
+                items.emplace_back(stream);
+            }
+
+            return items;
+        }
+
+        /** ********************************************************************************************
+        * @brief        Serialize a model with the format version.
+        ***********************************************************************************************/
+        template<typename T>
+        QByteArray serialize(const T &model)
+        {
+            QByteArray data;
+            QDataStream stream(&data, QIODevice::WriteOnly);
+            stream.setVersion(SERIALIZATION_STREAM_VERSION);
+
+            stream << SERIALIZATION_VERSION;
+            model.serialize(stream);
+
+            return data;
+        }
+
+        /** ********************************************************************************************
+        * @brief        Build a model from data written by serialize().
+        *
+        * @param[out]   ok: Set to false if the data has another version or is truncated (optional).
+        *
+        * @return       The model, empty if the data is invalid.
+        ***********************************************************************************************/
+        template<typename T>
+        T deserialize(const QByteArray &data, bool *ok = nullptr)
+        {
+            QDataStream stream(data);
+            stream.setVersion(SERIALIZATION_STREAM_VERSION);
+
+            bool valid = readValue<quint16>(stream) == SERIALIZATION_VERSION;
+            T model = valid ? T(stream) : T(QJsonObject());
+            valid = valid && stream.status() == QDataStream::Ok;
+
+            if (ok)
+            {
+                *ok = valid;
+            }
+
+            return valid ? model : T(QJsonObject());
+        }
+    }
+}
+
+#endif // SERIALIZATION_H
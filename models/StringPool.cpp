@@ -0,0 +1,167 @@
+#include "StringPool.h"
+
+#include <QHash>
+#include <QMutex>
+#include <QSet>
+
+#include <algorithm>
+
+namespace Qtify
+{
+    namespace
+    {
+        /// Number of shards of the pool. It must be a power of two.
+        const int STRING_POOL_SHARD_COUNT{16};
+        /// Minimum size of a shard from which its unused strings are removed.
+        const int STRING_POOL_PRUNE_MIN_SIZE{4096};
+
+        static_assert((STRING_POOL_SHARD_COUNT & (STRING_POOL_SHARD_COUNT - 1)) == 0,
+                      "STRING_POOL_SHARD_COUNT must be a power of two");
+
+        struct Shard
+        {
+            QMutex mutex;
+            QSet<QString> strings;
+            StringPool::Statistics statistics;
+            // Size from which the shard is pruned.
+            int pruneSize = STRING_POOL_PRUNE_MIN_SIZE;
+        };
+
+        Shard *shards()
+        {
+            static Shard instances[STRING_POOL_SHARD_COUNT];
+            return instances;
+        }
+
+        /** ********************************************************************************************
+        * @brief        Remove the strings of a shard that are only referenced by the pool.
+        *
+        * @details      The lock of the shard must be held. No other thread can reference such a string
+        *               again without the lock, as the pool holds the only reference. The next pruning
+        *               happens when the shard has doubled, so that a shard full of used strings is not
+        *               scanned at every insertion.
+        ***********************************************************************************************/
+        void pruneShard(Shard &shard)
+        {
+            const int size = shard.strings.size();
+
+            for (auto iterator = shard.strings.begin(); iterator != shard.strings.end();)
+            {
+                if (iterator->isDetached())
+                {
+                    iterator = shard.strings.erase(iterator);
+                }
+                else
+                {
+                    ++iterator;
+                }
+            }
+
+            shard.statistics.pruned += static_cast<quint64>(size - shard.strings.size());
+            shard.pruneSize = std::max(shard.strings.size() * 2, STRING_POOL_PRUNE_MIN_SIZE);
+        }
+    }
+
+    /** ************************************************************************************************
+    * @brief        Get the pooled string equal to the given one.
+    *
+    * @details      If the string is not in the pool yet, it is added.
+    ***************************************************************************************************/
+    QString StringPool::intern(const QString &string)
+    {
+        if (string.isEmpty())
+        {
+            return string;
+        }
+
+        Shard &shard = shards()[qHash(string) & (STRING_POOL_SHARD_COUNT - 1)];
+        QMutexLocker locker(&shard.mutex);
+        ++shard.statistics.lookups;
+
+        auto iterator = shard.strings.constFind(string);
+        if (iterator != shard.strings.constEnd())
+        {
+            ++shard.statistics.hits;
+            // The buffer of the given string is only released if it is not the pooled one already.
+            if (string.constData() != iterator->constData())
+            {
+                shard.statistics.bytesSaved += static_cast<quint64>(string.size()) * sizeof(QChar);
+            }
+            return *iterator;
+        }
+
+        if (shard.strings.size() >= shard.pruneSize)
+        {
+            pruneShard(shard);
+        }
+
+        shard.strings.insert(string);
+        return string;
+    }
+
+    /** ************************************************************************************************
+    * @brief        Compare two strings returned by intern().
+    *
+    * @details      Interned strings with the same content share their buffer, so this is a pointer
+    *               comparison. A string stays in the pool while it is referenced outside of it, so this
+    *               holds across pruning, but not across clear().
+    ***************************************************************************************************/
+    bool StringPool::isSame(const QString &first, const QString &second)
+    {
+        // Empty strings are not pooled, and may use different shared empty buffers.
+        return first.constData() == second.constData() || (first.isEmpty() && second.isEmpty());
+    }
+
+    /** ************************************************************************************************
+    * @brief        Get the usage statistics of the pool.
+    ***************************************************************************************************/
+    StringPool::Statistics StringPool::getStatistics()
+    {
+        Statistics statistics;
+
+        for (int i = 0; i < STRING_POOL_SHARD_COUNT; ++i)
+        {
+            Shard &shard = shards()[i];
+            QMutexLocker locker(&shard.mutex);
+
+            statistics.lookups    += shard.statistics.lookups;
+            statistics.hits       += shard.statistics.hits;
+            statistics.bytesSaved += shard.statistics.bytesSaved;
+            statistics.pruned     += shard.statistics.pruned;
+            statistics.size       += shard.strings.size();
+        }
+
+        return statistics;
+    }
+
+    /** ************************************************************************************************
+    * @brief        Remove the strings that are not used anymore outside of the pool.
+    ***************************************************************************************************/
+    void StringPool::prune()
+    {
+        for (int i = 0; i < STRING_POOL_SHARD_COUNT; ++i)
+        {
+            Shard &shard = shards()[i];
+            QMutexLocker locker(&shard.mutex);
+            pruneShard(shard);
+        }
+    }
+
+    /** ************************************************************************************************
+    * @brief        Remove all strings from the pool.
+    *
+    * @details      Strings already returned stay valid. Strings interned afterwards will not share their
+    *               buffer with the ones interned before.
+    ***************************************************************************************************/
+    void StringPool::clear()
+    {
+        for (int i = 0; i < STRING_POOL_SHARD_COUNT; ++i)
+        {
+            Shard &shard = shards()[i];
+            QMutexLocker locker(&shard.mutex);
+
+            shard.strings.clear();
+            shard.pruneSize = STRING_POOL_PRUNE_MIN_SIZE;
+        }
+    }
+}
@@ -0,0 +1,46 @@
+#ifndef STRINGPOOL_H
+#define STRINGPOOL_H
+
+#include <QString>
+
+namespace Qtify
+{
+    /** ************************************************************************************************
+    * @class    StringPool
+    *
+    * @brief    Process-wide pool of immutable strings.
+    *
+    * @details  The models intern their Spotify IDs, URIs and API endpoints so that equal identifiers
+    *           share one buffer whatever the number of objects parsed. Comparing two interned strings
+    *           only needs to compare their buffers (see isSame()).
+    *           The pool is split in shards, each one with its own lock, so that models parsed in several
+    *           threads rarely wait for each other. Strings only referenced by the pool are removed when a
+    *           shard grows past its threshold, or with prune(). Call clear() to empty the pool.
+    *           All functions are thread safe.
+    ***************************************************************************************************/
+    class StringPool
+    {
+        public:
+            /** ************************************************************************************************
+            * @struct   Statistics
+            *
+            * @brief    Usage statistics of the pool.
+            ***************************************************************************************************/
+            struct Statistics
+            {
+                quint64 lookups    = 0; /// Number of calls to intern().
+                quint64 hits       = 0; /// Number of strings found in the pool.
+                quint64 bytesSaved = 0; /// Size of the duplicate buffers released thanks to the pool.
+                quint64 pruned     = 0; /// Number of unused strings removed from the pool.
+                int     size       = 0; /// Number of strings in the pool.
+            };
+
+            static QString intern(const QString &string);
+            static bool isSame(const QString &first, const QString &second);
+            static Statistics getStatistics();
+            static void prune();
+            static void clear();
+    };
+}
+
+#endif // STRINGPOOL_H
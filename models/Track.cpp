@@ -1,130 +1,330 @@
 #include "Track.h"
 
-#include <QJsonArray>
-#include <QVariant>
+#include "JsonReader.h"
+#include "Lazy.h"
+#include "Serialization.h"
+#include "StringPool.h"
 
 namespace Qtify
 {
+    class TrackData : public QSharedData
+    {
+        public:
+            TrackData(const QJsonObject &json):
+                album(json["album"].toObject()),
+                artists(json["artists"], &decodeArray<Artist>),
+                available_markets(json["available_markets"].toArray()),
+                disc_number(json["disc_number"].toInt()),
+                duration_ms(json["duration_ms"].toInt()),
+                explicit_lyrics(json["explicit"].toBool(false)),
+                external_ids(json["external_ids"].toObject()),
+                external_urls(json["external_urls"].toObject()),
+                href(StringPool::intern(json["href"].toString())),
+                id(StringPool::intern(json["id"].toString())),
+                is_playable(json["is_playable"].toBool(true)),
+                linked_from(json["linked_from"].toObject()),
+                restrictions(json["restrictions"].toObject()),
+                name(json["name"].toString()),
+                popularity(json["popularity"].toInt()),
+                preview_url(json["preview_url"].toString()),
+                track_number(json["track_number"].toInt()),
+                uri(StringPool::intern(json["uri"].toString())),
+                is_local(json["is_local"].toBool())
+            {
+
+            }
+
+            TrackData(QDataStream &stream):
+                album(stream),
+                artists(Serialization::readVector<Artist>(stream)),
+                available_markets(stream),
+                disc_number(Serialization::readValue<qint32>(stream)),
+                duration_ms(Serialization::readValue<qint32>(stream)),
+                explicit_lyrics(Serialization::readValue<bool>(stream)),
+                external_ids(stream),
+                external_urls(stream),
+                href(StringPool::intern(Serialization::readString(stream))),
+                id(StringPool::intern(Serialization::readString(stream))),
+                is_playable(Serialization::readValue<bool>(stream)),
+                linked_from(stream),
+                restrictions(stream),
+                name(Serialization::readString(stream)),
+                popularity(Serialization::readValue<qint32>(stream)),
+                preview_url(Serialization::readString(stream)),
+                track_number(Serialization::readValue<qint32>(stream)),
+                uri(StringPool::intern(Serialization::readString(stream))),
+                is_local(Serialization::readValue<bool>(stream))
+            {
+
+            }
+
+            TrackData(JsonReader &reader):
+                TrackData(QJsonObject())
+            {
+                if (reader.enterObject())
+                {
+                    while (reader.nextKey())
+                    {
+                        if (reader.isKey("album"))
+                        {
+                            album = Album(reader);
+                        }
+                        else if (reader.isKey("artists"))
+                        {
+                            artists.set(readArray<Artist>(reader));
+                        }
+                        else if (reader.isKey("available_markets"))
+                        {
+                            available_markets = Markets(reader);
+                        }
+                        else if (reader.isKey("disc_number"))
+                        {
+                            disc_number = reader.readInt();
+                        }
+                        else if (reader.isKey("duration_ms"))
+                        {
+                            duration_ms = reader.readInt();
+                        }
+                        else if (reader.isKey("explicit"))
+                        {
+                            explicit_lyrics = reader.readBool(false);
+                        }
+                        else if (reader.isKey("external_ids"))
+                        {
+                            external_ids = ExternalId(reader);
+                        }
+                        else if (reader.isKey("external_urls"))
+                        {
+                            external_urls = ExternalUrl(reader);
+                        }
+                        else if (reader.isKey("href"))
+                        {
+                            href = StringPool::intern(reader.readString());
+                        }
+                        else if (reader.isKey("id"))
+                        {
+                            id = StringPool::intern(reader.readString());
+                        }
+                        else if (reader.isKey("is_playable"))
+                        {
+                            is_playable = reader.readBool(true);
+                        }
+                        else if (reader.isKey("linked_from"))
+                        {
+                            linked_from = TrackLink(reader);
+                        }
+                        else if (reader.isKey("restrictions"))
+                        {
+                            restrictions = Restrictions(reader);
+                        }
+                        else if (reader.isKey("name"))
+                        {
+                            name = reader.readString();
+                        }
+                        else if (reader.isKey("popularity"))
+                        {
+                            popularity = reader.readInt();
+                        }
+                        else if (reader.isKey("preview_url"))
+                        {
+                            preview_url = reader.readString();
+                        }
+                        else if (reader.isKey("track_number"))
+                        {
+                            track_number = reader.readInt();
+                        }
+                        else if (reader.isKey("uri"))
+                        {
+                            uri = StringPool::intern(reader.readString());
+                        }
+                        else if (reader.isKey("is_local"))
+                        {
+                            is_local = reader.readBool();
+                        }
+                        else
+                        {
+                            reader.skipValue();
+                        }
+                    }
+                }
+            }
+
+            Album album;
+            Lazy<std::vector<Artist>> artists; // Need to use std::vector because QVector doesn't support emplace_back
+            Markets available_markets;
+            int disc_number;
+            int duration_ms;
+            bool explicit_lyrics;
+            ExternalId external_ids;
+            ExternalUrl external_urls;
+            QString href;
+            QString id;
+            bool is_playable;
+            TrackLink linked_from;
+            Restrictions restrictions;
+            QString name;
+            int popularity;
+            QString preview_url;
+            int track_number;
+            QString uri;
+            bool is_local;
+    };
+
+    Track::Track():
+        d(new TrackData(QJsonObject()))
+    {
+
+    }
+
     Track::Track(const QJsonObject &json):
-        album(json["album"].toObject()),
-        available_markets(json["available_markets"].toVariant().toStringList()),
-        disc_number(json["disc_number"].toInt()),
-        duration_ms(json["duration_ms"].toInt()),
-        explicit_lyrics(json["explicit"].toBool(false)),
-        external_ids(json["external_ids"].toObject()),
-        external_urls(json["external_urls"].toObject()),
-        href(json["href"].toString()),
-        id(json["id"].toString()),
-        is_playable(json["is_playable"].toBool(true)),
-        linked_from(json["linked_from"].toObject()),
-        restrictions(json["restrictions"].toObject()),
-        name(json["name"].toString()),
-        popularity(json["popularity"].toInt()),
-        preview_url(json["preview_url"].toString()),
-        track_number(json["track_number"].toInt()),
-        uri(json["uri"].toString()),
-        is_local(json["is_local"].toBool())
-    {
-        auto jsonArtists = json["artists"].toArray();
-
-        for (const auto &jsonArtist : jsonArtists)
-        {
-            artists.emplace_back(jsonArtist.toObject());
-        }
+        d(new TrackData(json))
+    {
+
+    }
+
+    Track::Track(QDataStream &stream):
+        d(new TrackData(stream))
+    {
+
+    }
+
+    Track::Track(JsonReader &reader):
+        d(new TrackData(reader))
+    {
+
+    }
+
+    Track::Track(const Track &other) = default;
+    Track::Track(Track &&other) noexcept = default;
+    Track::~Track() = default;
+    Track &Track::operator=(const Track &other) = default;
+    Track &Track::operator=(Track &&other) noexcept = default;
+
+    void Track::serialize(QDataStream &stream) const
+    {
+        d->album.serialize(stream);
+        Serialization::writeVector(stream, d->artists.get());
+        d->available_markets.serialize(stream);
+        stream << static_cast<qint32>(d->disc_number);
+        stream << static_cast<qint32>(d->duration_ms);
+        stream << d->explicit_lyrics;
+        d->external_ids.serialize(stream);
+        d->external_urls.serialize(stream);
+        Serialization::writeString(stream, d->href);
+        Serialization::writeString(stream, d->id);
+        stream << d->is_playable;
+        d->linked_from.serialize(stream);
+        d->restrictions.serialize(stream);
+        Serialization::writeString(stream, d->name);
+        stream << static_cast<qint32>(d->popularity);
+        Serialization::writeString(stream, d->preview_url);
+        stream << static_cast<qint32>(d->track_number);
+        Serialization::writeString(stream, d->uri);
+        stream << d->is_local;
     }
 
     const Album &Track::getAlbum() const
     {
-        return album;
+        return d->album;
     }
 
     const std::vector<Artist> &Track::getArtists() const
     {
-        return artists;
+        return d->artists.get();
+    }
+
+    const Markets &Track::getMarkets() const
+    {
+        return d->available_markets;
+    }
+
+    QStringList Track::getAvailableMarkets() const
+    {
+        return d->available_markets.toStringList();
     }
 
-    const QStringList &Track::getAvailableMarkets() const
+    bool Track::isAvailableIn(const QString &market) const
     {
-        return available_markets;
+        return d->available_markets.isAvailableIn(market);
     }
 
     int Track::getDiscNumber() const
     {
-        return disc_number;
+        return d->disc_number;
     }
 
     int Track::getDurationMilliseconds() const
     {
-        return duration_ms;
+        return d->duration_ms;
     }
 
     bool Track::hasExplicitLyrics() const
     {
-        return explicit_lyrics;
+        return d->explicit_lyrics;
     }
 
     const ExternalId &Track::getExternalId() const
     {
-        return external_ids;
+        return d->external_ids;
     }
 
     const ExternalUrl &Track::getExternalUrl() const
     {
-        return external_urls;
+        return d->external_urls;
     }
 
     const QString &Track::getApiEndPoint() const
     {
-        return href;
+        return d->href;
     }
 
     const QString &Track::getId() const
     {
-        return id;
+        return d->id;
     }
 
     bool Track::isPlayable() const
     {
-        return is_playable;
+        return d->is_playable;
     }
 
     const TrackLink &Track::getOriginalRequestedTrack() const
     {
-        return linked_from;
+        return d->linked_from;
     }
 
     const Restrictions &Track::getRestrictions() const
     {
-        return restrictions;
+        return d->restrictions;
     }
 
     const QString &Track::getName() const
     {
-        return name;
+        return d->name;
     }
 
     int Track::getPopularity() const
     {
-        return popularity;
+        return d->popularity;
     }
 
     const QString &Track::getPreviewUrl() const
     {
-        return preview_url;
+        return d->preview_url;
     }
 
     int Track::getTrackNumber() const
     {
-        return track_number;
+        return d->track_number;
     }
 
     const QString &Track::getUri() const
     {
-        return uri;
+        return d->uri;
     }
 
     bool Track::isLocalFile() const
     {
-        return is_local;
+        return d->is_local;
     }
 }
@@ -1,6 +1,11 @@
 #ifndef TRACK_H
 #define TRACK_H
 
+#include <vector>
+
+#include <QMetaType>
+#include <QSharedDataPointer>
+
 #include "ExternalUrl.h"
 #include "Album.h"
 #include "TrackLink.h"
@@ -8,6 +13,9 @@
 
 namespace Qtify
 {
+    class JsonReader;
+    class TrackData;
+
     /** ************************************************************************************************
     * @class    Track
     *
@@ -15,15 +23,32 @@ namespace Qtify
     *
     * @details  More info on
     *           https://developer.spotify.com/documentation/web-api/reference/object-model/#track-object-full
+    *           Artists are only decoded when first requested. Markets are decoded at once into a small bitmap,
+    *           so that the JSON array is not kept. A track built with a JsonReader decodes all its members
+    *           at once, as no JSON is kept.
+    *           The data is implicitly shared: copies are cheap.
     ***************************************************************************************************/
     class Track
     {
         public:
+            Track();
             Track(const QJsonObject &json);
+            explicit Track(QDataStream &stream);
+            explicit Track(JsonReader &reader);
+            Track(const Track &other);
+            Track(Track &&other) noexcept;
+            ~Track();
+
+            Track &operator=(const Track &other);
+            Track &operator=(Track &&other) noexcept;
+
+            void serialize(QDataStream &stream) const;
 
             const Album &getAlbum() const;
             const std::vector<Artist> &getArtists() const;
-            const QStringList &getAvailableMarkets() const;
+            const Markets &getMarkets() const;
+            QStringList getAvailableMarkets() const;
+            bool isAvailableIn(const QString &market) const;
             int getDiscNumber() const;
             int getDurationMilliseconds() const;
             bool hasExplicitLyrics() const;
@@ -42,26 +67,11 @@ namespace Qtify
             bool isLocalFile() const;
 
         private:
-            Album album;
-            std::vector<Artist> artists; // Need to use std::vector because QVector doesn't support emplace_back
-            QStringList available_markets;
-            int disc_number;
-            int duration_ms;
-            bool explicit_lyrics;
-            ExternalId external_ids;
-            ExternalUrl external_urls;
-            QString href;
-            QString id;
-            bool is_playable;
-            TrackLink linked_from;
-            Restrictions restrictions;
-            QString name;
-            int popularity;
-            QString preview_url;
-            int track_number;
-            QString uri;
-            bool is_local;
+            QSharedDataPointer<TrackData> d;
     };
 }
 
+Q_DECLARE_METATYPE(Qtify::Track)
+Q_DECLARE_METATYPE(std::vector<Qtify::Track>)
+
 #endif // TRACK_H
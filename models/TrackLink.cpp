@@ -1,16 +1,68 @@
 #include "TrackLink.h"
 
+#include "JsonReader.h"
+#include "Serialization.h"
+#include "StringPool.h"
+
 namespace Qtify
 {
     TrackLink::TrackLink(const QJsonObject &json):
         external_urls(json["external_urls"].toObject()),
-        href(json["href"].toString()),
-        id(json["id"].toString()),
-        uri(json["uri"].toString())
+        href(StringPool::intern(json["href"].toString())),
+        id(StringPool::intern(json["id"].toString())),
+        uri(StringPool::intern(json["uri"].toString()))
+    {
+
+    }
+
+    TrackLink::TrackLink(QDataStream &stream):
+        external_urls(stream),
+        href(StringPool::intern(Serialization::readString(stream))),
+        id(StringPool::intern(Serialization::readString(stream))),
+        uri(StringPool::intern(Serialization::readString(stream)))
     {
 
     }
 
+    TrackLink::TrackLink(JsonReader &reader):
+        TrackLink(QJsonObject())
+    {
+        if (reader.enterObject())
+        {
+            while (reader.nextKey())
+            {
+                if (reader.isKey("external_urls"))
+                {
+                    external_urls = ExternalUrl(reader);
+                }
+                else if (reader.isKey("href"))
+                {
+                    href = StringPool::intern(reader.readString());
+                }
+                else if (reader.isKey("id"))
+                {
+                    id = StringPool::intern(reader.readString());
+                }
+                else if (reader.isKey("uri"))
+                {
+                    uri = StringPool::intern(reader.readString());
+                }
+                else
+                {
+                    reader.skipValue();
+                }
+            }
+        }
+    }
+
+    void TrackLink::serialize(QDataStream &stream) const
+    {
+        external_urls.serialize(stream);
+        Serialization::writeString(stream, href);
+        Serialization::writeString(stream, id);
+        Serialization::writeString(stream, uri);
+    }
+
     const ExternalUrl &TrackLink::getExternalUrl() const
     {
         return external_urls;
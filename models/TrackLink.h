@@ -5,6 +5,8 @@
 
 namespace Qtify
 {
+    class JsonReader;
+
     /** ************************************************************************************************
     * @class    TrackLink
     *
@@ -17,6 +19,10 @@ namespace Qtify
     {
         public:
             TrackLink(const QJsonObject &json);
+            explicit TrackLink(QDataStream &stream);
+            explicit TrackLink(JsonReader &reader);
+
+            void serialize(QDataStream &stream) const;
 
             const ExternalUrl &getExternalUrl() const;
             const QString &getApiEndPoint() const;
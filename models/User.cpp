@@ -1,57 +1,121 @@
 #include "User.h"
 
+#include "Serialization.h"
+
 namespace Qtify
 {
+    class UserData : public QSharedData
+    {
+        public:
+            UserData(const QJsonObject &json):
+                country     (json["country"     ].toString()),
+                display_name(json["display_name"].toString()),
+                email       (json["email"       ].toString()),
+                href        (json["href"        ].toString()),
+                id          (json["id"          ].toString()),
+                product     (json["product"     ].toString()),
+                type        (json["type"        ].toString()),
+                uri         (json["uri"         ].toString())
+            {
+
+            }
+
+            UserData(QDataStream &stream):
+                country(Serialization::readString(stream)),
+                display_name(Serialization::readString(stream)),
+                email(Serialization::readString(stream)),
+                href(Serialization::readString(stream)),
+                id(Serialization::readString(stream)),
+                product(Serialization::readString(stream)),
+                type(Serialization::readString(stream)),
+                uri(Serialization::readString(stream))
+            {
+
+            }
+
+            QString country;
+            QString display_name;
+            QString email;
+            QString href;
+            QString id;
+            QString product;
+            QString type;
+            QString uri;
+    };
+
+    User::User():
+        d(new UserData(QJsonObject()))
+    {
+
+    }
+
     User::User(const QJsonObject &json):
-        country     (json["country"     ].toString()),
-        display_name(json["display_name"].toString()),
-        email       (json["email"       ].toString()),
-        href        (json["href"        ].toString()),
-        id          (json["id"          ].toString()),
-        product     (json["product"     ].toString()),
-        type        (json["type"        ].toString()),
-        uri         (json["uri"         ].toString())
+        d(new UserData(json))
+    {
+
+    }
+
+    User::User(QDataStream &stream):
+        d(new UserData(stream))
     {
 
     }
 
+    User::User(const User &other) = default;
+    User::User(User &&other) noexcept = default;
+    User::~User() = default;
+    User &User::operator=(const User &other) = default;
+    User &User::operator=(User &&other) noexcept = default;
+
+    void User::serialize(QDataStream &stream) const
+    {
+        Serialization::writeString(stream, d->country);
+        Serialization::writeString(stream, d->display_name);
+        Serialization::writeString(stream, d->email);
+        Serialization::writeString(stream, d->href);
+        Serialization::writeString(stream, d->id);
+        Serialization::writeString(stream, d->product);
+        Serialization::writeString(stream, d->type);
+        Serialization::writeString(stream, d->uri);
+    }
+
     const QString &User::getCountry() const
     {
-        return country;
+        return d->country;
     }
 
     const QString &User::getDisplayName() const
     {
-        return display_name;
+        return d->display_name;
     }
 
     const QString &User::getEmail() const
     {
-        return email;
+        return d->email;
     }
 
     const QString &User::getApiEndPoint() const
     {
-        return href;
+        return d->href;
     }
 
     const QString &User::getId() const
     {
-        return id;
+        return d->id;
     }
 
     const QString &User::getProduct() const
     {
-        return product;
+        return d->product;
     }
 
     const QString &User::getType() const
     {
-        return type;
+        return d->type;
     }
 
     const QString &User::getSpotifyUri() const
     {
-        return uri;
+        return d->uri;
     }
 }
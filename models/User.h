@@ -1,10 +1,15 @@
 #ifndef USER_H
 #define USER_H
 
+#include <QDataStream>
 #include <QJsonObject>
+#include <QMetaType>
+#include <QSharedDataPointer>
 
 namespace Qtify
 {
+    class UserData;
+
     /** ************************************************************************************************
     * @class    User
     *
@@ -12,11 +17,23 @@ namespace Qtify
     *
     * @details  More info on
     *           https://developer.spotify.com/documentation/web-api/reference/users-profile/get-current-users-profile/
+    *           The data is implicitly shared: copies are cheap.
+    *           The default constructor builds an empty user. It is only needed for the meta type system.
     ***************************************************************************************************/
     class User
     {
         public:
+            User();
             User(const QJsonObject &json);
+            explicit User(QDataStream &stream);
+            User(const User &other);
+            User(User &&other) noexcept;
+            ~User();
+
+            User &operator=(const User &other);
+            User &operator=(User &&other) noexcept;
+
+            void serialize(QDataStream &stream) const;
 
             const QString   &getCountry()     const;
             const QString   &getDisplayName() const;
@@ -28,16 +45,11 @@ namespace Qtify
             const QString   &getSpotifyUri()  const;
 
         private:
-            QString country;
-            QString display_name;
-            QString email;
-            QString href;
-            QString id;
-            QString product;
-            QString type;
-            QString uri;
+            QSharedDataPointer<UserData> d;
 
     };
 }
 
+Q_DECLARE_METATYPE(Qtify::User)
+
 #endif // USER_H
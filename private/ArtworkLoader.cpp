@@ -0,0 +1,312 @@
+#include "ArtworkLoader.h"
+
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QNetworkRequest>
+#include <QRunnable>
+#include <QDebug>
+
+#include <algorithm>
+#include <functional>
+
+namespace Qtify
+{
+    /// Number of threads decoding images.
+    const int ARTWORK_DECODE_THREAD_COUNT{2};
+
+    /** ************************************************************************************************
+    * @class    ArtworkDecodeTask
+    *
+    * @brief    Decode a downloaded image on the thread pool and hand it back to the loader thread.
+    ***************************************************************************************************/
+    class ArtworkDecodeTask : public QRunnable
+    {
+        public:
+            ArtworkDecodeTask(ArtworkLoader *loader, const QString &url, const QByteArray &data):
+                m_loader(loader),
+                m_url(url),
+                m_data(data)
+            {
+
+            }
+
+            void run() override
+            {
+                const QImage image = QImage::fromData(m_data);
+                if (image.isNull())
+                {
+                    qWarning() << "Cannot decode artwork" << m_url;
+                }
+
+                // The loader waits for the pool before being destroyed, so it is still alive.
+                QMetaObject::invokeMethod(m_loader, std::bind(&ArtworkLoader::onImageDecoded, m_loader, m_url, image),
+                                          Qt::QueuedConnection);
+            }
+
+        private:
+            ArtworkLoader *m_loader;
+            QString m_url;
+            QByteArray m_data;
+    };
+
+    /** ************************************************************************************************
+    * @brief        Constructor.
+    *
+    * @param[in]    maxSize: The budget of the cache of decoded images, in bytes.
+    ***************************************************************************************************/
+    ArtworkLoader::ArtworkLoader(int maxSize, QObject *parent) :
+        QObject(parent),
+        m_cache(std::max(maxSize, 0))
+    {
+        m_decodePool.setMaxThreadCount(ARTWORK_DECODE_THREAD_COUNT);
+        updateStatistics();
+    }
+
+    /** ************************************************************************************************
+    * @brief        Destructor.
+    *
+    * @details      Wait for the images being decoded, as their tasks refer to the loader.
+    ***************************************************************************************************/
+    ArtworkLoader::~ArtworkLoader()
+    {
+        m_decodePool.waitForDone();
+    }
+
+    /** ************************************************************************************************
+    * @brief        Set the network access manager used for the downloads. It must live in the thread of
+    *               the loader.
+    ***************************************************************************************************/
+    void ArtworkLoader::setNetworkAccessManager(QNetworkAccessManager *networkAccessManager)
+    {
+        m_networkAccessManager = networkAccessManager;
+    }
+
+    /** ************************************************************************************************
+    * @brief        Change the budget of the cache. Images are evicted if needed.
+    ***************************************************************************************************/
+    void ArtworkLoader::setMaxSize(int maxSize)
+    {
+        const int count = m_cache.count();
+        m_cache.setMaxCost(std::max(maxSize, 0));
+
+        QMutexLocker locker(&m_statisticsMutex);
+        m_statistics.evictions += count - m_cache.count();
+        locker.unlock();
+
+        updateStatistics();
+    }
+
+    /** ************************************************************************************************
+    * @brief        Get the artwork of an album, at least as large as the given size if possible.
+    *
+    * @details      artworkAvailable is emitted when the image is ready, immediately if it is cached. The
+    *               image is null if the album has no image or if it cannot be downloaded or decoded.
+    *
+    * @param[in]    albumId: The id of the album, passed back with the image.
+    * @param[in]    images: The images of the album.
+    * @param[in]    size: The size at which the image is displayed.
+    ***************************************************************************************************/
+    void ArtworkLoader::load(const QString &albumId, const std::vector<Image> &images, const QSize &size)
+    {
+        const Image *image = selectImage(images, size);
+        if (!image)
+        {
+            emit artworkAvailable(albumId, size, QImage());
+            return;
+        }
+
+        const QString &url = image->getUrl();
+        const QImage *cachedImage = m_cache.object(url);
+
+        QMutexLocker locker(&m_statisticsMutex);
+        if (cachedImage)
+        {
+            ++m_statistics.hits;
+            locker.unlock();
+
+            emit artworkAvailable(albumId, size, *cachedImage);
+            return;
+        }
+
+        ++m_statistics.misses;
+        locker.unlock();
+
+        const bool pending = m_pendingImages.contains(url);
+        m_pendingImages[url].append({albumId, size});
+        if (!pending)
+        {
+            fetch(url);
+        }
+    }
+
+    /** ************************************************************************************************
+    * @brief        Download and decode the artwork of an album ahead of its display, without emitting
+    *               it. A later load of the same size is answered from the cache.
+    ***************************************************************************************************/
+    void ArtworkLoader::prefetch(const std::vector<Image> &images, const QSize &size)
+    {
+        const Image *image = selectImage(images, size);
+        if (!image || m_cache.contains(image->getUrl()) || m_pendingImages.contains(image->getUrl()))
+        {
+            return;
+        }
+
+        m_pendingImages.insert(image->getUrl(), QList<Waiter>());
+        fetch(image->getUrl());
+    }
+
+    /** ************************************************************************************************
+    * @brief        Abort the downloads in progress. Their loads are dropped.
+    ***************************************************************************************************/
+    void ArtworkLoader::abort()
+    {
+        for (QNetworkReply *reply : m_activeReplies.keys())
+        {
+            reply->disconnect(this);
+            reply->abort();
+            reply->deleteLater();
+        }
+        m_activeReplies.clear();
+        m_pendingImages.clear();
+    }
+
+    /** ************************************************************************************************
+    * @brief        Get the usage of the cache of decoded images.
+    *
+    * @details      This can be called from any thread.
+    ***************************************************************************************************/
+    CacheStatistics ArtworkLoader::getStatistics() const
+    {
+        QMutexLocker locker(&m_statisticsMutex);
+        return m_statistics;
+    }
+
+    /** ************************************************************************************************
+    * @brief        Select the smallest image covering the given size.
+    *
+    * @details      If no image is large enough, the largest one is selected, as it is the closest to the
+    *               requested size.
+    *
+    * @return       The selected image, nullptr if there is no image.
+    ***************************************************************************************************/
+    const Image *ArtworkLoader::selectImage(const std::vector<Image> &images, const QSize &size)
+    {
+        const Image *smallestCovering = nullptr;
+        const Image *largest = nullptr;
+
+        for (const Image &image : images)
+        {
+            const qint64 area = static_cast<qint64>(image.getWidth()) * image.getHeight();
+
+            if (!largest || area > static_cast<qint64>(largest->getWidth()) * largest->getHeight())
+            {
+                largest = &image;
+            }
+
+            if (image.getWidth() >= size.width() && image.getHeight() >= size.height()
+                && (!smallestCovering
+                    || area < static_cast<qint64>(smallestCovering->getWidth()) * smallestCovering->getHeight()))
+            {
+                smallestCovering = &image;
+            }
+        }
+
+        return smallestCovering ? smallestCovering : largest;
+    }
+
+    /** ************************************************************************************************
+    * @brief        Start the download of an image.
+    ***************************************************************************************************/
+    void ArtworkLoader::fetch(const QString &url)
+    {
+        if (!m_networkAccessManager)
+        {
+            complete(url, QImage());
+            return;
+        }
+
+        QNetworkRequest request{QUrl(url)};
+        request.setAttribute(QNetworkRequest::Http2AllowedAttribute, true);
+        request.setAttribute(QNetworkRequest::RedirectPolicyAttribute, QNetworkRequest::NoLessSafeRedirectPolicy);
+
+        QNetworkReply *reply = m_networkAccessManager->get(request);
+        m_activeReplies.insert(reply, url);
+        connect(reply, &QNetworkReply::finished, this, &ArtworkLoader::onReplyReceived);
+    }
+
+    /** ************************************************************************************************
+    * @brief        Cache a decoded image and pass it to the loads waiting for it.
+    *
+    * @param[in]    image: The decoded image, null if it could not be downloaded or decoded.
+    ***************************************************************************************************/
+    void ArtworkLoader::complete(const QString &url, const QImage &image)
+    {
+        if (image.sizeInBytes() > m_cache.maxCost())
+        {
+            QMutexLocker locker(&m_statisticsMutex);
+            ++m_statistics.rejections;
+        }
+        else if (!image.isNull())
+        {
+            const int count = m_cache.count() - (m_cache.contains(url) ? 1 : 0);
+            m_cache.insert(url, new QImage(image), static_cast<int>(image.sizeInBytes()));
+
+            QMutexLocker locker(&m_statisticsMutex);
+            m_statistics.evictions += std::max(count + 1 - m_cache.count(), 0);
+            locker.unlock();
+
+            updateStatistics();
+        }
+
+        const QList<Waiter> waiters = m_pendingImages.take(url);
+        for (const Waiter &waiter : waiters)
+        {
+            emit artworkAvailable(waiter.albumId, waiter.size, image);
+        }
+    }
+
+    /** ************************************************************************************************
+    * @brief        Function called when an image is downloaded. It is decoded on the thread pool.
+    ***************************************************************************************************/
+    void ArtworkLoader::onReplyReceived()
+    {
+        QNetworkReply *reply = qobject_cast<QNetworkReply*>(QObject::sender());
+        if (!reply || !m_activeReplies.contains(reply))
+        {
+            return;
+        }
+
+        const QString url = m_activeReplies.take(reply);
+
+        if (reply->error() != QNetworkReply::NoError)
+        {
+            qWarning() << "Cannot download artwork" << url << ":" << reply->errorString();
+            complete(url, QImage());
+        }
+        else
+        {
+            m_decodePool.start(new ArtworkDecodeTask(this, url, reply->readAll()));
+        }
+
+        reply->deleteLater();
+    }
+
+    /** ************************************************************************************************
+    * @brief        Function called in the loader thread when an image is decoded.
+    ***************************************************************************************************/
+    void ArtworkLoader::onImageDecoded(const QString &url, const QImage &image)
+    {
+        complete(url, image);
+    }
+
+    /** ************************************************************************************************
+    * @brief        Copy the current content and budget of the cache to the statistics.
+    ***************************************************************************************************/
+    void ArtworkLoader::updateStatistics()
+    {
+        QMutexLocker locker(&m_statisticsMutex);
+        m_statistics.count   = m_cache.count();
+        m_statistics.size    = m_cache.totalCost();
+        m_statistics.maxSize = m_cache.maxCost();
+    }
+}
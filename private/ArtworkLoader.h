@@ -0,0 +1,98 @@
+#ifndef ARTWORKLOADER_H
+#define ARTWORKLOADER_H
+
+#include <vector>
+
+#include <QObject>
+#include <QCache>
+#include <QHash>
+#include <QImage>
+#include <QList>
+#include <QMutex>
+#include <QSize>
+#include <QString>
+#include <QThreadPool>
+
+#include "models/Image.h"
+#include "RequestStatistics.h"
+
+class QNetworkAccessManager;
+class QNetworkReply;
+
+namespace Qtify
+{
+    class ArtworkDecodeTask;
+
+    /** ************************************************************************************************
+    * @class    ArtworkLoader
+    *
+    * @brief    Download, decode and cache of album artwork.
+    *
+    * @details  Of the images of an album, the smallest one covering the requested size is downloaded.
+    *           Images are downloaded with the network access manager of the worker and decoded on a
+    *           thread pool, so that neither the worker nor the GUI thread is blocked. Decoded images
+    *           are kept in a cache bounded by their size in bytes, the least recently used ones being
+    *           evicted first. An image requested again while it is downloaded or decoded is not
+    *           fetched twice.
+    *           Statistics can be read from any thread, everything else must be called from the thread
+    *           owning the loader.
+    ***************************************************************************************************/
+    class ArtworkLoader : public QObject
+    {
+        Q_OBJECT
+
+        friend class ArtworkDecodeTask;
+
+        public:
+            explicit ArtworkLoader(int maxSize, QObject *parent = nullptr);
+            ~ArtworkLoader();
+
+            void setNetworkAccessManager(QNetworkAccessManager *networkAccessManager);
+            void setMaxSize(int maxSize);
+
+            void load(const QString &albumId, const std::vector<Image> &images, const QSize &size);
+            void prefetch(const std::vector<Image> &images, const QSize &size);
+            void abort();
+
+            CacheStatistics getStatistics() const;
+
+            static const Image *selectImage(const std::vector<Image> &images, const QSize &size);
+
+        signals:
+            void artworkAvailable(const QString &albumId, const QSize &size, const QImage &image);
+
+        private:
+            /** ****************************************************************************************
+            * @struct   Waiter
+            *
+            * @brief    A load waiting for an image to be downloaded and decoded.
+            *******************************************************************************************/
+            struct Waiter
+            {
+                QString albumId;
+                QSize size;
+            };
+
+            void fetch(const QString &url);
+            void complete(const QString &url, const QImage &image);
+            void onReplyReceived();
+            void onImageDecoded(const QString &url, const QImage &image);
+            void updateStatistics();
+
+            QNetworkAccessManager *m_networkAccessManager = nullptr;
+            // Downloads in progress, with the URL of their image.
+            QHash<QNetworkReply*, QString> m_activeReplies;
+            // Loads waiting for each image being downloaded or decoded, by URL. Prefetched images may
+            // have no waiter.
+            QHash<QString, QList<Waiter>> m_pendingImages;
+            // Decoded images, by URL.
+            QCache<QString, QImage> m_cache;
+            // Protects m_statistics, read from other threads.
+            mutable QMutex m_statisticsMutex;
+            CacheStatistics m_statistics;
+            // Threads decoding the downloaded images.
+            QThreadPool m_decodePool;
+    };
+}
+
+#endif // ARTWORKLOADER_H
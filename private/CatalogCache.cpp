@@ -0,0 +1,365 @@
+#include "CatalogCache.h"
+
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QtEndian>
+#include <QDebug>
+
+#include <algorithm>
+#include <vector>
+
+namespace Qtify
+{
+    /// Start of the file: magic string and format version.
+    const QByteArray CATALOG_CACHE_MAGIC{"QTFYCACH"};
+    const quint32    CATALOG_CACHE_VERSION{1};
+    const qint64     CATALOG_CACHE_HEADER_SIZE{12};
+    /// Size of a record header: record size (32 bits), expiration (64 bits) and key size (16 bits).
+    const qint64     CATALOG_CACHE_RECORD_HEADER_SIZE{14};
+    /// Part of the maximum size kept by a compaction, the rest is left for new records.
+    const double     CATALOG_CACHE_COMPACTED_RATIO{0.75};
+
+    /** ************************************************************************************************
+    * @brief        Destructor.
+    ***************************************************************************************************/
+    CatalogCache::~CatalogCache()
+    {
+        close();
+    }
+
+    /** ************************************************************************************************
+    * @brief        Open the cache file, creating it if needed.
+    *
+    * @details      A file with another format version is discarded. A record truncated by a crash while
+    *               it was written is removed.
+    *
+    * @param[in]    path: The path of the cache file.
+    * @param[in]    maxSize: The size of the file over which it is compacted.
+    * @param[in]    timeToLive: The time after which a record expires.
+    *
+    * @return       True if the cache is usable.
+    ***************************************************************************************************/
+    bool CatalogCache::open(const QString &path, qint64 maxSize, std::chrono::seconds timeToLive)
+    {
+        close();
+
+        m_maxSize    = maxSize;
+        m_timeToLive = timeToLive;
+
+        QDir().mkpath(QFileInfo(path).absolutePath());
+        m_file.setFileName(path);
+        if (!m_file.open(QIODevice::ReadWrite))
+        {
+            qWarning() << "Cannot open catalog cache" << path << ":" << m_file.errorString();
+            return false;
+        }
+
+        if (!load())
+        {
+            // Unknown or corrupted file: start a new one.
+            unmap();
+            m_records.clear();
+            m_liveSize = 0;
+
+            QByteArray header(CATALOG_CACHE_MAGIC);
+            header.resize(CATALOG_CACHE_HEADER_SIZE);
+            qToLittleEndian<quint32>(CATALOG_CACHE_VERSION, header.data() + CATALOG_CACHE_MAGIC.size());
+
+            if (!m_file.resize(0) || m_file.write(header) != header.size() || !m_file.flush())
+            {
+                qWarning() << "Cannot initialize catalog cache" << path << ":" << m_file.errorString();
+                close();
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    /** ************************************************************************************************
+    * @brief        Close the cache file.
+    ***************************************************************************************************/
+    void CatalogCache::close()
+    {
+        unmap();
+        m_file.close();
+        m_records.clear();
+        m_liveSize = 0;
+    }
+
+    /** ************************************************************************************************
+    * @brief        Check if a cache file is open.
+    ***************************************************************************************************/
+    bool CatalogCache::isOpen() const
+    {
+        return m_file.isOpen();
+    }
+
+    /** ************************************************************************************************
+    * @brief        Get the data stored for the given key.
+    *
+    * @return       The data, empty if the key is unknown or its record has expired.
+    ***************************************************************************************************/
+    QByteArray CatalogCache::find(const QString &key)
+    {
+        auto iterator = m_records.find(key);
+        if (iterator == m_records.end())
+        {
+            return QByteArray();
+        }
+
+        const Record record = iterator.value();
+        if (record.expiresAt <= QDateTime::currentMSecsSinceEpoch())
+        {
+            m_liveSize -= record.size;
+            m_records.erase(iterator);
+            return QByteArray();
+        }
+
+        // The record may have been appended after the file was mapped.
+        if (record.offset + record.size > m_mapSize && !map())
+        {
+            return QByteArray();
+        }
+
+        return QByteArray(reinterpret_cast<const char*>(m_map + record.dataOffset), static_cast<int>(record.dataSize));
+    }
+
+    /** ************************************************************************************************
+    * @brief        Store data for the given key, replacing the previous data.
+    ***************************************************************************************************/
+    void CatalogCache::insert(const QString &key, const QByteArray &data)
+    {
+        if (!isOpen())
+        {
+            return;
+        }
+
+        append(key, data, QDateTime::currentMSecsSinceEpoch()
+                          + std::chrono::duration_cast<std::chrono::milliseconds>(m_timeToLive).count());
+    }
+
+    /** ************************************************************************************************
+    * @brief        Remove the data stored for the given key.
+    *
+    * @details      An expired record is appended so that the removal survives a reopening: loading an
+    *               expired record drops the earlier records of its key.
+    ***************************************************************************************************/
+    void CatalogCache::remove(const QString &key)
+    {
+        if (!isOpen() || !m_records.contains(key))
+        {
+            return;
+        }
+
+        append(key, QByteArray(), 0);
+    }
+
+    /** ************************************************************************************************
+    * @brief        Append a record to the file and index it if it has not expired.
+    ***************************************************************************************************/
+    void CatalogCache::append(const QString &key, const QByteArray &data, qint64 expiresAt)
+    {
+        const QByteArray keyData = key.toUtf8();
+        const qint64 recordSize = CATALOG_CACHE_RECORD_HEADER_SIZE + keyData.size() + data.size();
+
+        QByteArray recordData(static_cast<int>(CATALOG_CACHE_RECORD_HEADER_SIZE), Qt::Uninitialized);
+        qToLittleEndian<quint32>(static_cast<quint32>(recordSize), recordData.data());
+        qToLittleEndian<qint64>(expiresAt, recordData.data() + 4);
+        qToLittleEndian<quint16>(static_cast<quint16>(keyData.size()), recordData.data() + 12);
+        recordData += keyData;
+        recordData += data;
+
+        const qint64 offset = m_file.size();
+        if (!m_file.seek(offset) || m_file.write(recordData) != recordData.size() || !m_file.flush())
+        {
+            qWarning() << "Cannot write catalog cache:" << m_file.errorString();
+            return;
+        }
+
+        auto iterator = m_records.find(key);
+        if (iterator != m_records.end())
+        {
+            m_liveSize -= iterator->size;
+            m_records.erase(iterator);
+        }
+
+        if (expiresAt > QDateTime::currentMSecsSinceEpoch())
+        {
+            m_records.insert(key, {offset, recordSize, expiresAt,
+                                   offset + CATALOG_CACHE_RECORD_HEADER_SIZE + keyData.size(), data.size()});
+            m_liveSize += recordSize;
+        }
+
+        if (m_file.size() > m_maxSize)
+        {
+            compact();
+        }
+    }
+
+    /** ************************************************************************************************
+    * @brief        Rewrite the file with only the latest unexpired records.
+    *
+    * @details      If they still take more than CATALOG_CACHE_COMPACTED_RATIO of the maximum size, the
+    *               records expiring first (the oldest) are dropped. The new file replaces the old one
+    *               atomically.
+    ***************************************************************************************************/
+    void CatalogCache::compact()
+    {
+        if (!isOpen() || (m_file.size() > m_mapSize && !map()))
+        {
+            return;
+        }
+
+        const qint64 now = QDateTime::currentMSecsSinceEpoch();
+        std::vector<Record> records;
+        records.reserve(static_cast<size_t>(m_records.size()));
+        for (const Record &record : m_records)
+        {
+            if (record.expiresAt > now)
+            {
+                records.push_back(record);
+            }
+        }
+
+        // Drop the oldest records to leave room for new ones.
+        std::sort(records.begin(), records.end(),
+                  [](const Record &a, const Record &b) { return a.expiresAt > b.expiresAt; });
+
+        const qint64 targetSize = static_cast<qint64>(m_maxSize * CATALOG_CACHE_COMPACTED_RATIO);
+        qint64 size = CATALOG_CACHE_HEADER_SIZE;
+        size_t kept = 0;
+        while (kept < records.size() && size + records[kept].size <= targetSize)
+        {
+            size += records[kept].size;
+            ++kept;
+        }
+        records.resize(kept);
+
+        // Keep the records in file order.
+        std::sort(records.begin(), records.end(),
+                  [](const Record &a, const Record &b) { return a.offset < b.offset; });
+
+        QSaveFile file(m_file.fileName());
+        if (!file.open(QIODevice::WriteOnly))
+        {
+            qWarning() << "Cannot compact catalog cache:" << file.errorString();
+            return;
+        }
+
+        file.write(reinterpret_cast<const char*>(m_map), CATALOG_CACHE_HEADER_SIZE);
+        for (const Record &record : records)
+        {
+            file.write(reinterpret_cast<const char*>(m_map + record.offset), record.size);
+        }
+
+        // The old file must be released before it is replaced.
+        const QString path = m_file.fileName();
+        close();
+
+        if (!file.commit())
+        {
+            qWarning() << "Cannot compact catalog cache:" << file.errorString();
+        }
+
+        open(path, m_maxSize, m_timeToLive);
+    }
+
+    /** ************************************************************************************************
+    * @brief        Map the file and build the index of its records.
+    *
+    * @return       False if the file is not a cache file of the current version.
+    ***************************************************************************************************/
+    bool CatalogCache::load()
+    {
+        if (m_file.size() < CATALOG_CACHE_HEADER_SIZE || !map())
+        {
+            return false;
+        }
+
+        if (QByteArray::fromRawData(reinterpret_cast<const char*>(m_map), CATALOG_CACHE_MAGIC.size()) != CATALOG_CACHE_MAGIC
+            || qFromLittleEndian<quint32>(m_map + CATALOG_CACHE_MAGIC.size()) != CATALOG_CACHE_VERSION)
+        {
+            return false;
+        }
+
+        const qint64 now = QDateTime::currentMSecsSinceEpoch();
+        qint64 offset = CATALOG_CACHE_HEADER_SIZE;
+
+        while (offset + CATALOG_CACHE_RECORD_HEADER_SIZE <= m_mapSize)
+        {
+            const uchar *header = m_map + offset;
+            const qint64 recordSize = qFromLittleEndian<quint32>(header);
+            const qint64 expiresAt  = qFromLittleEndian<qint64>(header + 4);
+            const qint64 keySize    = qFromLittleEndian<quint16>(header + 12);
+
+            if (recordSize < CATALOG_CACHE_RECORD_HEADER_SIZE + keySize || offset + recordSize > m_mapSize)
+            {
+                break;
+            }
+
+            const QString key = QString::fromUtf8(reinterpret_cast<const char*>(header + CATALOG_CACHE_RECORD_HEADER_SIZE),
+                                                  static_cast<int>(keySize));
+
+            auto iterator = m_records.find(key);
+            if (iterator != m_records.end())
+            {
+                m_liveSize -= iterator->size;
+                m_records.erase(iterator);
+            }
+
+            if (expiresAt > now)
+            {
+                const qint64 dataOffset = offset + CATALOG_CACHE_RECORD_HEADER_SIZE + keySize;
+                m_records.insert(key, {offset, recordSize, expiresAt, dataOffset, offset + recordSize - dataOffset});
+                m_liveSize += recordSize;
+            }
+
+            offset += recordSize;
+        }
+
+        // Remove a record truncated while it was written.
+        if (offset < m_mapSize)
+        {
+            unmap();
+            m_file.resize(offset);
+            map();
+        }
+
+        return true;
+    }
+
+    /** ************************************************************************************************
+    * @brief        Map the whole file, replacing the previous mapping.
+    ***************************************************************************************************/
+    bool CatalogCache::map()
+    {
+        unmap();
+
+        const qint64 size = m_file.size();
+        m_map = m_file.map(0, size);
+        if (!m_map)
+        {
+            qWarning() << "Cannot map catalog cache:" << m_file.errorString();
+            return false;
+        }
+
+        m_mapSize = size;
+        return true;
+    }
+
+    /** ************************************************************************************************
+    * @brief        Remove the mapping of the file.
+    ***************************************************************************************************/
+    void CatalogCache::unmap()
+    {
+        if (m_map)
+        {
+            m_file.unmap(m_map);
+            m_map = nullptr;
+            m_mapSize = 0;
+        }
+    }
+}
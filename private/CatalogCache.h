@@ -0,0 +1,75 @@
+#ifndef CATALOGCACHE_H
+#define CATALOGCACHE_H
+
+#include <chrono>
+
+#include <QByteArray>
+#include <QFile>
+#include <QHash>
+#include <QString>
+
+namespace Qtify
+{
+    /** ************************************************************************************************
+    * @class    CatalogCache
+    *
+    * @brief    Persistent cache of catalog objects in a memory-mapped file.
+    *
+    * @details  The file is an append-only log of records: each insertion appends a record, and the
+    *           latest record of a key wins. An index of the records is built when the file is opened,
+    *           and lookups read the records through the mapping without any copy of the whole file.
+    *           Records expire after a time to live. When the file grows over its maximum size, it is
+    *           compacted: only the unexpired latest records are kept, and the oldest ones are dropped
+    *           if needed to leave room for new records.
+    ***************************************************************************************************/
+    class CatalogCache
+    {
+        public:
+            CatalogCache() = default;
+            ~CatalogCache();
+
+            bool open(const QString &path, qint64 maxSize, std::chrono::seconds timeToLive);
+            void close();
+            bool isOpen() const;
+
+            QByteArray find(const QString &key);
+            void insert(const QString &key, const QByteArray &data);
+            void remove(const QString &key);
+            void compact();
+
+        private:
+            void append(const QString &key, const QByteArray &data, qint64 expiresAt);
+
+            /** ****************************************************************************************
+            * @struct   Record
+            *
+            * @brief    Location of a record in the file.
+            *******************************************************************************************/
+            struct Record
+            {
+                qint64 offset;    // Offset of the record in the file.
+                qint64 size;      // Size of the record, header included.
+                qint64 expiresAt; // Expiration time in milliseconds since epoch.
+                qint64 dataOffset;
+                qint64 dataSize;
+            };
+
+            bool load();
+            bool map();
+            void unmap();
+
+            // The cache file, kept open for appending.
+            QFile m_file;
+            // Mapping of the file, which may not cover the last records appended.
+            uchar *m_map = nullptr;
+            qint64 m_mapSize = 0;
+            // Latest unexpired record of each key.
+            QHash<QString, Record> m_records;
+            // Total size of the records in m_records.
+            qint64 m_liveSize = 0;
+            qint64 m_maxSize = 0;
+            std::chrono::seconds m_timeToLive{0};
+    };
+}
+
+#endif // CATALOGCACHE_H
@@ -0,0 +1,125 @@
+#include "CatalogMemoryCache.h"
+
+#include <algorithm>
+
+namespace Qtify
+{
+    /** ************************************************************************************************
+    * @brief        Constructor.
+    *
+    * @param[in]    maxSize: The budget of the cache, in bytes.
+    ***************************************************************************************************/
+    CatalogMemoryCache::CatalogMemoryCache(int maxSize) :
+        m_cache(std::max(maxSize, 0))
+    {
+        updateStatistics();
+    }
+
+    /** ************************************************************************************************
+    * @brief        Change the budget of the cache. Objects are evicted if needed.
+    ***************************************************************************************************/
+    void CatalogMemoryCache::setMaxSize(int maxSize)
+    {
+        const int count = m_cache.count();
+        m_cache.setMaxCost(std::max(maxSize, 0));
+
+        QMutexLocker locker(&m_statisticsMutex);
+        m_statistics.evictions += count - m_cache.count();
+        locker.unlock();
+
+        updateStatistics();
+    }
+
+    /** ************************************************************************************************
+    * @brief        Get the object stored with the given key and mark it as the most recently used.
+    *
+    * @return       True if the object was found.
+    ***************************************************************************************************/
+    bool CatalogMemoryCache::find(const QString &key, QVariant &object)
+    {
+        const QVariant *cachedObject = m_cache.object(key);
+
+        QMutexLocker locker(&m_statisticsMutex);
+        if (!cachedObject)
+        {
+            ++m_statistics.misses;
+            return false;
+        }
+
+        ++m_statistics.hits;
+        object = *cachedObject;
+        return true;
+    }
+
+    /** ************************************************************************************************
+    * @brief        Store an object, replacing the previous object with the same key.
+    *
+    * @details      The least recently used objects are evicted to stay within the budget. An object
+    *               larger than the budget is not stored, and the previous object is removed.
+    *
+    * @param[in]    size: The estimated size of the object in bytes.
+    ***************************************************************************************************/
+    void CatalogMemoryCache::insert(const QString &key, const QVariant &object, int size)
+    {
+        if (size > m_cache.maxCost())
+        {
+            m_cache.remove(key);
+
+            QMutexLocker locker(&m_statisticsMutex);
+            ++m_statistics.rejections;
+            locker.unlock();
+
+            updateStatistics();
+            return;
+        }
+
+        const int count = m_cache.count() - (m_cache.contains(key) ? 1 : 0);
+        m_cache.insert(key, new QVariant(object), size);
+
+        QMutexLocker locker(&m_statisticsMutex);
+        m_statistics.evictions += std::max(count + 1 - m_cache.count(), 0);
+        locker.unlock();
+
+        updateStatistics();
+    }
+
+    /** ************************************************************************************************
+    * @brief        Remove the object stored with the given key, if any.
+    ***************************************************************************************************/
+    void CatalogMemoryCache::remove(const QString &key)
+    {
+        m_cache.remove(key);
+        updateStatistics();
+    }
+
+    /** ************************************************************************************************
+    * @brief        Remove all the objects.
+    ***************************************************************************************************/
+    void CatalogMemoryCache::clear()
+    {
+        m_cache.clear();
+        updateStatistics();
+    }
+
+    /** ************************************************************************************************
+    * @brief        Get the usage of the cache.
+    *
+    * @details      This can be called from any thread.
+    ***************************************************************************************************/
+    CacheStatistics CatalogMemoryCache::getStatistics() const
+    {
+        QMutexLocker locker(&m_statisticsMutex);
+        return m_statistics;
+    }
+
+    /** ************************************************************************************************
+    * @brief        Copy the current content and budget of the cache to the statistics.
+    ***************************************************************************************************/
+    void CatalogMemoryCache::updateStatistics()
+    {
+        QMutexLocker locker(&m_statisticsMutex);
+        m_statistics.count   = m_cache.count();
+        m_statistics.size    = m_cache.totalCost();
+        m_statistics.maxSize = m_cache.maxCost();
+    }
+}
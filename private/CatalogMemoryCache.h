@@ -0,0 +1,47 @@
+#ifndef CATALOGMEMORYCACHE_H
+#define CATALOGMEMORYCACHE_H
+
+#include <QCache>
+#include <QMutex>
+#include <QString>
+#include <QVariant>
+
+#include "RequestStatistics.h"
+
+namespace Qtify
+{
+    /** ************************************************************************************************
+    * @class    CatalogMemoryCache
+    *
+    * @brief    In-memory cache of parsed catalog objects, bounded by an estimated size in bytes.
+    *
+    * @details  The least recently used objects are evicted first. The objects are implicitly shared
+    *           models stored in a QVariant, so a lookup only copies a pointer.
+    *           Statistics can be read from any thread, everything else must be called from the thread
+    *           owning the cache.
+    ***************************************************************************************************/
+    class CatalogMemoryCache
+    {
+        public:
+            explicit CatalogMemoryCache(int maxSize);
+
+            void setMaxSize(int maxSize);
+
+            bool find(const QString &key, QVariant &object);
+            void insert(const QString &key, const QVariant &object, int size);
+            void remove(const QString &key);
+            void clear();
+
+            CacheStatistics getStatistics() const;
+
+        private:
+            void updateStatistics();
+
+            QCache<QString, QVariant> m_cache;
+            // Protects m_statistics, read from other threads.
+            mutable QMutex m_statisticsMutex;
+            CacheStatistics m_statistics;
+    };
+}
+
+#endif // CATALOGMEMORYCACHE_H
@@ -0,0 +1,249 @@
+#include "MetricsExporter.h"
+
+#include <QHostAddress>
+#include <QTcpSocket>
+#include <QDebug>
+
+namespace Qtify
+{
+    /// Maximum size of a request, larger requests are dropped.
+    const int METRICS_REQUEST_MAX_SIZE{8 * 1024};
+    /// Path of the metrics, as expected by Prometheus.
+    const QByteArray METRICS_PATH{"/metrics"};
+
+    /** ************************************************************************************************
+    * @brief        Constructor.
+    *
+    * @param[in]    collector: The function building the text of the metrics.
+    ***************************************************************************************************/
+    MetricsExporter::MetricsExporter(Collector collector, QObject *parent) :
+        QObject(parent),
+        m_server(this),
+        m_collector(std::move(collector))
+    {
+        connect(&m_server, &QTcpServer::newConnection, this, &MetricsExporter::onNewConnection);
+    }
+
+    /** ************************************************************************************************
+    * @brief        Start listening on the given port of the loopback interface.
+    *
+    * @return       True if the port could be opened.
+    ***************************************************************************************************/
+    bool MetricsExporter::listen(quint16 port)
+    {
+        close();
+
+        if (!m_server.listen(QHostAddress::LocalHost, port))
+        {
+            qWarning() << "Cannot serve metrics on port" << port << ":" << m_server.errorString();
+            return false;
+        }
+
+        return true;
+    }
+
+    /** ************************************************************************************************
+    * @brief        Stop listening and close the open connections.
+    ***************************************************************************************************/
+    void MetricsExporter::close()
+    {
+        m_server.close();
+
+        for (QTcpSocket *socket : m_requests.keys())
+        {
+            socket->disconnect(this);
+            socket->abort();
+            socket->deleteLater();
+        }
+        m_requests.clear();
+    }
+
+    /** ************************************************************************************************
+    * @brief        Check if the exporter is listening.
+    ***************************************************************************************************/
+    bool MetricsExporter::isListening() const
+    {
+        return m_server.isListening();
+    }
+
+    /** ************************************************************************************************
+    * @brief        Build a label, escaping its value.
+    ***************************************************************************************************/
+    QString MetricsExporter::label(const QString &name, const QString &value)
+    {
+        QString escapedValue = value;
+        escapedValue.replace('\\', "\\\\").replace('"', "\\\"").replace('\n', "\\n");
+
+        return name + "=\"" + escapedValue + '"';
+    }
+
+    /** ************************************************************************************************
+    * @brief        Function called when a client connects.
+    ***************************************************************************************************/
+    void MetricsExporter::onNewConnection()
+    {
+        while (QTcpSocket *socket = m_server.nextPendingConnection())
+        {
+            m_requests.insert(socket, QByteArray());
+            connect(socket, &QTcpSocket::readyRead, this, &MetricsExporter::onReadyRead);
+            connect(socket, &QTcpSocket::disconnected, this, [this, socket]()
+            {
+                m_requests.remove(socket);
+                socket->deleteLater();
+            });
+        }
+    }
+
+    /** ************************************************************************************************
+    * @brief        Function called when data is received from a client.
+    *
+    * @details      Once the request headers are complete, the metrics are sent if the request is a GET
+    *               of the metrics path, and the connection is closed.
+    ***************************************************************************************************/
+    void MetricsExporter::onReadyRead()
+    {
+        QTcpSocket *socket = qobject_cast<QTcpSocket*>(QObject::sender());
+        if (!socket || !m_requests.contains(socket))
+        {
+            return;
+        }
+
+        QByteArray &request = m_requests[socket];
+        request += socket->readAll();
+
+        if (request.size() > METRICS_REQUEST_MAX_SIZE)
+        {
+            socket->abort();
+            return;
+        }
+
+        if (!request.contains("\r\n\r\n"))
+        {
+            return;
+        }
+
+        // Request line: method, path and protocol.
+        const QList<QByteArray> requestLine = request.left(request.indexOf("\r\n")).split(' ');
+        const QByteArray path = requestLine.value(1).split('?').first();
+
+        QByteArray status;
+        QByteArray headers;
+        QByteArray body;
+
+        if (requestLine.value(0) != "GET")
+        {
+            status  = "405 Method Not Allowed";
+            headers = "Allow: GET\r\n";
+        }
+        else if (path != METRICS_PATH && path != "/")
+        {
+            status = "404 Not Found";
+        }
+        else
+        {
+            status  = "200 OK";
+            headers = "Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n";
+            body    = m_collector();
+        }
+
+        socket->write("HTTP/1.1 " + status + "\r\n" + headers
+                      + "Content-Length: " + QByteArray::number(body.size()) + "\r\n"
+                      + "Connection: close\r\n\r\n" + body);
+        socket->disconnectFromHost();
+    }
+
+    /** ************************************************************************************************
+    * @brief        Set the labels added to the samples written from now on.
+    *
+    * @param[in]    labels: The labels built with MetricsExporter::label(), separated by commas. Can be
+    *               empty.
+    ***************************************************************************************************/
+    void MetricFamilies::setLabels(const QString &labels)
+    {
+        m_labels = labels;
+    }
+
+    /** ************************************************************************************************
+    * @brief        Start writing the samples of a metric. Its HELP and TYPE lines are only written the
+    *               first time.
+    ***************************************************************************************************/
+    void MetricFamilies::writeHeader(const QString &name, const QString &type, const QString &help)
+    {
+        const auto iterator = m_indexes.constFind(name);
+        if (iterator != m_indexes.cend())
+        {
+            m_current = iterator.value();
+            return;
+        }
+
+        Family family;
+        family.header += "# HELP " + name.toUtf8() + ' ' + help.toUtf8() + '\n';
+        family.header += "# TYPE " + name.toUtf8() + ' ' + type.toUtf8() + '\n';
+
+        m_current = m_families.size();
+        m_indexes.insert(name, m_current);
+        m_families.push_back(family);
+    }
+
+    /** ************************************************************************************************
+    * @brief        Append a sample to the metric of the last header.
+    *
+    * @param[in]    labels: The labels built with MetricsExporter::label(), separated by commas. Can be
+    *               empty.
+    ***************************************************************************************************/
+    void MetricFamilies::writeSample(const QString &name, const QString &labels, double value)
+    {
+        if (m_current >= m_families.size())
+        {
+            qWarning() << "Sample of metric" << name << "written without header";
+            return;
+        }
+
+        const QString allLabels = m_labels.isEmpty() || labels.isEmpty() ? m_labels + labels
+                                                                         : m_labels + ',' + labels;
+        QByteArray &text = m_families[m_current].samples;
+
+        text += name.toUtf8();
+        if (!allLabels.isEmpty())
+        {
+            text += '{' + allLabels.toUtf8() + '}';
+        }
+        text += ' ' + QByteArray::number(value, 'g', 15) + '\n';
+    }
+
+    /** ************************************************************************************************
+    * @brief        Append the samples of a histogram: cumulative buckets in seconds, sum and count.
+    ***************************************************************************************************/
+    void MetricFamilies::writeHistogram(const QString &name, const QString &labels, const LatencyHistogram &histogram)
+    {
+        const QString separator = labels.isEmpty() ? QString() : QStringLiteral(",");
+        int cumulativeCount = 0;
+
+        for (int bucket = 0; bucket < LATENCY_HISTOGRAM_BUCKET_COUNT; ++bucket)
+        {
+            cumulativeCount += histogram.buckets[bucket];
+
+            const QString bound = bucket < LATENCY_HISTOGRAM_BUCKET_COUNT - 1
+                                  ? QString::number(LATENCY_HISTOGRAM_BOUNDS[bucket] / 1e6, 'g', 15)
+                                  : QStringLiteral("+Inf");
+            writeSample(name + "_bucket", labels + separator + MetricsExporter::label("le", bound), cumulativeCount);
+        }
+
+        writeSample(name + "_sum", labels, histogram.totalMicroseconds / 1e6);
+        writeSample(name + "_count", labels, histogram.count);
+    }
+
+    /** ************************************************************************************************
+    * @brief        Get the text of all the metrics, each one with its header followed by its samples.
+    ***************************************************************************************************/
+    QByteArray MetricFamilies::toText() const
+    {
+        QByteArray text;
+        for (const Family &family : m_families)
+        {
+            text += family.header + family.samples;
+        }
+
+        return text;
+    }
+}
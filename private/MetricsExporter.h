@@ -0,0 +1,98 @@
+#ifndef METRICSEXPORTER_H
+#define METRICSEXPORTER_H
+
+#include <functional>
+#include <vector>
+
+#include <QObject>
+#include <QByteArray>
+#include <QHash>
+#include <QString>
+#include <QTcpServer>
+
+#include "RequestStatistics.h"
+
+class QTcpSocket;
+
+namespace Qtify
+{
+    /** ************************************************************************************************
+    * @class    MetricFamilies
+    *
+    * @brief    Text of metrics in the Prometheus text format, grouped by metric.
+    *
+    * @details  The samples of a metric are appended after the last call to writeHeader() with its name.
+    *           A metric written again, for example by another handler, gets the new samples after the
+    *           previous ones, so that its HELP and TYPE lines appear once as the format requires.
+    *           The labels given to setLabels() are added to every sample written after the call.
+    ***************************************************************************************************/
+    class MetricFamilies
+    {
+        public:
+            void setLabels(const QString &labels);
+
+            void writeHeader(const QString &name, const QString &type, const QString &help);
+            void writeSample(const QString &name, const QString &labels, double value);
+            void writeHistogram(const QString &name, const QString &labels, const LatencyHistogram &histogram);
+
+            QByteArray toText() const;
+
+        private:
+            /** ****************************************************************************************
+            * @struct   Family
+            *
+            * @brief    The header and samples of a metric.
+            *******************************************************************************************/
+            struct Family
+            {
+                QByteArray header;
+                QByteArray samples;
+            };
+
+            // Metrics in the order of their first header.
+            std::vector<Family> m_families;
+            // Index in m_families of each metric, by name.
+            QHash<QString, size_t> m_indexes;
+            // Index of the metric receiving the samples.
+            size_t m_current = 0;
+            // Labels added to every sample.
+            QString m_labels;
+    };
+
+    /** ************************************************************************************************
+    * @class    MetricsExporter
+    *
+    * @brief    Minimal HTTP server exposing metrics in the Prometheus text format.
+    *
+    * @details  The server only listens on the loopback interface. Every GET request is answered with
+    *           the text built by the collector, then the connection is closed. The collector is called
+    *           in the thread of the exporter, so it can read the state of the object owning it.
+    *           The text is usually built with a MetricFamilies.
+    ***************************************************************************************************/
+    class MetricsExporter : public QObject
+    {
+        Q_OBJECT
+
+        public:
+            using Collector = std::function<QByteArray()>;
+
+            explicit MetricsExporter(Collector collector, QObject *parent = nullptr);
+
+            bool listen(quint16 port);
+            void close();
+            bool isListening() const;
+
+            static QString label(const QString &name, const QString &value);
+
+        private:
+            void onNewConnection();
+            void onReadyRead();
+
+            QTcpServer m_server;
+            Collector m_collector;
+            // Request received so far on each connection.
+            QHash<QTcpSocket*, QByteArray> m_requests;
+    };
+}
+
+#endif // METRICSEXPORTER_H
@@ -4,11 +4,23 @@
 #include <QNetworkReply>
 #include <QJsonDocument>
 #include <QJsonObject>
+#include <QJsonArray>
 #include <QTimer>
 #include <QEventLoop>
 #include <QUrlQuery>
 #include <QEvent>
 #include <QThread>
+#include <QDateTime>
+#include <QRandomGenerator>
+#include <QSslConfiguration>
+
+#include "models/JsonReader.h"
+#include "models/Serialization.h"
+#include "models/StringPool.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iterator>
 
 namespace Qtify
 {
@@ -26,6 +38,30 @@ namespace Qtify
         "v1/me/player/next",
         "v1/me/player/previous",
         "v1/me/player/seek",
+        "v1/tracks",
+        "v1/albums",
+        "v1/artists",
+        "v1/me/tracks",
+        "v1/albums/%1/tracks",
+        "v1/playlists/%1/tracks",
+    };
+
+    /// Names of the requests in the enum SpotifyApiRequest, used as metric labels.
+    const QString RequestHandlerPrivate::REQUEST_NAMES[]
+    {
+        "UserInformation",
+        "CurrentPlayback",
+        "PausePlayback",
+        "ResumePlayback",
+        "NextTrack",
+        "PreviousTrack",
+        "Seek",
+        "Tracks",
+        "Albums",
+        "Artists",
+        "SavedTracks",
+        "AlbumTracks",
+        "PlaylistTracks",
     };
 
     /// The scope for all the requests in the enum SpotifyApiRequest.
@@ -34,8 +70,40 @@ namespace Qtify
         "user-read-private",
         "user-read-playback-state",
         "user-modify-playback-state",
+        "user-library-read",
+        "playlist-read-private",
     };
 
+    /// Delay between two playback polls while a track is playing.
+    const std::chrono::milliseconds PLAYBACK_POLL_PLAYING_INTERVAL{std::chrono::seconds(5)};
+    /// Delay between two playback polls while the playback is paused.
+    const std::chrono::milliseconds PLAYBACK_POLL_PAUSED_INTERVAL{std::chrono::seconds(15)};
+    /// Delay after the expected end of a track before polling for the next one.
+    const std::chrono::milliseconds PLAYBACK_POLL_TRACK_END_MARGIN{500};
+    /// Bounds of the exponential back off used while no device is active.
+    const std::chrono::milliseconds PLAYBACK_POLL_IDLE_MIN_INTERVAL{std::chrono::seconds(5)};
+    const std::chrono::milliseconds PLAYBACK_POLL_IDLE_MAX_INTERVAL{std::chrono::minutes(2)};
+
+    /// Default number of requests sent per second, and maximum burst.
+    const double DEFAULT_RATE_LIMIT{10};
+    const int    DEFAULT_RATE_LIMIT_BURST{20};
+    /// Default maximum number of background requests waiting for their reply.
+    const int    DEFAULT_MAX_BACKGROUND_REQUESTS{4};
+
+    /// Maximum number of items per page of each paginated collection.
+    const int SAVED_TRACKS_PAGE_SIZE{50};
+    const int ALBUM_TRACKS_PAGE_SIZE{50};
+    const int PLAYLIST_TRACKS_PAGE_SIZE{100};
+    /// Maximum number of pages of a collection requested at the same time.
+    const int PAGED_FETCH_MAX_ACTIVE_PAGES{4};
+
+    /// Lifetime of an access token when the API does not give it.
+    const std::chrono::seconds TOKEN_DEFAULT_LIFETIME{std::chrono::hours(1)};
+    /// Time before the expiration of the access token at which it is refreshed.
+    const std::chrono::seconds TOKEN_REFRESH_MARGIN{std::chrono::minutes(1)};
+    /// Minimum delay before refreshing the access token, and delay before retrying a failed refresh.
+    const std::chrono::seconds TOKEN_REFRESH_MIN_DELAY{std::chrono::seconds(30)};
+
     /// String display of error contexts.
     const QString RequestHandlerPrivate::ERROR_CONTEXT_STRINGS[]
     {
@@ -48,6 +116,121 @@ namespace Qtify
         "NextTrack",
         "PreviousTrack",
         "Seek",
+        "GetTracks",
+        "GetAlbums",
+        "GetArtists",
+        "GetSavedTracks",
+        "GetAlbumTracks",
+        "GetPlaylistTracks",
+    };
+
+    /// Default budget of the in-memory cache of catalog objects, in bytes.
+    const int CATALOG_MEMORY_CACHE_DEFAULT_SIZE{4 * 1024 * 1024};
+    /// Ratio between the memory used by a model and its serialized size (UTF-8 strings become UTF-16).
+    const int CATALOG_SERIALIZED_SIZE_FACTOR{2};
+    /// Default budget of the cache of decoded album artwork, in bytes.
+    const int ALBUM_ART_CACHE_DEFAULT_SIZE{32 * 1024 * 1024};
+    /// Default size of the artwork prefetched for the current track.
+    const QSize ALBUM_ART_PREFETCH_DEFAULT_SIZE{300, 300};
+
+    namespace
+    {
+        /** ************************************************************************************************
+        * @brief        Build the models of the given ids, in order, from the received objects.
+        ***************************************************************************************************/
+        template<typename T>
+        std::vector<T> buildCatalogObjects(const QStringList &ids, const QHash<QString, QVariant> &objects)
+        {
+            std::vector<T> items;
+            items.reserve(static_cast<size_t>(ids.size()));
+
+            for (const QString &id : ids)
+            {
+                items.push_back(objects.value(id).value<T>());
+            }
+
+            return items;
+        }
+
+        /** ************************************************************************************************
+        * @brief        Estimate the memory used by a model from the JSON it is built from.
+        *
+        * @details      The models keep the JSON of their lazy members until they are read, and the decoded
+        *               members hold the same strings, so the size of the JSON is a good estimate. Walking
+        *               the JSON does not decode the lazy members. Markets are decoded at once into a bitmap,
+        *               so their array only counts for the size of the bitmap.
+        ***************************************************************************************************/
+        int estimateJsonSize(const QJsonValue &json)
+        {
+            switch (json.type())
+            {
+                case QJsonValue::String:
+                    return static_cast<int>(sizeof(QString)) + json.toString().size() * static_cast<int>(sizeof(QChar));
+
+                case QJsonValue::Array:
+                {
+                    int size = static_cast<int>(sizeof(QJsonArray));
+                    for (const QJsonValue &item : json.toArray())
+                    {
+                        size += estimateJsonSize(item);
+                    }
+                    return size;
+                }
+
+                case QJsonValue::Object:
+                {
+                    const QJsonObject object = json.toObject();
+                    int size = static_cast<int>(sizeof(QJsonObject));
+                    for (auto iterator = object.begin(); iterator != object.end(); ++iterator)
+                    {
+                        size += iterator.key().size() + (iterator.key() == QLatin1String("available_markets")
+                                                         ? static_cast<int>(sizeof(Markets))
+                                                         : estimateJsonSize(iterator.value()));
+                    }
+                    return size;
+                }
+
+                default:
+                    return static_cast<int>(sizeof(QJsonValue));
+            }
+        }
+
+        /** ************************************************************************************************
+        * @brief        Conversions of a catalog model stored in a QVariant, used in CATALOG_ENDPOINTS.
+        ***************************************************************************************************/
+        template<typename T>
+        QVariant parseCatalogObject(const QJsonObject &json)
+        {
+            return QVariant::fromValue(T(json));
+        }
+
+        template<typename T>
+        QVariant deserializeCatalogObject(const QByteArray &data)
+        {
+            bool ok = false;
+            const T object = Serialization::deserialize<T>(data, &ok);
+            return ok ? QVariant::fromValue(object) : QVariant();
+        }
+
+        template<typename T>
+        QByteArray serializeCatalogObject(const QVariant &object)
+        {
+            return Serialization::serialize(object.value<T>());
+        }
+    }
+
+    /// How the objects of each catalog type are requested and converted.
+    const RequestHandlerPrivate::CatalogEndpoint RequestHandlerPrivate::CATALOG_ENDPOINTS[]
+    {
+        {SpotifyApiRequest::SpotifyRequest_Tracks,  ErrorContext::Context_GetTracksReply,  "tracks",  50,
+         &parseCatalogObject<Track>,  &deserializeCatalogObject<Track>,
+         &serializeCatalogObject<Track>},
+        {SpotifyApiRequest::SpotifyRequest_Albums,  ErrorContext::Context_GetAlbumsReply,  "albums",  20,
+         &parseCatalogObject<Album>,  &deserializeCatalogObject<Album>,
+         &serializeCatalogObject<Album>},
+        {SpotifyApiRequest::SpotifyRequest_Artists, ErrorContext::Context_GetArtistsReply, "artists", 50,
+         &parseCatalogObject<Artist>, &deserializeCatalogObject<Artist>,
+         &serializeCatalogObject<Artist>},
     };
 
     /** ************************************************************************************************
@@ -58,24 +241,49 @@ namespace Qtify
     * @param[in]    clientId: The client ID of the Spotify application.
     * @param[in]    clientSecret: The client secret of the Spotify application.
     * @param[in]    replyPort: The port on which the API will send authorization replies.
+    * @param[in]    networkAccessManager: A network access manager shared with other workers living in
+    *               the same thread, nullptr to create one.
     * @param[in]    parent: The QObject parent.
     ***************************************************************************************************/
-    RequestHandlerPrivate::RequestHandlerPrivate(const QString &clientId, const QString &clientSecret, int replyPort, QObject *parent) :
+    RequestHandlerPrivate::RequestHandlerPrivate(const QString &clientId, const QString &clientSecret, int replyPort,
+                                                 QNetworkAccessManager *networkAccessManager, QObject *parent) :
         QObject(parent),
+        m_networkAccessManager(networkAccessManager),
         m_clientId(clientId),
         m_clientSecret(clientSecret),
         m_replyPort(replyPort),
-        m_tokenRefreshTimer(this)
+        m_apiUrl(API_URL),
+        m_tokenRefreshTimer(this),
+        m_playbackPollTimer(this),
+        m_idlePlaybackPollInterval(PLAYBACK_POLL_IDLE_MIN_INTERVAL),
+        m_maxBackgroundRequests(DEFAULT_MAX_BACKGROUND_REQUESTS),
+        m_tokenBucket(DEFAULT_RATE_LIMIT, DEFAULT_RATE_LIMIT_BURST),
+        m_dispatchTimer(this),
+        m_catalogMemoryCache(CATALOG_MEMORY_CACHE_DEFAULT_SIZE),
+        m_artworkLoader(ALBUM_ART_CACHE_DEFAULT_SIZE, this),
+        m_albumArtPrefetchSize(ALBUM_ART_PREFETCH_DEFAULT_SIZE)
     {
         // Control tables at compile time.
         static_assert(
                (sizeof(REQUEST_URLS) / sizeof(REQUEST_URLS[0]))
             == static_cast<int>(SpotifyApiRequest::SpotifyRequest_Count),
             "Invalid request table");
+        static_assert(
+               (sizeof(REQUEST_NAMES) / sizeof(REQUEST_NAMES[0]))
+            == static_cast<int>(SpotifyApiRequest::SpotifyRequest_Count),
+            "Invalid request name table");
         static_assert(
                 (sizeof(ERROR_CONTEXT_STRINGS) / sizeof(ERROR_CONTEXT_STRINGS[0]))
             == static_cast<int>(ErrorContext::Context_Count),
             "Invalid error context table");
+        static_assert(
+                (sizeof(CATALOG_ENDPOINTS) / sizeof(CATALOG_ENDPOINTS[0]))
+            == Catalog_Count,
+            "Invalid catalog table");
+
+        // Skipping a track is not idempotent: sending it again after a lost reply may skip twice.
+        m_retryPolicies[static_cast<int>(SpotifyApiRequest::SpotifyRequest_NextTrack)].maxAttempts     = 1;
+        m_retryPolicies[static_cast<int>(SpotifyApiRequest::SpotifyRequest_PreviousTrack)].maxAttempts = 1;
     }
 
     /** ************************************************************************************************
@@ -90,11 +298,16 @@ namespace Qtify
     ***************************************************************************************************/
     void RequestHandlerPrivate::init()
     {
-        m_networkAccessManager = std::make_unique<QNetworkAccessManager>(this);
-        m_authManager = std::make_unique<QOAuth2AuthorizationCodeFlow>(m_networkAccessManager.get(), this);
-        m_replyHandler = std::make_unique<QOAuthHttpServerReplyHandler>(m_replyPort, this);
+        if (!m_networkAccessManager)
+        {
+            m_ownedNetworkAccessManager = std::make_unique<QNetworkAccessManager>(this);
+            m_networkAccessManager = m_ownedNetworkAccessManager.get();
+        }
+        m_authManager = std::make_unique<QOAuth2AuthorizationCodeFlow>(m_networkAccessManager, this);
+        m_artworkLoader.setNetworkAccessManager(m_networkAccessManager);
+
+        connect(&m_artworkLoader, &ArtworkLoader::artworkAvailable, this, &RequestHandlerPrivate::albumArtAvailable);
 
-        m_authManager->setReplyHandler(m_replyHandler.get());
         m_authManager->setAuthorizationUrl(AUTHORIZATION_URL);
         m_authManager->setAccessTokenUrl(TOKEN_ACCESS_URL);
         m_authManager->setClientIdentifier(m_clientId);
@@ -121,13 +334,86 @@ namespace Qtify
         connect(m_authManager.get(), &QOAuth2AuthorizationCodeFlow::granted,
                 this,                &RequestHandlerPrivate::onAccessGranted);
 
-        // Refresh token periodically.
+        // Refresh token before it expires.
         connect(&m_tokenRefreshTimer, &QTimer::timeout, this, &RequestHandlerPrivate::refreshToken);
-        m_tokenRefreshTimer.setInterval(std::chrono::minutes(5));
         m_tokenRefreshTimer.setSingleShot(true);
 
-        // When the thread is stopped, stop the timer.
+        // Poll the playback for subscribers.
+        connect(&m_playbackPollTimer, &QTimer::timeout, this, &RequestHandlerPrivate::pollPlayback);
+        m_playbackPollTimer.setSingleShot(true);
+
+        // Send queued requests when the rate limit allows it.
+        connect(&m_dispatchTimer, &QTimer::timeout, this, &RequestHandlerPrivate::dispatchRequests);
+        m_dispatchTimer.setSingleShot(true);
+
+        // When the thread is stopped, stop the timers.
         connect(thread(), &QThread::finished, &m_tokenRefreshTimer, &QTimer::stop);
+        connect(thread(), &QThread::finished, &m_playbackPollTimer, &QTimer::stop);
+        connect(thread(), &QThread::finished, &m_dispatchTimer, &QTimer::stop);
+    }
+
+    /** ************************************************************************************************
+    * @brief        Stop all activity and move the object to the given thread so that it can be destroyed
+    *               there while its current thread keeps running.
+    *
+    * @details      This must be called in the thread in which the object lives (using invokeMethod).
+    *               Pending replies are aborted and queued requests and retries are dropped, without
+    *               calling their callbacks.
+    ***************************************************************************************************/
+    void RequestHandlerPrivate::shutdown(QThread *thread)
+    {
+        m_tokenRefreshTimer.stop();
+        m_playbackPollTimer.stop();
+        m_dispatchTimer.stop();
+
+        // The retries waiting for their delay and the queued requests are dropped like the pending replies.
+        qDeleteAll(m_retryTimers);
+        m_retryTimers.clear();
+        for (QList<PendingRequest> &queue : m_requestQueues)
+        {
+            queue.clear();
+        }
+        m_pendingGets.clear();
+
+        for (QNetworkReply *reply : m_activeRequests.keys())
+        {
+            reply->disconnect(this);
+            reply->abort();
+            reply->deleteLater();
+        }
+        m_activeRequests.clear();
+        m_artworkLoader.abort();
+        m_metricsExporter.reset();
+
+        moveToThread(thread);
+    }
+
+    /** ************************************************************************************************
+    * @brief        Open the encrypted connections to the API and token hosts before the first request.
+    *
+    * @details      The DNS lookup, TCP connection and TLS handshake are done now instead of delaying the
+    *               first request. The connections are kept by the network access manager and reused by
+    *               the requests to the same hosts. HTTP/2 is offered during the handshake so that the
+    *               API connection can be multiplexed.
+    ***************************************************************************************************/
+    void RequestHandlerPrivate::prewarmConnections()
+    {
+        QSslConfiguration sslConfiguration = QSslConfiguration::defaultConfiguration();
+        sslConfiguration.setAllowedNextProtocols({QSslConfiguration::ALPNProtocolHTTP2,
+                                                  QSslConfiguration::NextProtocolHttp1_1});
+
+        for (const QUrl &url : {QUrl(m_apiUrl), m_authManager->accessTokenUrl()})
+        {
+            if (url.scheme() == "https")
+            {
+                m_networkAccessManager->connectToHostEncrypted(url.host(), static_cast<quint16>(url.port(443)),
+                                                               sslConfiguration);
+            }
+            else
+            {
+                m_networkAccessManager->connectToHost(url.host(), static_cast<quint16>(url.port(80)));
+            }
+        }
     }
 
     /** ************************************************************************************************
@@ -137,6 +423,14 @@ namespace Qtify
     ***************************************************************************************************/
     void RequestHandlerPrivate::grant()
     {
+        // The listening socket is only needed for an interactive login, so workers restoring their
+        // tokens do not each hold a port.
+        if (!m_replyHandler)
+        {
+            m_replyHandler = std::make_unique<QOAuthHttpServerReplyHandler>(m_replyPort, this);
+            m_authManager->setReplyHandler(m_replyHandler.get());
+        }
+
         m_authManager->grant();
     }
 
@@ -157,7 +451,7 @@ namespace Qtify
     ***************************************************************************************************/
     void RequestHandlerPrivate::getCurrentUserInformation()
     {
-        get(buildUrl(SpotifyApiRequest::SpotifyRequest_UserInformation),
+        get(SpotifyApiRequest::SpotifyRequest_UserInformation, ErrorContext::Context_GetUserInformationReply,
             &RequestHandlerPrivate::onGetCurrentUserInformationReplyReceived);
     }
 
@@ -166,287 +460,1881 @@ namespace Qtify
     ***************************************************************************************************/
     void RequestHandlerPrivate::getCurrentPlaybackInformation()
     {
-        get(buildUrl(SpotifyApiRequest::SpotifyRequest_CurrentPlayback),
+        get(SpotifyApiRequest::SpotifyRequest_CurrentPlayback, ErrorContext::Context_GetCurrentPlaybackReply,
             &RequestHandlerPrivate::onGetCurrentPlaybackInformationReceived);
     }
 
     /** ************************************************************************************************
-    * @brief        Send a request to resume the current playing track.
+    * @brief        Start polling the current playback for a new subscriber.
+    *
+    * @details      A single polling loop is shared by all subscribers. Results are emitted with
+    *               currentPlaybackUpdated().
     ***************************************************************************************************/
-    void RequestHandlerPrivate::resumePlayback()
+    void RequestHandlerPrivate::subscribePlayback()
     {
-        put(buildUrl(SpotifyApiRequest::SpotifyRequest_ResumePlayback),
-            ErrorContext::Context_ResumeCurrentPlayback);
+        ++m_playbackSubscriberCount;
+
+        if (m_playbackSubscriberCount == 1)
+        {
+            m_idlePlaybackPollInterval = PLAYBACK_POLL_IDLE_MIN_INTERVAL;
+            pollPlayback();
+        }
     }
 
     /** ************************************************************************************************
-    * @brief        Send a request to pause the current playing track.
+    * @brief        Remove a subscriber added with subscribePlayback().
+    *
+    * @details      Polling stops when the last subscriber is removed.
     ***************************************************************************************************/
-    void RequestHandlerPrivate::pausePlayback()
+    void RequestHandlerPrivate::unsubscribePlayback()
     {
-        put(buildUrl(SpotifyApiRequest::SpotifyRequest_PausePlayback),
-            ErrorContext::Context_PauseCurrentPlayback);
+        if (m_playbackSubscriberCount > 0)
+        {
+            --m_playbackSubscriberCount;
+        }
+
+        if (m_playbackSubscriberCount == 0)
+        {
+            m_playbackPollTimer.stop();
+        }
     }
 
     /** ************************************************************************************************
-    * @brief        Send a request to go to the next track in the current playlist.
+    * @brief        Look up tracks by id.
+    *
+    * @details      The tracks are emitted with tracksAvailable() in the order of the ids. Unknown ids give a
+    *               track with an empty id.
     ***************************************************************************************************/
-    void RequestHandlerPrivate::nextTrack()
+    void RequestHandlerPrivate::getTracks(const QStringList &ids)
     {
-        post(buildUrl(SpotifyApiRequest::SpotifyRequest_NextTrack),
-             ErrorContext::Context_NextTrack);
+        requestCatalog(Catalog_Track, ids);
     }
 
     /** ************************************************************************************************
-    * @brief        Send a request to go to the previous track in the current playlist.
+    * @brief        Look up albums by id.
+    *
+    * @details      The albums are emitted with albumsAvailable() in the order of the ids. Unknown ids give
+    *               an album with an empty id.
     ***************************************************************************************************/
-    void RequestHandlerPrivate::previousTrack()
+    void RequestHandlerPrivate::getAlbums(const QStringList &ids)
     {
-        post(buildUrl(SpotifyApiRequest::SpotifyRequest_PreviousTrack),
-             ErrorContext::Context_PreviousTrack);
+        requestCatalog(Catalog_Album, ids);
     }
 
     /** ************************************************************************************************
-    * @brief        Send a request to go to the given position in the current playback.
+    * @brief        Look up artists by id.
     *
-    * @param[in]    positionMs: The position in milliseconds to seek to. Must be a positive number.
-    *               Passing in a position that is greater than the length of the track will cause the
-    *               player to start playing the next song.
+    * @details      The artists are emitted with artistsAvailable() in the order of the ids. Unknown ids
+    *               give an artist with an empty id.
     ***************************************************************************************************/
-    void RequestHandlerPrivate::seek(int positionMs)
+    void RequestHandlerPrivate::getArtists(const QStringList &ids)
     {
-        put(buildUrl(SpotifyApiRequest::SpotifyRequest_Seek, QVariantMap{{"position_ms", positionMs}}),
-            ErrorContext::Context_Seek);
+        requestCatalog(Catalog_Artist, ids);
     }
 
     /** ************************************************************************************************
-    * @brief        Build an URL to sent the given request type.
+    * @brief        Fetch all the tracks saved in the library of the user.
     *
-    * @param[in]    requestType: The type of request to send.
-    * @param[in]    parameters: The parameters of the request (optional).
+    * @details      Pages are emitted with savedTracksPageAvailable() as soon as they are received, not
+    *               necessarily in order.
     ***************************************************************************************************/
-    QUrl RequestHandlerPrivate::buildUrl(RequestHandlerPrivate::SpotifyApiRequest requestType, const QVariantMap &parameters)
+    void RequestHandlerPrivate::getSavedTracks()
     {
-        QUrl url{API_URL + REQUEST_URLS[static_cast<int>(requestType)]};
-
-        if (!parameters.empty())
-        {
-            QUrlQuery query;
-
-            QMapIterator<QString, QVariant> iterator(parameters);
-            while(iterator.hasNext())
-            {
-                iterator.next();
-                query.addQueryItem(iterator.key(), iterator.value().toString());
-            }
-
-            url.setQuery(query);
-        }
-
-        return url;
+        fetchPages(SpotifyApiRequest::SpotifyRequest_SavedTracks, ErrorContext::Context_GetSavedTracksReply,
+                   SAVED_TRACKS_PAGE_SIZE);
     }
 
     /** ************************************************************************************************
-    * @brief        Refresh the token to access the API.
+    * @brief        Fetch all the tracks of an album.
     *
-    * @details      QOAuth2AuthorizationCodeFlow::refreshAccessToken() doesn't work with Spotify.
-    *               The header "Authorization" value is incorrect. Until a way to override it is found,
-    *               a custom request is sent.
-    *               The query is the step 4 of the authorization flow documentation.
-    *               https://developer.spotify.com/documentation/general/guides/authorization-guide/#authorization-code-flow
+    * @details      Pages are emitted with albumTracksPageAvailable() as soon as they are received, not
+    *               necessarily in order. The tracks do not include their album.
     ***************************************************************************************************/
-    void RequestHandlerPrivate::refreshToken()
+    void RequestHandlerPrivate::getAlbumTracks(const QString &albumId)
     {
-        // Construct the URL.
-        QUrl url(m_authManager->accessTokenUrl());
-
-        // Add query parameters
-        QUrlQuery query;
-        query.addQueryItem("grant_type", "refresh_token");
-        query.addQueryItem("refresh_token", m_authManager->refreshToken());
-        url.setQuery(query);
-
-        // Create the request.
-        QNetworkRequest request(url);
-        // The "Authorization" header is  a base64 encoding of the client ID and secret.
-        QString authorization("Basic %1");
-        QByteArray code;
-        code.append(m_authManager->clientIdentifier() + ":" +  m_authManager->clientIdentifierSharedKey());
-        request.setRawHeader("Authorization", QByteArray("Basic ") + code.toBase64());
-        request.setHeader(QNetworkRequest::ContentTypeHeader, "application/x-www-form-urlencoded");
-
-        auto reply = m_networkAccessManager->post(request, QByteArray());
-        connect(reply, &QNetworkReply::finished, this, &RequestHandlerPrivate::onRefreshTokenReplyReceived);
+        fetchPages(SpotifyApiRequest::SpotifyRequest_AlbumTracks, ErrorContext::Context_GetAlbumTracksReply,
+                   ALBUM_TRACKS_PAGE_SIZE, albumId);
     }
 
     /** ************************************************************************************************
-    * @brief        Send a GET request to the given Spotify API URL and  call callback when a reply is
-    *               received.
+    * @brief        Fetch all the tracks of a playlist.
+    *
+    * @details      Pages are emitted with playlistTracksPageAvailable() as soon as they are received, not
+    *               necessarily in order. Removed or local tracks give a track with an empty id.
     ***************************************************************************************************/
-    void RequestHandlerPrivate::get(const QUrl &url, void (RequestHandlerPrivate::*callback)())
+    void RequestHandlerPrivate::getPlaylistTracks(const QString &playlistId)
     {
-        connect(m_authManager->get(url), &QNetworkReply::finished, this, callback);
+        fetchPages(SpotifyApiRequest::SpotifyRequest_PlaylistTracks, ErrorContext::Context_GetPlaylistTracksReply,
+                   PLAYLIST_TRACKS_PAGE_SIZE, playlistId);
     }
 
     /** ************************************************************************************************
-    * @brief        Send a PUT request to the given Spotify API URL and  call callback when a reply is
-    *               received.
+    * @brief        Load the artwork of an album, from the smallest image covering the given size.
+    *
+    * @details      albumArtAvailable is emitted with the decoded image, null if there is none.
     ***************************************************************************************************/
-    void RequestHandlerPrivate::put(const QUrl &url, ErrorContext context)
+    void RequestHandlerPrivate::getAlbumArt(const Album &album, const QSize &size)
     {
-        QNetworkReply *reply = m_authManager->put(url);
-        connect(reply, &QNetworkReply::finished, this, &RequestHandlerPrivate::onPutPostReplyReceived);
-        m_postPutReplyContexts[reply] = context;
+        m_artworkLoader.load(album.getId(), album.getImages(), size);
     }
 
     /** ************************************************************************************************
-    * @brief        Send a POST request to the given Spotify API URL and  call callback when a reply is
-    *               received.
+    * @brief        Send a request to resume the current playing track.
     ***************************************************************************************************/
-    void RequestHandlerPrivate::post(const QUrl &url, ErrorContext context)
+    void RequestHandlerPrivate::resumePlayback()
     {
-        QNetworkReply *reply = m_authManager->post(url);
-        connect(reply, &QNetworkReply::finished, this, &RequestHandlerPrivate::onPutPostReplyReceived);
-        m_postPutReplyContexts[reply] = context;
+        put(SpotifyApiRequest::SpotifyRequest_ResumePlayback, ErrorContext::Context_ResumeCurrentPlayback);
     }
 
     /** ************************************************************************************************
-    * @brief        Handle any regular network error.
-    *
-    * @details      There are two types of error: regular and authentication. Each has its own JSON
-    *               format. handleRegularError() and handleAuthenticationError() process the JSON
-    *               data differently.
+    * @brief        Send a request to pause the current playing track.
     ***************************************************************************************************/
-    void RequestHandlerPrivate::handleRegularError(RequestHandlerPrivate::ErrorContext context, const QByteArray &errorData)
+    void RequestHandlerPrivate::pausePlayback()
     {
-        Error error(QJsonDocument::fromJson(errorData).object()["error"].toObject());
-        qWarning() << "Error in " << ERROR_CONTEXT_STRINGS[static_cast<int>(context)]
-                   << ":" << error.getStatus() << "-" << error.getMessage();
-
-        // If the token has expired try to refresh it.
-        if ("The access token expired" == error.getMessage())
-        {
-            // Do not try more than every 10 seconds.
-            if (std::chrono::system_clock::now() - m_lastTokenRefresh >= std::chrono::seconds(10))
-            {
-                refreshToken();
-            }
-        }
+        put(SpotifyApiRequest::SpotifyRequest_PausePlayback, ErrorContext::Context_PauseCurrentPlayback);
     }
 
     /** ************************************************************************************************
-    * @brief        Handle any regular network error.
+    * @brief        Send a request to go to the next track in the current playlist.
     *
-    * @details      There are two types of error: regular and authentication. Each has its own JSON
-    *               format. handleRegularError() and handleAuthenticationError() process the JSON
-    *               data differently.
+    * @details      See skip().
     ***************************************************************************************************/
-    void RequestHandlerPrivate::handleAuthenticationError(RequestHandlerPrivate::ErrorContext context, const QByteArray &errorData)
+    void RequestHandlerPrivate::nextTrack()
     {
-        AuthenticationError error(QJsonDocument::fromJson(errorData).object());
-        qWarning() << "Error in " << ERROR_CONTEXT_STRINGS[static_cast<int>(context)]
-                   << ":" << error.getError() << "-" << error.getErrorDescription();
+        skip(1);
     }
 
     /** ************************************************************************************************
-    * @brief        Function called when API access has been granted by the user.
+    * @brief        Send a request to go to the previous track in the current playlist.
+    *
+    * @details      See skip().
     ***************************************************************************************************/
-    void RequestHandlerPrivate::onAccessGranted()
+    void RequestHandlerPrivate::previousTrack()
     {
-        emit accessGranted(m_authManager->token(), m_authManager->refreshToken());
-        m_tokenRefreshTimer.start();
+        skip(-1);
     }
 
     /** ************************************************************************************************
-    * @brief        Function called when a reply is received after calling refreshToken().
+    * @brief        Send a request to go to the given position in the current playback.
+    *
+    * @details      Only one seek request is pending at a time. Positions requested in the meantime
+    *               replace each other and only the latest one is sent when the pending request completes.
+    *
+    * @param[in]    positionMs: The position in milliseconds to seek to. Must be a positive number.
+    *               Passing in a position that is greater than the length of the track will cause the
+    *               player to start playing the next song.
     ***************************************************************************************************/
-    void RequestHandlerPrivate::onRefreshTokenReplyReceived()
+    void RequestHandlerPrivate::seek(int positionMs)
     {
-        if (QNetworkReply *reply = qobject_cast<QNetworkReply*>(QObject::sender()))
+        if (m_seekPending)
         {
-            if (reply->error() != QNetworkReply::NoError)
-            {
-                handleAuthenticationError(ErrorContext::Context_RefreshTokenReply, reply->readAll());
-            }
-            else
+            if (m_nextSeekPosition >= 0)
             {
-                m_authManager->setToken(QJsonDocument::fromJson(reply->readAll()).object()["access_token"].toString());
-                emit tokenRefreshed(m_authManager->refreshToken());
-
-                // Refresh the token later.
-                m_tokenRefreshTimer.start();
+                ++m_coalescedRequestCount;
             }
 
-            reply->deleteLater();
+            m_nextSeekPosition = positionMs;
+            return;
         }
 
-        m_lastTokenRefresh = std::chrono::system_clock::now();
+        m_seekPending = true;
+        put(SpotifyApiRequest::SpotifyRequest_Seek, ErrorContext::Context_Seek, QVariantMap{{"position_ms", positionMs}},
+            &RequestHandlerPrivate::onSeekReplyReceived);
     }
 
     /** ************************************************************************************************
-    * @brief        Function called when a reply to any POST or PUT request is received.
+    * @brief        Look up catalog objects of the given type by id.
     *
-    * @details      The response is ignored, we just process any error and delete the reply.
+    * @details      Objects found in the in-memory or persistent catalog caches are not requested.
+    *               Ids are sent in chunks of the maximum size accepted by the API. Ids already requested
+    *               by a pending lookup, or repeated in the list, are only requested once. The lookup
+    *               completes when all its objects are received.
     ***************************************************************************************************/
-    void RequestHandlerPrivate::onPutPostReplyReceived()
+    void RequestHandlerPrivate::requestCatalog(CatalogType type, const QStringList &ids)
     {
-        if (QNetworkReply *reply = qobject_cast<QNetworkReply*>(QObject::sender()))
+        const CatalogEndpoint &endpoint = CATALOG_ENDPOINTS[type];
+        CatalogBatch batch{type, ids, QSet<QString>()};
+        QStringList idsToRequest;
+
+        for (const QString &id : ids)
         {
-            auto iterator = m_postPutReplyContexts.find(reply);
+            if (m_catalogObjects[type].contains(id) || batch.missing.contains(id))
+            {
+                continue;
+            }
 
-            if (reply->error() != QNetworkReply::NoError)
+            QVariant object;
+            if (findCachedCatalogObject(type, id, object))
             {
-                auto context = ErrorContext::Context_Unknown;
-                if (iterator != m_postPutReplyContexts.end())
-                {
-                    context = iterator.value();
-                }
+                m_catalogObjects[type].insert(id, object);
+                continue;
+            }
 
-                handleRegularError(m_postPutReplyContexts.value(reply, context), reply->readAll());
+            batch.missing.insert(id);
+            if (m_catalogIdsInFlight[type].contains(id))
+            {
+                ++m_coalescedRequestCount;
+            }
+            else
+            {
+                m_catalogIdsInFlight[type].insert(id);
+                idsToRequest.append(id);
             }
+        }
 
-            reply->deleteLater();
-            m_postPutReplyContexts.erase(iterator);
+        m_catalogBatches.append(batch);
+
+        for (int i = 0; i < idsToRequest.size(); i += endpoint.maxIds)
+        {
+            get(endpoint.request, endpoint.context, &RequestHandlerPrivate::onGetCatalogReplyReceived,
+                QVariantMap{{"ids", idsToRequest.mid(i, endpoint.maxIds).join(',')}});
         }
+
+        // All the objects may already be available.
+        completeCatalogBatches();
     }
 
     /** ************************************************************************************************
-    * @brief        Function called when a reply to getCurrentUserInformation is received.
+    * @brief        Key of a catalog object in the persistent catalog cache.
     ***************************************************************************************************/
-    void RequestHandlerPrivate::onGetCurrentUserInformationReplyReceived()
+    QString RequestHandlerPrivate::catalogCacheKey(CatalogType type, const QString &id)
     {
-        if (QNetworkReply *reply = qobject_cast<QNetworkReply*>(QObject::sender()))
+        return CATALOG_ENDPOINTS[type].key + '/' + id;
+    }
+
+    /** ************************************************************************************************
+    * @brief        Look up a catalog object in the in-memory cache, then in the persistent cache.
+    *
+    * @details      Objects found in the persistent cache are added to the in-memory cache.
+    *
+    * @return       True if the object was found.
+    ***************************************************************************************************/
+    bool RequestHandlerPrivate::findCachedCatalogObject(CatalogType type, const QString &id, QVariant &object)
+    {
+        const QString key = catalogCacheKey(type, id);
+        if (m_catalogMemoryCache.find(key, object))
         {
-            if (reply->error() != QNetworkReply::NoError)
-            {
-                handleRegularError(ErrorContext::Context_GetUserInformationReply, reply->readAll());
-            }
-            else
-            {
-                emit userDataAvailable(QSharedPointer<User>(new User(QJsonDocument::fromJson(reply->readAll()).object())));
-            }
+            return true;
+        }
 
-            reply->deleteLater();
+        if (!m_catalogCache.isOpen())
+        {
+            return false;
         }
+
+        const QByteArray data = m_catalogCache.find(key);
+        object = CATALOG_ENDPOINTS[type].deserialize(data);
+        if (!object.isValid())
+        {
+            return false;
+        }
+
+        m_catalogMemoryCache.insert(key, object, data.size() * CATALOG_SERIALIZED_SIZE_FACTOR);
+        return true;
     }
 
     /** ************************************************************************************************
-    * @brief        Function called when a reply to getCurrentPlaybackInformation is received.
+    * @brief        Store a catalog object in the in-memory cache and, if persistent is set, in the
+    *               persistent cache.
+    *
+    * @param[in]    size: The estimated memory used by the object, see estimateJsonSize().
     ***************************************************************************************************/
-    void RequestHandlerPrivate::onGetCurrentPlaybackInformationReceived()
+    void RequestHandlerPrivate::cacheCatalogObject(CatalogType type, const QString &id, const QVariant &object,
+                                                   int size, bool persistent)
     {
-        if (QNetworkReply *reply = qobject_cast<QNetworkReply*>(QObject::sender()))
+        if (id.isEmpty())
         {
-            if (reply->error() != QNetworkReply::NoError)
+            return;
+        }
+
+        const QString key = catalogCacheKey(type, id);
+        m_catalogMemoryCache.insert(key, object, size);
+
+        if (persistent && m_catalogCache.isOpen())
+        {
+            m_catalogCache.insert(key, CATALOG_ENDPOINTS[type].serialize(object));
+        }
+    }
+
+    /** ************************************************************************************************
+    * @brief        Emit the catalog lookups for which all objects are received.
+    *
+    * @details      Received objects are kept until no lookup of their type is pending.
+    ***************************************************************************************************/
+    void RequestHandlerPrivate::completeCatalogBatches()
+    {
+        bool pending[Catalog_Count] = {};
+
+        for (auto iterator = m_catalogBatches.begin(); iterator != m_catalogBatches.end();)
+        {
+            const QHash<QString, QVariant> &objects = m_catalogObjects[iterator->type];
+            for (auto id = iterator->missing.begin(); id != iterator->missing.end();)
+            {
+                id = objects.contains(*id) ? iterator->missing.erase(id) : std::next(id);
+            }
+
+            if (!iterator->missing.isEmpty())
+            {
+                pending[iterator->type] = true;
+                ++iterator;
+                continue;
+            }
+
+            switch (iterator->type)
+            {
+                case Catalog_Track:
+                    emit tracksAvailable(buildCatalogObjects<Track>(iterator->ids, objects));
+                    break;
+
+                case Catalog_Album:
+                    emit albumsAvailable(buildCatalogObjects<Album>(iterator->ids, objects));
+                    break;
+
+                case Catalog_Artist:
+                    emit artistsAvailable(buildCatalogObjects<Artist>(iterator->ids, objects));
+                    break;
+
+                default:
+                    break;
+            }
+
+            iterator = m_catalogBatches.erase(iterator);
+        }
+
+        for (int type = 0; type < Catalog_Count; ++type)
+        {
+            if (!pending[type])
+            {
+                m_catalogObjects[type].clear();
+            }
+        }
+    }
+
+    /** ************************************************************************************************
+    * @brief        Fetch all the pages of a paginated collection.
+    *
+    * @details      The first page gives the number of items. The remaining pages are then requested by
+    *               offset instead of following the "next" links, with up to PAGED_FETCH_MAX_ACTIVE_PAGES
+    *               pages in flight. A collection already being fetched is not fetched again.
+    ***************************************************************************************************/
+    void RequestHandlerPrivate::fetchPages(SpotifyApiRequest requestType, ErrorContext context, int pageSize,
+                                           const QString &resourceId)
+    {
+        const QUrl collectionUrl = buildUrl(requestType, QVariantMap{}, resourceId);
+        if (m_pagedFetches.contains(collectionUrl))
+        {
+            ++m_coalescedRequestCount;
+            return;
+        }
+
+        PagedFetch fetch;
+        fetch.type       = requestType;
+        fetch.context    = context;
+        fetch.resourceId = resourceId;
+        fetch.pageSize   = pageSize;
+        m_pagedFetches.insert(collectionUrl, fetch);
+
+        requestPages(collectionUrl);
+    }
+
+    /** ************************************************************************************************
+    * @brief        Request the next pages of a collection, within the limit of pages in flight.
+    *
+    * @details      Until the number of items is known, only the first page is requested. When no page is
+    *               left, the fetch is finished: the signal of its collection reports whether all the
+    *               pages were received.
+    ***************************************************************************************************/
+    void RequestHandlerPrivate::requestPages(const QUrl &collectionUrl)
+    {
+        auto iterator = m_pagedFetches.find(collectionUrl);
+        if (iterator == m_pagedFetches.end())
+        {
+            return;
+        }
+
+        PagedFetch &fetch = iterator.value();
+        const int end = fetch.total < 0 ? 1 : fetch.total;
+
+        while (fetch.activePages < PAGED_FETCH_MAX_ACTIVE_PAGES && fetch.nextOffset < end)
+        {
+            get(fetch.type, fetch.context, &RequestHandlerPrivate::onGetPageReplyReceived,
+                QVariantMap{{"offset", fetch.nextOffset}, {"limit", fetch.pageSize}}, fetch.resourceId);
+            fetch.nextOffset += fetch.pageSize;
+            ++fetch.activePages;
+        }
+
+        if (fetch.activePages == 0)
+        {
+            const PagedFetch finishedFetch = fetch;
+            m_pagedFetches.erase(iterator);
+
+            const bool success = finishedFetch.failedPages == 0;
+            switch (finishedFetch.type)
+            {
+                case SpotifyApiRequest::SpotifyRequest_SavedTracks:
+                    emit savedTracksFetchFinished(success);
+                    break;
+
+                case SpotifyApiRequest::SpotifyRequest_AlbumTracks:
+                    emit albumTracksFetchFinished(finishedFetch.resourceId, success);
+                    break;
+
+                case SpotifyApiRequest::SpotifyRequest_PlaylistTracks:
+                    emit playlistTracksFetchFinished(finishedFetch.resourceId, success);
+                    break;
+
+                default:
+                    break;
+            }
+        }
+    }
+
+    /** ************************************************************************************************
+    * @brief        Skip tracks forward (positive count) or backward (negative count).
+    *
+    * @details      Only one skip request is pending at a time. Skips requested in the meantime are summed
+    *               into a net count which is sent one request at a time once the pending request
+    *               completes. Opposite skips cancel each other without any request.
+    ***************************************************************************************************/
+    void RequestHandlerPrivate::skip(int count)
+    {
+        if (m_skipPending)
+        {
+            // Opposite skips cancel each other.
+            if ((m_queuedSkips > 0 && count < 0) || (m_queuedSkips < 0 && count > 0))
+            {
+                m_coalescedRequestCount += 2 * std::min(std::abs(m_queuedSkips), std::abs(count));
+            }
+
+            m_queuedSkips += count;
+            return;
+        }
+
+        if (count == 0)
+        {
+            return;
+        }
+
+        // Send one skip and keep the others for when it completes.
+        m_skipPending = true;
+        m_queuedSkips = count > 0 ? count - 1 : count + 1;
+
+        if (count > 0)
+        {
+            post(SpotifyApiRequest::SpotifyRequest_NextTrack, ErrorContext::Context_NextTrack, QVariantMap{},
+                 &RequestHandlerPrivate::onSkipReplyReceived);
+        }
+        else
+        {
+            post(SpotifyApiRequest::SpotifyRequest_PreviousTrack, ErrorContext::Context_PreviousTrack, QVariantMap{},
+                 &RequestHandlerPrivate::onSkipReplyReceived);
+        }
+    }
+
+    /** ************************************************************************************************
+    * @brief        Set the maximum rate at which requests are sent to the API.
+    *
+    * @param[in]    requestsPerSecond: The average number of requests per second. 0 to disable the limit.
+    * @param[in]    burst: The maximum number of requests sent at once.
+    ***************************************************************************************************/
+    void RequestHandlerPrivate::setRateLimit(double requestsPerSecond, int burst)
+    {
+        m_tokenBucket.configure(requestsPerSecond, burst);
+        dispatchRequests();
+    }
+
+    /** ************************************************************************************************
+    * @brief        Set the maximum number of background requests waiting for their reply.
+    *
+    * @details      Interactive requests are not limited.
+    ***************************************************************************************************/
+    void RequestHandlerPrivate::setMaxBackgroundRequests(int maxRequests)
+    {
+        m_maxBackgroundRequests = std::max(maxRequests, 1);
+        dispatchRequests();
+    }
+
+    /** ************************************************************************************************
+    * @brief        Set how requests of the given type are retried after a transient error.
+    *
+    * @details      By default, all requests are sent up to 3 times except track skips, which are not
+    *               idempotent and are only retried if a policy is set explicitly.
+    ***************************************************************************************************/
+    void RequestHandlerPrivate::setRetryPolicy(SpotifyApiRequest requestType, const RetryPolicy &policy)
+    {
+        m_retryPolicies[static_cast<int>(requestType)] = policy;
+    }
+
+    /** ************************************************************************************************
+    * @brief        Keep the catalog objects received in a file to answer lookups without requests, even
+    *               after a restart.
+    *
+    * @param[in]    path: The path of the cache file. Empty to disable the cache.
+    * @param[in]    maxSize: The size in bytes over which the file is compacted.
+    * @param[in]    timeToLive: The time after which a cached object is requested again.
+    ***************************************************************************************************/
+    void RequestHandlerPrivate::setCatalogCache(const QString &path, qint64 maxSize, std::chrono::seconds timeToLive)
+    {
+        if (path.isEmpty())
+        {
+            m_catalogCache.close();
+        }
+        else
+        {
+            m_catalogCache.open(path, maxSize, timeToLive);
+        }
+    }
+
+    /** ************************************************************************************************
+    * @brief        Send the requests to other servers than the Spotify ones.
+    *
+    * @details      The ETags received from the previous servers are dropped. An empty URL restores the
+    *               Spotify one.
+    *
+    * @param[in]    apiUrl: The base URL of the Web API, to which the paths of REQUEST_URLS are appended.
+    * @param[in]    authorizationUrl: The URL of the authorization page.
+    * @param[in]    tokenUrl: The URL from which access tokens are requested and refreshed.
+    ***************************************************************************************************/
+    void RequestHandlerPrivate::setServiceUrls(const QUrl &apiUrl, const QUrl &authorizationUrl, const QUrl &tokenUrl)
+    {
+        m_apiUrl = apiUrl.isEmpty() ? API_URL : apiUrl.toString();
+        if (!m_apiUrl.endsWith('/'))
+        {
+            m_apiUrl += '/';
+        }
+
+        m_authManager->setAuthorizationUrl(authorizationUrl.isEmpty() ? AUTHORIZATION_URL : authorizationUrl);
+        m_authManager->setAccessTokenUrl(tokenUrl.isEmpty() ? TOKEN_ACCESS_URL : tokenUrl);
+
+        m_eTags.clear();
+    }
+
+    /** ************************************************************************************************
+    * @brief        Set the budget of the in-memory cache of catalog objects, in bytes.
+    ***************************************************************************************************/
+    void RequestHandlerPrivate::setCatalogMemoryCacheSize(int maxSize)
+    {
+        m_catalogMemoryCache.setMaxSize(maxSize);
+    }
+
+    /** ************************************************************************************************
+    * @brief        Remove the track, album or artist with the given id from the in-memory and persistent
+    *               caches, so that the next lookup requests it again.
+    ***************************************************************************************************/
+    void RequestHandlerPrivate::invalidateCatalogObject(const QString &id)
+    {
+        for (int type = 0; type < Catalog_Count; ++type)
+        {
+            const QString key = catalogCacheKey(static_cast<CatalogType>(type), id);
+            m_catalogMemoryCache.remove(key);
+            m_catalogCache.remove(key);
+        }
+    }
+
+    /** ************************************************************************************************
+    * @brief        Set the budget of the cache of decoded album artwork, in bytes.
+    ***************************************************************************************************/
+    void RequestHandlerPrivate::setAlbumArtCacheSize(int maxSize)
+    {
+        m_artworkLoader.setMaxSize(maxSize);
+    }
+
+    /** ************************************************************************************************
+    * @brief        Set the size of the artwork prefetched when the current track changes.
+    ***************************************************************************************************/
+    void RequestHandlerPrivate::setAlbumArtPrefetchSize(const QSize &size)
+    {
+        m_albumArtPrefetchSize = size;
+    }
+
+    /** ************************************************************************************************
+    * @brief        Serve the metrics in the Prometheus text format on the given port of the loopback
+    *               interface. A port of 0 stops the exporter.
+    ***************************************************************************************************/
+    void RequestHandlerPrivate::setMetricsPort(int port)
+    {
+        if (port <= 0 || port > 65535)
+        {
+            m_metricsExporter.reset();
+            return;
+        }
+
+        if (!m_metricsExporter)
+        {
+            m_metricsExporter = std::make_unique<MetricsExporter>([this]()
+            {
+                MetricFamilies families;
+                collectMetrics(families);
+                return families.toText();
+            }, this);
+        }
+
+        m_metricsExporter->listen(static_cast<quint16>(port));
+    }
+
+    /** ************************************************************************************************
+    * @brief        Number of requests that were not sent because they were merged with another one.
+    *
+    * @details      This counts GET requests identical to a pending one, seek positions replaced by a
+    *               newer one and track skips cancelled by an opposite skip.
+    *
+    * @details      This can be called from any thread.
+    ***************************************************************************************************/
+    int RequestHandlerPrivate::getCoalescedRequestCount() const
+    {
+        return m_coalescedRequestCount;
+    }
+
+    /** ************************************************************************************************
+    * @brief        Get the latency statistics of the given lane.
+    *
+    * @details      This can be called from any thread.
+    ***************************************************************************************************/
+    LatencyStatistics RequestHandlerPrivate::getLatencyStatistics(RequestLane lane) const
+    {
+        QMutexLocker locker(&m_statisticsMutex);
+        return m_latencyStatistics[lane];
+    }
+
+    /** ************************************************************************************************
+    * @brief        Get the retry statistics of the given request type.
+    *
+    * @details      This can be called from any thread.
+    ***************************************************************************************************/
+    RetryStatistics RequestHandlerPrivate::getRetryStatistics(SpotifyApiRequest requestType) const
+    {
+        QMutexLocker locker(&m_statisticsMutex);
+        return m_retryStatistics[static_cast<int>(requestType)];
+    }
+
+    /** ************************************************************************************************
+    * @brief        Get a snapshot of the metrics of every request type and action used so far.
+    *
+    * @details      This can be called from any thread.
+    ***************************************************************************************************/
+    std::vector<EndpointMetrics> RequestHandlerPrivate::getEndpointMetrics() const
+    {
+        QMutexLocker locker(&m_statisticsMutex);
+        return std::vector<EndpointMetrics>(m_endpointMetrics.cbegin(), m_endpointMetrics.cend());
+    }
+
+    /** ************************************************************************************************
+    * @brief        Get the number of successful and failed refreshes of the access token.
+    *
+    * @details      This can be called from any thread.
+    ***************************************************************************************************/
+    TokenRefreshStatistics RequestHandlerPrivate::getTokenRefreshStatistics() const
+    {
+        QMutexLocker locker(&m_statisticsMutex);
+        return m_tokenRefreshStatistics;
+    }
+
+    /** ************************************************************************************************
+    * @brief        Get the usage of the in-memory cache of catalog objects.
+    *
+    * @details      This can be called from any thread.
+    ***************************************************************************************************/
+    CacheStatistics RequestHandlerPrivate::getCatalogMemoryCacheStatistics() const
+    {
+        return m_catalogMemoryCache.getStatistics();
+    }
+
+    /** ************************************************************************************************
+    * @brief        Get the usage of the cache of decoded album artwork.
+    *
+    * @details      This can be called from any thread.
+    ***************************************************************************************************/
+    CacheStatistics RequestHandlerPrivate::getAlbumArtCacheStatistics() const
+    {
+        return m_artworkLoader.getStatistics();
+    }
+
+    /** ************************************************************************************************
+    * @brief        Build an URL to sent the given request type.
+    *
+    * @param[in]    requestType: The type of request to send.
+    * @param[in]    parameters: The parameters of the request (optional).
+    * @param[in]    resourceId: The id of the album or playlist for requests on one of them (optional).
+    ***************************************************************************************************/
+    QUrl RequestHandlerPrivate::buildUrl(SpotifyApiRequest requestType, const QVariantMap &parameters,
+                                         const QString &resourceId)
+    {
+        QString path = REQUEST_URLS[static_cast<int>(requestType)];
+        if (!resourceId.isEmpty())
+        {
+            path = path.arg(resourceId);
+        }
+
+        QUrl url{m_apiUrl + path};
+
+        if (!parameters.empty())
+        {
+            QUrlQuery query;
+
+            QMapIterator<QString, QVariant> iterator(parameters);
+            while(iterator.hasNext())
+            {
+                iterator.next();
+                query.addQueryItem(iterator.key(), iterator.value().toString());
+            }
+
+            url.setQuery(query);
+        }
+
+        return url;
+    }
+
+    /** ************************************************************************************************
+    * @brief        Send a poll of the playback polling loop.
+    *
+    * @details      Unlike a request of getCurrentPlaybackInformation(), its reply schedules the next poll.
+    ***************************************************************************************************/
+    void RequestHandlerPrivate::pollPlayback()
+    {
+        m_playbackPollPending = true;
+        getCurrentPlaybackInformation();
+    }
+
+    /** ************************************************************************************************
+    * @brief        Schedule the next playback poll if there are subscribers.
+    *
+    * @details      The delay depends on the last playback received:
+    *               - playing: regular interval, shortened to poll just after the end of the track;
+    *               - paused: slow interval;
+    *               - no active device or error: exponential back off.
+    *               Nothing is done for the reply of a request sent outside of the loop, so that it neither
+    *               restarts the timer nor advances the back off.
+    *
+    * @param[in]    playback: The last playback received, nullptr if the request failed.
+    ***************************************************************************************************/
+    void RequestHandlerPrivate::schedulePlaybackPoll(const CurrentPlayback *playback)
+    {
+        if (!m_playbackPollPending)
+        {
+            return;
+        }
+        m_playbackPollPending = false;
+
+        if (m_playbackSubscriberCount == 0)
+        {
+            return;
+        }
+
+        std::chrono::milliseconds interval;
+
+        if (!playback || !playback->getDevice().isActive())
+        {
+            interval = m_idlePlaybackPollInterval;
+            m_idlePlaybackPollInterval = std::min(m_idlePlaybackPollInterval * 2, PLAYBACK_POLL_IDLE_MAX_INTERVAL);
+        }
+        else
+        {
+            m_idlePlaybackPollInterval = PLAYBACK_POLL_IDLE_MIN_INTERVAL;
+
+            if (!playback->isPlaying())
+            {
+                interval = PLAYBACK_POLL_PAUSED_INTERVAL;
+            }
+            else
+            {
+                interval = PLAYBACK_POLL_PLAYING_INTERVAL;
+
+                // The progress has advanced since the playback was received if it was not modified since.
+                const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+                                         std::chrono::steady_clock::now() - m_cachedPlaybackTime);
+                const std::chrono::milliseconds remaining(playback->getTrack().getDurationMilliseconds()
+                                                          - playback->getProgressMilliseconds()
+                                                          - elapsed.count());
+                if (remaining.count() > 0 && remaining + PLAYBACK_POLL_TRACK_END_MARGIN < interval)
+                {
+                    interval = remaining + PLAYBACK_POLL_TRACK_END_MARGIN;
+                }
+            }
+        }
+
+        m_playbackPollTimer.start(interval);
+    }
+
+    /** ************************************************************************************************
+    * @brief        Record the time between queuing the request and receiving its reply.
+    ***************************************************************************************************/
+    void RequestHandlerPrivate::recordLatency(const PendingRequest &request)
+    {
+        const qint64 latency = std::chrono::duration_cast<std::chrono::milliseconds>(
+                    std::chrono::steady_clock::now() - request.createTime).count();
+
+        QMutexLocker locker(&m_statisticsMutex);
+        LatencyStatistics &statistics = m_latencyStatistics[request.lane];
+        m_totalLatencies[request.lane] += latency;
+        ++statistics.count;
+        statistics.lastMilliseconds    = latency;
+        statistics.averageMilliseconds = m_totalLatencies[request.lane] / statistics.count;
+        statistics.maximumMilliseconds = std::max(statistics.maximumMilliseconds, latency);
+    }
+
+    /** ************************************************************************************************
+    * @brief        Record the size, status and timings of a reply in the metrics of its endpoint.
+    *
+    * @details      Must be called before the body of the reply is read.
+    ***************************************************************************************************/
+    void RequestHandlerPrivate::recordReplyMetrics(const PendingRequest &request, QNetworkReply *reply)
+    {
+        using std::chrono::microseconds;
+        using std::chrono::duration_cast;
+
+        const auto now = std::chrono::steady_clock::now();
+        const int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+
+        QMutexLocker locker(&m_statisticsMutex);
+        EndpointMetrics &metrics = m_endpointMetrics[qMakePair(request.type, request.context)];
+        metrics.request = request.type;
+        metrics.context = ERROR_CONTEXT_STRINGS[static_cast<int>(request.context)];
+
+        ++metrics.requests;
+        metrics.bytesReceived += reply->bytesAvailable();
+        if (reply->error() != QNetworkReply::NoError || status >= 400)
+        {
+            ++metrics.errors;
+            ++metrics.errorsByStatus[status];
+        }
+
+        metrics.queueTime.record(duration_cast<microseconds>(request.sendTime - request.enqueueTime).count());
+        metrics.networkTime.record(duration_cast<microseconds>(now - request.sendTime).count());
+    }
+
+    /** ************************************************************************************************
+    * @brief        Record the time taken by the callback processing a reply.
+    ***************************************************************************************************/
+    void RequestHandlerPrivate::recordParseTime(const PendingRequest &request,
+                                                std::chrono::steady_clock::duration parseTime)
+    {
+        QMutexLocker locker(&m_statisticsMutex);
+        m_endpointMetrics[qMakePair(request.type, request.context)].parseTime.record(
+                    std::chrono::duration_cast<std::chrono::microseconds>(parseTime).count());
+    }
+
+    /** ************************************************************************************************
+    * @brief        Write all the metrics in the Prometheus format, for an exporter.
+    *
+    * @details      This must be called in the thread of the handler, as it reads the request queues.
+    ***************************************************************************************************/
+    void RequestHandlerPrivate::collectMetrics(MetricFamilies &families) const
+    {
+        static const QString LANE_NAMES[RequestLane_Count]{"interactive", "background"};
+
+        const std::vector<EndpointMetrics> endpoints = getEndpointMetrics();
+        const auto endpointLabels = [](const EndpointMetrics &metrics)
+        {
+            return MetricsExporter::label("request", REQUEST_NAMES[static_cast<int>(metrics.request)]) + ','
+                   + MetricsExporter::label("context", metrics.context);
+        };
+
+        families.writeHeader("qtify_requests_total", "counter", "Replies received from the API.");
+        for (const EndpointMetrics &metrics : endpoints)
+        {
+            families.writeSample("qtify_requests_total", endpointLabels(metrics), metrics.requests);
+        }
+
+        families.writeHeader("qtify_request_errors_total", "counter",
+                             "Replies with an error, by HTTP status (0 for network errors).");
+        for (const EndpointMetrics &metrics : endpoints)
+        {
+            for (auto iterator = metrics.errorsByStatus.cbegin(); iterator != metrics.errorsByStatus.cend(); ++iterator)
+            {
+                families.writeSample("qtify_request_errors_total",
+                                     endpointLabels(metrics) + ','
+                                     + MetricsExporter::label("status", QString::number(iterator.key())),
+                                     iterator.value());
+            }
+        }
+
+        families.writeHeader("qtify_received_bytes_total", "counter", "Size of the reply bodies.");
+        for (const EndpointMetrics &metrics : endpoints)
+        {
+            families.writeSample("qtify_received_bytes_total", endpointLabels(metrics),
+                                 metrics.bytesReceived);
+        }
+
+        const struct
+        {
+            QString name;
+            QString help;
+            LatencyHistogram EndpointMetrics::*histogram;
+        }
+        histograms[]
+        {
+            {"qtify_request_queue_seconds",   "Time from queuing a request to sending it.",
+             &EndpointMetrics::queueTime},
+            {"qtify_request_network_seconds", "Time from sending a request to receiving its reply.",
+             &EndpointMetrics::networkTime},
+            {"qtify_reply_parse_seconds",     "Time spent processing a reply.",
+             &EndpointMetrics::parseTime},
+            {"qtify_request_backoff_seconds", "Delay before retrying a request after a transient error.",
+             &EndpointMetrics::backoffTime},
+        };
+        for (const auto &histogram : histograms)
+        {
+            families.writeHeader(histogram.name, "histogram", histogram.help);
+            for (const EndpointMetrics &metrics : endpoints)
+            {
+                families.writeHistogram(histogram.name, endpointLabels(metrics),
+                                        metrics.*histogram.histogram);
+            }
+        }
+
+        families.writeHeader("qtify_requests_in_flight", "gauge", "Requests waiting for their reply.");
+        for (int lane = 0; lane < RequestLane_Count; ++lane)
+        {
+            families.writeSample("qtify_requests_in_flight", MetricsExporter::label("lane", LANE_NAMES[lane]),
+                                 m_activeRequestCounts[lane]);
+        }
+
+        families.writeHeader("qtify_requests_queued", "gauge", "Requests waiting to be sent.");
+        for (int lane = 0; lane < RequestLane_Count; ++lane)
+        {
+            families.writeSample("qtify_requests_queued", MetricsExporter::label("lane", LANE_NAMES[lane]),
+                                 m_requestQueues[lane].size());
+        }
+
+        families.writeHeader("qtify_request_retries_total", "counter",
+                             "Requests sent again after a transient error.");
+        for (int type = 0; type < static_cast<int>(SpotifyApiRequest::SpotifyRequest_Count); ++type)
+        {
+            families.writeSample("qtify_request_retries_total",
+                                 MetricsExporter::label("request", REQUEST_NAMES[type]),
+                                 getRetryStatistics(static_cast<SpotifyApiRequest>(type)).retries);
+        }
+
+        families.writeHeader("qtify_request_retries_exhausted_total", "counter",
+                             "Requests still failing after their last attempt.");
+        for (int type = 0; type < static_cast<int>(SpotifyApiRequest::SpotifyRequest_Count); ++type)
+        {
+            families.writeSample("qtify_request_retries_exhausted_total",
+                                 MetricsExporter::label("request", REQUEST_NAMES[type]),
+                                 getRetryStatistics(static_cast<SpotifyApiRequest>(type)).exhausted);
+        }
+
+        families.writeHeader("qtify_coalesced_requests_total", "counter",
+                             "Requests merged with another one instead of being sent.");
+        families.writeSample("qtify_coalesced_requests_total", QString(), getCoalescedRequestCount());
+
+        families.writeHeader("qtify_throttled_seconds_total", "counter",
+                             "Time spent throttled by the API (HTTP 429).");
+        families.writeSample("qtify_throttled_seconds_total", QString(), m_throttledTime.count() / 1e3);
+
+        const TokenRefreshStatistics tokenRefreshes = getTokenRefreshStatistics();
+        families.writeHeader("qtify_token_refreshes_total", "counter", "Refreshes of the access token.");
+        families.writeSample("qtify_token_refreshes_total", MetricsExporter::label("outcome", "success"),
+                             tokenRefreshes.successes);
+        families.writeSample("qtify_token_refreshes_total", MetricsExporter::label("outcome", "failure"),
+                             tokenRefreshes.failures);
+
+        const struct
+        {
+            QString name;
+            CacheStatistics statistics;
+        }
+        caches[]
+        {
+            {"catalog",   getCatalogMemoryCacheStatistics()},
+            {"album_art", getAlbumArtCacheStatistics()},
+        };
+        const struct
+        {
+            QString name;
+            QString type;
+            QString help;
+            int CacheStatistics::*value;
+        }
+        cacheMetrics[]
+        {
+            {"qtify_cache_hits_total",      "counter", "Lookups answered by an in-memory cache.",  &CacheStatistics::hits},
+            {"qtify_cache_misses_total",    "counter", "Lookups not found in an in-memory cache.", &CacheStatistics::misses},
+            {"qtify_cache_evictions_total", "counter", "Objects evicted from an in-memory cache.", &CacheStatistics::evictions},
+            {"qtify_cache_rejections_total", "counter", "Objects too large for an in-memory cache.", &CacheStatistics::rejections},
+            {"qtify_cache_objects",         "gauge",   "Objects in an in-memory cache.",           &CacheStatistics::count},
+            {"qtify_cache_size_bytes",      "gauge",   "Estimated size of an in-memory cache.",    &CacheStatistics::size},
+        };
+        for (const auto &metric : cacheMetrics)
+        {
+            families.writeHeader(metric.name, metric.type, metric.help);
+            for (const auto &cache : caches)
+            {
+                families.writeSample(metric.name, MetricsExporter::label("cache", cache.name),
+                                     cache.statistics.*metric.value);
+            }
+        }
+    }
+
+    /** ************************************************************************************************
+    * @brief        Send the request again later if it failed with a transient error.
+    *
+    * @details      The request is put back in its queue after an exponential back off with jitter, so
+    *               that clients failing at the same time do not retry at the same time.
+    *
+    * @return       true if the request will be retried, false if the reply must be processed.
+    ***************************************************************************************************/
+    bool RequestHandlerPrivate::retry(const PendingRequest &request, QNetworkReply *reply)
+    {
+        const RetryPolicy &policy = m_retryPolicies[static_cast<int>(request.type)];
+        const QVariant status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute);
+
+        const bool transient = status.isValid() ? policy.retryableStatusCodes.contains(status.toInt())
+                                                : policy.retryableErrors.contains(reply->error());
+        if (!transient)
+        {
+            return false;
+        }
+
+        QMutexLocker locker(&m_statisticsMutex);
+        RetryStatistics &statistics = m_retryStatistics[static_cast<int>(request.type)];
+
+        if (request.attempt + 1 >= policy.maxAttempts)
+        {
+            // Requests that are never retried have nothing to exhaust.
+            if (policy.maxAttempts > 1)
+            {
+                ++statistics.exhausted;
+            }
+            return false;
+        }
+
+        std::chrono::milliseconds delay = policy.baseDelay * (1 << std::min(request.attempt, 16));
+        delay = std::min(delay, policy.maxDelay);
+        const double jitter = policy.jitter * (2.0 * QRandomGenerator::global()->generateDouble() - 1.0);
+        delay += std::chrono::milliseconds(static_cast<qint64>(delay.count() * jitter));
+        delay = std::max(delay, std::chrono::milliseconds(0));
+
+        ++statistics.retries;
+        m_endpointMetrics[qMakePair(request.type, request.context)].backoffTime.record(
+                    std::chrono::duration_cast<std::chrono::microseconds>(delay).count());
+        locker.unlock();
+
+        qWarning() << "Error in " << ERROR_CONTEXT_STRINGS[static_cast<int>(request.context)]
+                   << ":" << reply->errorString() << ", retrying in" << delay.count() << "ms";
+
+        PendingRequest next = request;
+        ++next.attempt;
+        QTimer *timer = new QTimer(this);
+        timer->setSingleShot(true);
+        connect(timer, &QTimer::timeout, this, [this, timer, next]()
+        {
+            m_retryTimers.removeOne(timer);
+            timer->deleteLater();
+            requeue(next);
+            dispatchRequests();
+        });
+        m_retryTimers.append(timer);
+        timer->start(delay);
+
+        return true;
+    }
+
+    /** ************************************************************************************************
+    * @brief        Build an authenticated request to the given Spotify API URL.
+    *
+    * @details      This does the same as QOAuth2AuthorizationCodeFlow but allows adding headers.
+    ***************************************************************************************************/
+    QNetworkRequest RequestHandlerPrivate::buildRequest(const QUrl &url) const
+    {
+        QNetworkRequest request(url);
+        request.setRawHeader("Authorization", "Bearer " + m_authManager->token().toUtf8());
+        // Concurrent requests share one multiplexed connection when the server supports HTTP/2.
+        request.setAttribute(QNetworkRequest::Http2AllowedAttribute, true);
+
+        return request;
+    }
+
+    /** ************************************************************************************************
+    * @brief        Check if the reply is a "304 Not Modified" answer to a conditional GET request.
+    ***************************************************************************************************/
+    bool RequestHandlerPrivate::isNotModified(QNetworkReply *reply)
+    {
+        return reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt() == 304;
+    }
+
+    /** ************************************************************************************************
+    * @brief        Remember the ETag of a reply so that the next request to the same URL is conditional.
+    *
+    * @details      This must be called together with caching the object parsed from the reply, so that
+    *               a "304 Not Modified" answer always has a cached object to emit.
+    ***************************************************************************************************/
+    void RequestHandlerPrivate::storeETag(QNetworkReply *reply)
+    {
+        const QByteArray eTag = reply->rawHeader("ETag");
+        if (eTag.isEmpty())
+        {
+            m_eTags.remove(reply->request().url());
+        }
+        else
+        {
+            m_eTags.insert(reply->request().url(), eTag);
+        }
+    }
+
+    /** ************************************************************************************************
+    * @brief        Parse the body of a successful reply.
+    *
+    * @details      The body is parsed once and the models decode their members from the resulting
+    *               object, expensive members being decoded on demand. Empty bodies (e.g. "204 No Content")
+    *               are not parsed at all and give an empty object.
+    *               A body that is not a JSON object is reported with handleRegularError(), so that
+    *               callers keep their previous model instead of replacing it with an empty one.
+    *
+    * @param[in]    reply: The reply to read.
+    * @param[in]    context: The request context, for error reporting.
+    * @param[out]   json: The parsed object, empty on failure.
+    *
+    * @return       False if the body is not a valid JSON object.
+    ***************************************************************************************************/
+    bool RequestHandlerPrivate::readJsonObject(QNetworkReply *reply, ErrorContext context, QJsonObject &json)
+    {
+        json = QJsonObject();
+
+        const QByteArray data = reply->readAll();
+        if (data.isEmpty())
+        {
+            return true;
+        }
+
+        QJsonParseError parseError;
+        const QJsonDocument document = QJsonDocument::fromJson(data, &parseError);
+        if (parseError.error != QJsonParseError::NoError || !document.isObject())
+        {
+            reportInvalidJson(reply, context, parseError.error != QJsonParseError::NoError
+                                              ? "Invalid JSON: " + parseError.errorString()
+                                              : QStringLiteral("Invalid JSON: not an object"));
+            return false;
+        }
+
+        json = document.object();
+        return true;
+    }
+
+    /** ************************************************************************************************
+    * @brief        Build the playback straight from the body of a successful reply.
+    *
+    * @details      The playback is polled, so its reply is read in a single pass with a JsonReader
+    *               instead of building a JSON document first: unknown keys are skipped and no JSON is
+    *               kept by the models. Empty bodies and invalid bodies are handled like readJsonObject().
+    *
+    * @param[in]    reply: The reply to read.
+    * @param[in]    context: The request context, for error reporting.
+    * @param[out]   playback: The playback read, empty on failure.
+    *
+    * @return       False if the body is not a valid JSON object.
+    ***************************************************************************************************/
+    bool RequestHandlerPrivate::readPlayback(QNetworkReply *reply, ErrorContext context, CurrentPlayback &playback)
+    {
+        playback = CurrentPlayback();
+
+        const QByteArray data = reply->readAll();
+        if (data.isEmpty())
+        {
+            return true;
+        }
+
+        JsonReader reader(data);
+        if (!reader.isObject())
+        {
+            reportInvalidJson(reply, context, QStringLiteral("Invalid JSON: not an object"));
+            return false;
+        }
+
+        playback = CurrentPlayback(reader);
+        if (!reader.finish())
+        {
+            playback = CurrentPlayback();
+            reportInvalidJson(reply, context, QString("Invalid JSON at offset %1").arg(reader.errorOffset()));
+            return false;
+        }
+
+        return true;
+    }
+
+    /** ************************************************************************************************
+    * @brief        Report a body that is not a valid JSON object as an API error with the HTTP status
+    *               of the reply.
+    ***************************************************************************************************/
+    void RequestHandlerPrivate::reportInvalidJson(QNetworkReply *reply, ErrorContext context, const QString &message)
+    {
+        const QJsonObject error{{"status", reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt()},
+                                {"message", message}};
+        handleRegularError(context, QJsonDocument(QJsonObject{{"error", error}}).toJson(QJsonDocument::Compact));
+    }
+
+    /** ************************************************************************************************
+    * @brief        Refresh the token to access the API.
+    *
+    * @details      QOAuth2AuthorizationCodeFlow::refreshAccessToken() doesn't work with Spotify.
+    *               The header "Authorization" value is incorrect. Until a way to override it is found,
+    *               a custom request is sent.
+    *               The query is the step 4 of the authorization flow documentation.
+    *               https://developer.spotify.com/documentation/general/guides/authorization-guide/#authorization-code-flow
+    *               Only one refresh is pending at a time. API requests are held until it completes.
+    ***************************************************************************************************/
+    void RequestHandlerPrivate::refreshToken()
+    {
+        if (m_tokenRefreshPending || m_authManager->refreshToken().isEmpty())
+        {
+            return;
+        }
+
+        m_tokenRefreshPending = true;
+        m_tokenRefreshTimer.stop();
+
+        // Construct the URL.
+        QUrl url(m_authManager->accessTokenUrl());
+
+        // Add query parameters
+        QUrlQuery query;
+        query.addQueryItem("grant_type", "refresh_token");
+        query.addQueryItem("refresh_token", m_authManager->refreshToken());
+        url.setQuery(query);
+
+        // Create the request.
+        QNetworkRequest request(url);
+        // The "Authorization" header is  a base64 encoding of the client ID and secret.
+        QString authorization("Basic %1");
+        QByteArray code;
+        code.append(m_authManager->clientIdentifier() + ":" +  m_authManager->clientIdentifierSharedKey());
+        request.setRawHeader("Authorization", QByteArray("Basic ") + code.toBase64());
+        request.setHeader(QNetworkRequest::ContentTypeHeader, "application/x-www-form-urlencoded");
+
+        auto reply = m_networkAccessManager->post(request, QByteArray());
+        connect(reply, &QNetworkReply::finished, this, &RequestHandlerPrivate::onRefreshTokenReplyReceived);
+    }
+
+    /** ************************************************************************************************
+    * @brief        Start the timer refreshing the access token shortly before it expires.
+    *
+    * @param[in]    expiresIn: The remaining lifetime of the access token.
+    ***************************************************************************************************/
+    void RequestHandlerPrivate::scheduleTokenRefresh(std::chrono::seconds expiresIn)
+    {
+        if (expiresIn.count() <= 0)
+        {
+            expiresIn = TOKEN_DEFAULT_LIFETIME;
+        }
+
+        m_tokenRefreshTimer.start(std::max(expiresIn - TOKEN_REFRESH_MARGIN, TOKEN_REFRESH_MIN_DELAY));
+    }
+
+    /** ************************************************************************************************
+    * @brief        Queue a GET request and call callback when a reply is received.
+    ***************************************************************************************************/
+    void RequestHandlerPrivate::get(SpotifyApiRequest requestType, ErrorContext context, ReplyCallback callback,
+                                    const QVariantMap &parameters, const QString &resourceId)
+    {
+        const QUrl url = buildUrl(requestType, parameters, resourceId);
+
+        // Each GET URL is always handled by the same callback, so if an identical request is already
+        // pending, its reply will feed this caller as well.
+        if (m_pendingGets.contains(url))
+        {
+            ++m_coalescedRequestCount;
+            return;
+        }
+
+        m_pendingGets.insert(url);
+        enqueue({requestType, QNetworkAccessManager::GetOperation, url, context, callback});
+    }
+
+    /** ************************************************************************************************
+    * @brief        Queue a PUT request. Errors are reported with the given context.
+    ***************************************************************************************************/
+    void RequestHandlerPrivate::put(SpotifyApiRequest requestType, ErrorContext context, const QVariantMap &parameters,
+                                    ReplyCallback callback)
+    {
+        enqueue({requestType, QNetworkAccessManager::PutOperation, buildUrl(requestType, parameters), context, callback});
+    }
+
+    /** ************************************************************************************************
+    * @brief        Queue a POST request. Errors are reported with the given context.
+    ***************************************************************************************************/
+    void RequestHandlerPrivate::post(SpotifyApiRequest requestType, ErrorContext context, const QVariantMap &parameters,
+                                     ReplyCallback callback)
+    {
+        enqueue({requestType, QNetworkAccessManager::PostOperation, buildUrl(requestType, parameters), context, callback});
+    }
+
+    /** ************************************************************************************************
+    * @brief        Add a request to the queue of its lane and send what can be sent.
+    *
+    * @details      Reads go to the background lane, playback commands to the interactive lane.
+    ***************************************************************************************************/
+    void RequestHandlerPrivate::enqueue(PendingRequest request)
+    {
+        request.lane = request.operation == QNetworkAccessManager::GetOperation ? RequestLane_Background
+                                                                                : RequestLane_Interactive;
+        request.createTime  = std::chrono::steady_clock::now();
+        request.enqueueTime = request.createTime;
+
+        m_requestQueues[request.lane].append(request);
+        dispatchRequests();
+    }
+
+    /** ************************************************************************************************
+    * @brief        Put a request sent before back at the front of the queue of its lane.
+    *
+    * @details      Its queue time restarts, so that the time of the previous attempts is not counted as
+    *               queue time.
+    ***************************************************************************************************/
+    void RequestHandlerPrivate::requeue(PendingRequest request)
+    {
+        request.enqueueTime = std::chrono::steady_clock::now();
+        m_requestQueues[request.lane].prepend(request);
+    }
+
+    /** ************************************************************************************************
+    * @brief        Get the queue from which the next request must be sent.
+    *
+    * @return       The interactive queue if it is not empty, else the background queue if the limit of
+    *               concurrent background requests is not reached, else nullptr.
+    ***************************************************************************************************/
+    QList<RequestHandlerPrivate::PendingRequest> *RequestHandlerPrivate::nextQueue()
+    {
+        if (!m_requestQueues[RequestLane_Interactive].isEmpty())
+        {
+            return &m_requestQueues[RequestLane_Interactive];
+        }
+
+        if (   !m_requestQueues[RequestLane_Background].isEmpty()
+            && m_activeRequestCounts[RequestLane_Background] < m_maxBackgroundRequests)
+        {
+            return &m_requestQueues[RequestLane_Background];
+        }
+
+        return nullptr;
+    }
+
+    /** ************************************************************************************************
+    * @brief        Send queued requests while the API and the rate limit allow it.
+    *
+    * @details      When a request cannot be sent, the dispatch timer is started to try again later.
+    ***************************************************************************************************/
+    void RequestHandlerPrivate::dispatchRequests()
+    {
+        const auto now = std::chrono::steady_clock::now();
+
+        // While the token is being refreshed, requests are held to be sent with the new token.
+        if (m_tokenRefreshPending)
+        {
+            reportSchedulerStatus();
+            return;
+        }
+
+        if (now < m_throttledUntil)
+        {
+            m_dispatchTimer.start(std::chrono::duration_cast<std::chrono::milliseconds>(m_throttledUntil - now)
+                                  + std::chrono::milliseconds(1));
+        }
+        else
+        {
+            while (QList<PendingRequest> *queue = nextQueue())
+            {
+                if (!m_tokenBucket.tryAcquire(now))
+                {
+                    m_dispatchTimer.start(m_tokenBucket.timeUntilAvailable(now));
+                    break;
+                }
+
+                send(queue->takeFirst());
+            }
+        }
+
+        reportSchedulerStatus();
+    }
+
+    /** ************************************************************************************************
+    * @brief        Send a request to the Spotify API.
+    ***************************************************************************************************/
+    void RequestHandlerPrivate::send(const PendingRequest &request)
+    {
+        QNetworkRequest networkRequest(buildRequest(request.url));
+        QNetworkReply *reply = nullptr;
+
+        switch (request.operation)
+        {
+            case QNetworkAccessManager::GetOperation:
+            {
+                // Let the server answer "304 Not Modified" if nothing has changed since the last reply.
+                const QByteArray eTag = m_eTags.value(request.url);
+                if (!eTag.isEmpty())
+                {
+                    networkRequest.setRawHeader("If-None-Match", eTag);
+                }
+
+                reply = m_networkAccessManager->get(networkRequest);
+                break;
+            }
+
+            case QNetworkAccessManager::PutOperation:
+                networkRequest.setHeader(QNetworkRequest::ContentTypeHeader, "application/x-www-form-urlencoded");
+                reply = m_networkAccessManager->put(networkRequest, QByteArray());
+                break;
+
+            case QNetworkAccessManager::PostOperation:
+                networkRequest.setHeader(QNetworkRequest::ContentTypeHeader, "application/x-www-form-urlencoded");
+                reply = m_networkAccessManager->post(networkRequest, QByteArray());
+                break;
+
+            default:
+                qWarning() << "Unsupported operation in " << ERROR_CONTEXT_STRINGS[static_cast<int>(request.context)];
+                return;
+        }
+
+        auto iterator = m_activeRequests.insert(reply, request);
+        iterator->sendTime = std::chrono::steady_clock::now();
+        ++m_activeRequestCounts[request.lane];
+        connect(reply, &QNetworkReply::finished, this, &RequestHandlerPrivate::onReplyReceived);
+    }
+
+    /** ************************************************************************************************
+    * @brief        Stop sending requests for the duration asked by a "429 Too Many Requests" reply.
+    ***************************************************************************************************/
+    void RequestHandlerPrivate::throttle(QNetworkReply *reply)
+    {
+        bool ok = false;
+        std::chrono::seconds retryAfter(reply->rawHeader("Retry-After").toInt(&ok));
+        if (!ok || retryAfter.count() <= 0)
+        {
+            retryAfter = std::chrono::seconds(1);
+        }
+
+        const auto now = std::chrono::steady_clock::now();
+        const auto until = now + retryAfter;
+
+        if (until > m_throttledUntil)
+        {
+            m_throttledTime += std::chrono::duration_cast<std::chrono::milliseconds>(until - std::max(now, m_throttledUntil));
+            m_throttledUntil = until;
+        }
+
+        qWarning() << "Too many requests, sending paused for" << retryAfter.count() << "s";
+    }
+
+    /** ************************************************************************************************
+    * @brief        Emit schedulerStatusChanged if the queue depth or the throttled time has changed.
+    ***************************************************************************************************/
+    void RequestHandlerPrivate::reportSchedulerStatus()
+    {
+        int queueDepth = 0;
+        for (const auto &queue : m_requestQueues)
+        {
+            queueDepth += queue.size();
+        }
+
+        if (queueDepth != m_reportedQueueDepth || m_throttledTime != m_reportedThrottledTime)
+        {
+            m_reportedQueueDepth    = queueDepth;
+            m_reportedThrottledTime = m_throttledTime;
+            emit schedulerStatusChanged(m_reportedQueueDepth, m_reportedThrottledTime.count());
+        }
+    }
+
+    /** ************************************************************************************************
+    * @brief        Handle any regular network error.
+    *
+    * @details      There are two types of error: regular and authentication. Each has its own JSON
+    *               format. handleRegularError() and handleAuthenticationError() process the JSON
+    *               data differently.
+    ***************************************************************************************************/
+    void RequestHandlerPrivate::handleRegularError(RequestHandlerPrivate::ErrorContext context, const QByteArray &errorData)
+    {
+        Error error(QJsonDocument::fromJson(errorData).object()["error"].toObject());
+        qWarning() << "Error in " << ERROR_CONTEXT_STRINGS[static_cast<int>(context)]
+                   << ":" << error.getStatus() << "-" << error.getMessage();
+    }
+
+    /** ************************************************************************************************
+    * @brief        Handle any regular network error.
+    *
+    * @details      There are two types of error: regular and authentication. Each has its own JSON
+    *               format. handleRegularError() and handleAuthenticationError() process the JSON
+    *               data differently.
+    ***************************************************************************************************/
+    void RequestHandlerPrivate::handleAuthenticationError(RequestHandlerPrivate::ErrorContext context, const QByteArray &errorData)
+    {
+        AuthenticationError error(QJsonDocument::fromJson(errorData).object());
+        qWarning() << "Error in " << ERROR_CONTEXT_STRINGS[static_cast<int>(context)]
+                   << ":" << error.getError() << "-" << error.getErrorDescription();
+    }
+
+    /** ************************************************************************************************
+    * @brief        Function called when API access has been granted by the user.
+    ***************************************************************************************************/
+    void RequestHandlerPrivate::onAccessGranted()
+    {
+        emit accessGranted(m_authManager->token(), m_authManager->refreshToken());
+
+        const QDateTime expiration = m_authManager->expirationAt();
+        scheduleTokenRefresh(std::chrono::seconds(expiration.isValid() ? QDateTime::currentDateTime().secsTo(expiration) : 0));
+    }
+
+    /** ************************************************************************************************
+    * @brief        Function called when a reply is received after calling refreshToken().
+    ***************************************************************************************************/
+    void RequestHandlerPrivate::onRefreshTokenReplyReceived()
+    {
+        if (QNetworkReply *reply = qobject_cast<QNetworkReply*>(QObject::sender()))
+        {
+            QJsonObject json;
+            bool refreshed = false;
+
+            if (reply->error() != QNetworkReply::NoError)
+            {
+                handleAuthenticationError(ErrorContext::Context_RefreshTokenReply, reply->readAll());
+            }
+            else
+            {
+                refreshed = readJsonObject(reply, ErrorContext::Context_RefreshTokenReply, json)
+                            && !json["access_token"].toString().isEmpty();
+            }
+
+            QMutexLocker locker(&m_statisticsMutex);
+            ++(refreshed ? m_tokenRefreshStatistics.successes : m_tokenRefreshStatistics.failures);
+            locker.unlock();
+
+            if (!refreshed)
             {
-                handleRegularError(ErrorContext::Context_GetCurrentPlaybackReply, reply->readAll());
+                // Try again later.
+                m_tokenRefreshTimer.start(TOKEN_REFRESH_MIN_DELAY);
             }
             else
             {
-                emit currentPlaybackUpdated(QSharedPointer<CurrentPlayback>(new CurrentPlayback(QJsonDocument::fromJson(reply->readAll()).object())));
+                m_authManager->setToken(json["access_token"].toString());
+
+                // The API may issue a new refresh token.
+                const QString refreshToken = json["refresh_token"].toString();
+                if (!refreshToken.isEmpty())
+                {
+                    m_authManager->setRefreshToken(refreshToken);
+                }
+
+                emit tokenRefreshed(m_authManager->refreshToken());
+
+                // Refresh the token before it expires.
+                scheduleTokenRefresh(std::chrono::seconds(json["expires_in"].toInt()));
+            }
+
+            reply->deleteLater();
+        }
+
+        // Send the requests held during the refresh. If the refresh failed, requests that were
+        // rejected once are not held again and report their error.
+        m_tokenRefreshPending = false;
+        dispatchRequests();
+    }
+
+    /** ************************************************************************************************
+    * @brief        Function called when a reply to any request sent with send() is received.
+    *
+    * @details      Throttled requests ("429 Too Many Requests") are put back at the front of their queue.
+    *               Requests rejected because the access token has expired ("401 Unauthorized") are put
+    *               back at the front of their queue once and the token is refreshed: they are replayed
+    *               with the new token.
+    *               Requests failing with a transient error are retried according to their RetryPolicy.
+    *               Other replies are processed by the callback of the request.
+    ***************************************************************************************************/
+    void RequestHandlerPrivate::onReplyReceived()
+    {
+        if (QNetworkReply *reply = qobject_cast<QNetworkReply*>(QObject::sender()))
+        {
+            auto iterator = m_activeRequests.find(reply);
+            if (iterator != m_activeRequests.end())
+            {
+                const PendingRequest request = iterator.value();
+                m_activeRequests.erase(iterator);
+                --m_activeRequestCounts[request.lane];
+                recordReplyMetrics(request, reply);
+
+                const int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+
+                if (status == 429)
+                {
+                    throttle(reply);
+                    requeue(request);
+                }
+                else if (status == 401 && !request.replayed)
+                {
+                    PendingRequest replay = request;
+                    replay.replayed = true;
+                    requeue(replay);
+                    refreshToken();
+                }
+                else if (!retry(request, reply))
+                {
+                    if (request.operation == QNetworkAccessManager::GetOperation)
+                    {
+                        m_pendingGets.remove(request.url);
+                    }
+
+                    recordLatency(request);
+
+                    const auto parseStart = std::chrono::steady_clock::now();
+                    (this->*request.callback)(reply, request.context);
+                    recordParseTime(request, std::chrono::steady_clock::now() - parseStart);
+                }
+
+                // A slot may have been freed for a background request.
+                dispatchRequests();
             }
 
             reply->deleteLater();
         }
     }
+
+    /** ************************************************************************************************
+    * @brief        Function called when a reply to any POST or PUT request is received.
+    *
+    * @details      The response is ignored, we just process any error.
+    ***************************************************************************************************/
+    void RequestHandlerPrivate::onPutPostReplyReceived(QNetworkReply *reply, ErrorContext context)
+    {
+        if (reply->error() != QNetworkReply::NoError)
+        {
+            handleRegularError(context, reply->readAll());
+        }
+    }
+
+    /** ************************************************************************************************
+    * @brief        Function called when a reply to a seek request is received.
+    *
+    * @details      Send the latest position requested while this one was pending, if any.
+    ***************************************************************************************************/
+    void RequestHandlerPrivate::onSeekReplyReceived(QNetworkReply *reply, ErrorContext context)
+    {
+        onPutPostReplyReceived(reply, context);
+
+        m_seekPending = false;
+        if (m_nextSeekPosition >= 0)
+        {
+            const int positionMs = m_nextSeekPosition;
+            m_nextSeekPosition = -1;
+            seek(positionMs);
+        }
+    }
+
+    /** ************************************************************************************************
+    * @brief        Function called when a reply to a next or previous track request is received.
+    *
+    * @details      Send the next skip of the net count requested while this one was pending, if any.
+    ***************************************************************************************************/
+    void RequestHandlerPrivate::onSkipReplyReceived(QNetworkReply *reply, ErrorContext context)
+    {
+        onPutPostReplyReceived(reply, context);
+
+        m_skipPending = false;
+        const int count = m_queuedSkips;
+        m_queuedSkips = 0;
+        skip(count);
+    }
+
+    /** ************************************************************************************************
+    * @brief        Function called when a reply to getCurrentUserInformation is received.
+    ***************************************************************************************************/
+    void RequestHandlerPrivate::onGetCurrentUserInformationReplyReceived(QNetworkReply *reply, ErrorContext context)
+    {
+        if (reply->error() != QNetworkReply::NoError)
+        {
+            handleRegularError(context, reply->readAll());
+        }
+        else if (isNotModified(reply))
+        {
+            emit userDataAvailable(m_cachedUser);
+        }
+        else
+        {
+            QJsonObject json;
+            if (readJsonObject(reply, context, json))
+            {
+                m_cachedUser = User(json);
+                storeETag(reply);
+                emit userDataAvailable(m_cachedUser);
+            }
+        }
+    }
+
+    /** ************************************************************************************************
+    * @brief        Function called when a reply to getCurrentPlaybackInformation is received.
+    ***************************************************************************************************/
+    void RequestHandlerPrivate::onGetCurrentPlaybackInformationReceived(QNetworkReply *reply, ErrorContext context)
+    {
+        if (reply->error() != QNetworkReply::NoError)
+        {
+            handleRegularError(context, reply->readAll());
+            schedulePlaybackPoll(nullptr);
+        }
+        else if (isNotModified(reply))
+        {
+            emit currentPlaybackUpdated(m_cachedPlayback);
+            schedulePlaybackPoll(&m_cachedPlayback);
+        }
+        else
+        {
+            // Keep the previous playback and its ETag if the body is invalid.
+            CurrentPlayback playback;
+            if (!readPlayback(reply, context, playback))
+            {
+                schedulePlaybackPoll(nullptr);
+                return;
+            }
+
+            const QString previousTrackId = m_cachedPlayback.getTrack().getId();
+            m_cachedPlayback = playback;
+            m_cachedPlaybackTime = std::chrono::steady_clock::now();
+            storeETag(reply);
+
+            const Track &track = m_cachedPlayback.getTrack();
+            if (!StringPool::isSame(track.getId(), previousTrackId))
+            {
+                // Later lookups of the current track and its album are answered without requests. The
+                // reader decodes all the members, so the sizes are estimated from the serialized models
+                // like the objects loaded from the persistent cache.
+                cacheCatalogObject(Catalog_Track, track.getId(), QVariant::fromValue(track),
+                                   Serialization::serialize(track).size() * CATALOG_SERIALIZED_SIZE_FACTOR, false);
+                cacheCatalogObject(Catalog_Album, track.getAlbum().getId(), QVariant::fromValue(track.getAlbum()),
+                                   Serialization::serialize(track.getAlbum()).size() * CATALOG_SERIALIZED_SIZE_FACTOR,
+                                   false);
+
+                // Have the artwork of a new track ready before it is displayed.
+                if (!m_albumArtPrefetchSize.isEmpty())
+                {
+                    m_artworkLoader.prefetch(track.getAlbum().getImages(), m_albumArtPrefetchSize);
+                }
+            }
+
+            emit currentPlaybackUpdated(m_cachedPlayback);
+            schedulePlaybackPoll(&m_cachedPlayback);
+        }
+    }
+
+    /** ************************************************************************************************
+    * @brief        Function called when a reply to a catalog lookup chunk is received.
+    *
+    * @details      The API answers with the objects in the order of the requested ids, and null for
+    *               unknown ids. On error, the ids of the chunk are considered unknown so that the lookups
+    *               waiting for them still complete.
+    ***************************************************************************************************/
+    void RequestHandlerPrivate::onGetCatalogReplyReceived(QNetworkReply *reply, ErrorContext context)
+    {
+        int type = 0;
+        while (type < Catalog_Count && CATALOG_ENDPOINTS[type].context != context)
+        {
+            ++type;
+        }
+        if (type == Catalog_Count)
+        {
+            return;
+        }
+
+        const QStringList ids = QUrlQuery(reply->request().url()).queryItemValue("ids").split(',', Qt::SkipEmptyParts);
+        QJsonArray jsonObjects;
+
+        if (reply->error() != QNetworkReply::NoError)
+        {
+            handleRegularError(context, reply->readAll());
+        }
+        else
+        {
+            // On failure, the ids are considered unknown like on a network error.
+            QJsonObject json;
+            if (readJsonObject(reply, context, json))
+            {
+                jsonObjects = json.value(CATALOG_ENDPOINTS[type].key).toArray();
+            }
+        }
+
+        for (int i = 0; i < ids.size(); ++i)
+        {
+            const QJsonObject json = jsonObjects.at(i).toObject();
+            QVariant object;
+
+            if (!json.isEmpty())
+            {
+                object = CATALOG_ENDPOINTS[type].parse(json);
+                cacheCatalogObject(static_cast<CatalogType>(type), ids[i], object, estimateJsonSize(json), true);
+            }
+
+            m_catalogIdsInFlight[type].remove(ids[i]);
+            m_catalogObjects[type].insert(ids[i], object);
+        }
+
+        completeCatalogBatches();
+    }
+
+    /** ************************************************************************************************
+    * @brief        Function called when a page of a paginated collection is received.
+    *
+    * @details      The items of saved tracks and playlists wrap the track in a "track" object, album
+    *               tracks are the items themselves. The fetch ends when the first page fails.
+    ***************************************************************************************************/
+    void RequestHandlerPrivate::onGetPageReplyReceived(QNetworkReply *reply, ErrorContext context)
+    {
+        const QUrl collectionUrl = reply->request().url().adjusted(QUrl::RemoveQuery);
+        auto iterator = m_pagedFetches.find(collectionUrl);
+        if (iterator == m_pagedFetches.end())
+        {
+            return;
+        }
+
+        PagedFetch &fetch = iterator.value();
+        --fetch.activePages;
+
+        QJsonObject json;
+        bool received = false;
+
+        if (reply->error() != QNetworkReply::NoError)
+        {
+            handleRegularError(context, reply->readAll());
+        }
+        else
+        {
+            received = readJsonObject(reply, context, json);
+        }
+
+        if (!received)
+        {
+            ++fetch.failedPages;
+            if (fetch.total < 0)
+            {
+                fetch.total = 0;
+            }
+        }
+        else
+        {
+            const QJsonArray items = json.value("items").toArray();
+            const int offset = json.value("offset").toInt();
+            fetch.total = json.value("total").toInt();
+
+            std::vector<Track> tracks;
+            tracks.reserve(static_cast<size_t>(items.size()));
+            for (const auto &item : items)
+            {
+                const QJsonObject itemObject = item.toObject();
+                tracks.emplace_back(itemObject.contains("track") ? itemObject.value("track").toObject() : itemObject);
+            }
+
+            switch (fetch.type)
+            {
+                case SpotifyApiRequest::SpotifyRequest_SavedTracks:
+                    emit savedTracksPageAvailable(offset, fetch.total, tracks);
+                    break;
+
+                case SpotifyApiRequest::SpotifyRequest_AlbumTracks:
+                    emit albumTracksPageAvailable(fetch.resourceId, offset, fetch.total, tracks);
+                    break;
+
+                case SpotifyApiRequest::SpotifyRequest_PlaylistTracks:
+                    emit playlistTracksPageAvailable(fetch.resourceId, offset, fetch.total, tracks);
+                    break;
+
+                default:
+                    break;
+            }
+        }
+
+        requestPages(collectionUrl);
+    }
 }
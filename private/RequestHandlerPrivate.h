@@ -1,21 +1,39 @@
 #ifndef REQUESTHANDLERPRIVATE_H
 #define REQUESTHANDLERPRIVATE_H
 
+#include <atomic>
 #include <chrono>
 #include <memory>
 
 #include <QObject>
+#include <QMutex>
 #include <QOAuth2AuthorizationCodeFlow>
 #include <QOAuthHttpServerReplyHandler>
 #include <QNetworkAccessManager>
-#include <QSharedPointer>
 #include <QTimer>
 #include <QMap>
+#include <QList>
+#include <QSet>
+#include <QHash>
+#include <QPair>
+#include <QStringList>
+#include <QJsonObject>
 
 #include "models/User.h"
 #include "models/CurrentPlayback.h"
+#include "models/Track.h"
+#include "models/Album.h"
+#include "models/Artist.h"
 #include "models/Error.h"
 #include "models/AuthenticationError.h"
+#include "RequestStatistics.h"
+#include "RetryPolicy.h"
+#include "SpotifyApiRequest.h"
+#include "TokenBucket.h"
+#include "CatalogCache.h"
+#include "CatalogMemoryCache.h"
+#include "ArtworkLoader.h"
+#include "MetricsExporter.h"
 
 namespace Qtify
 {
@@ -28,24 +46,6 @@ namespace Qtify
     {
         Q_OBJECT
 
-        /** ************************************************************************************************
-        * @enum     SpotifyApiRequest
-        *
-        * @brief    List of requests the API can handle.
-        ***************************************************************************************************/
-        enum class SpotifyApiRequest
-        {
-            SpotifyRequest_UserInformation, /// Data of the user currently logged in.
-            SpotifyRequest_CurrentPlayback, /// Current Spotify client playback.
-            SpotifyRequest_PausePlayback,   /// Pause current Spotify client playback.
-            SpotifyRequest_ResumePlayback,  /// Resume current Spotify client playback.
-            SpotifyRequest_NextTrack,       /// Go to the next track.
-            SpotifyRequest_PreviousTrack,   /// Go to the previous track.
-            SpotifyRequest_Seek,            /// Go to a position in the current track.
-
-            SpotifyRequest_Count /// Number of available request types.
-        };
-
         /** ************************************************************************************************
         * @enum     ErrorContext
         *
@@ -62,28 +62,132 @@ namespace Qtify
             Context_NextTrack,
             Context_PreviousTrack,
             Context_Seek,
+            Context_GetTracksReply,
+            Context_GetAlbumsReply,
+            Context_GetArtistsReply,
+            Context_GetSavedTracksReply,
+            Context_GetAlbumTracksReply,
+            Context_GetPlaylistTracksReply,
 
             Context_Count, // Number of available contexts.
         };
 
+        // Function processing the reply of a request.
+        using ReplyCallback = void (RequestHandlerPrivate::*)(QNetworkReply *reply, ErrorContext context);
+
+        /** ************************************************************************************************
+        * @struct   PendingRequest
+        *
+        * @brief    A request waiting in the queue or waiting for its reply.
+        ***************************************************************************************************/
+        struct PendingRequest
+        {
+            SpotifyApiRequest type;
+            QNetworkAccessManager::Operation operation;
+            QUrl url;
+            ErrorContext context;
+            ReplyCallback callback;
+            RequestLane lane;
+            std::chrono::steady_clock::time_point createTime;  // First queuing of the request.
+            std::chrono::steady_clock::time_point enqueueTime; // Last queuing, after a retry or a replay.
+            std::chrono::steady_clock::time_point sendTime;
+            bool replayed = false; // Already sent again after a token refresh.
+            int attempt = 0;       // Number of retries after a transient error.
+        };
+
+        /** ************************************************************************************************
+        * @enum     CatalogType
+        *
+        * @brief    Types of catalog objects that can be looked up by id.
+        ***************************************************************************************************/
+        enum CatalogType
+        {
+            Catalog_Track,
+            Catalog_Album,
+            Catalog_Artist,
+
+            Catalog_Count, // Number of catalog types.
+        };
+
+        /** ************************************************************************************************
+        * @struct   CatalogEndpoint
+        *
+        * @brief    How the objects of a catalog type are requested.
+        ***************************************************************************************************/
+        struct CatalogEndpoint
+        {
+            SpotifyApiRequest request;
+            ErrorContext context;
+            QString key; // Key of the array of objects in the reply.
+            int maxIds;  // Maximum number of ids in a request.
+
+            // Conversions of the model of this type, stored in a QVariant.
+            QVariant (*parse)(const QJsonObject &json);
+            QVariant (*deserialize)(const QByteArray &data);
+            QByteArray (*serialize)(const QVariant &object);
+        };
+
+        /** ************************************************************************************************
+        * @struct   CatalogBatch
+        *
+        * @brief    A lookup of catalog objects waiting for some of them.
+        ***************************************************************************************************/
+        struct CatalogBatch
+        {
+            CatalogType type;
+            QStringList ids;       // Requested ids, in the order of the results.
+            QSet<QString> missing; // Ids not received yet.
+        };
+
+        /** ************************************************************************************************
+        * @struct   PagedFetch
+        *
+        * @brief    A paginated collection being fetched.
+        ***************************************************************************************************/
+        struct PagedFetch
+        {
+            SpotifyApiRequest type;
+            ErrorContext context;
+            QString resourceId; // Id of the album or playlist, empty for the library of the user.
+            int pageSize;
+            int total = -1;      // Number of items, unknown until the first page is received.
+            int nextOffset = 0;  // Offset of the next page to request.
+            int activePages = 0; // Pages requested and not received yet.
+            int failedPages = 0; // Pages whose request failed.
+        };
+
         static const QString API_URL;
         static const QUrl    AUTHORIZATION_URL;
         static const QUrl    TOKEN_ACCESS_URL;
         static const QString REQUEST_URLS[];
+        static const QString REQUEST_NAMES[];
         static const QString REQUEST_SCOPE[];
         static const QString ERROR_CONTEXT_STRINGS[];
+        static const CatalogEndpoint CATALOG_ENDPOINTS[];
 
         public:
-            explicit RequestHandlerPrivate(const QString &clientId, const QString &clientSecret, int replyPort, QObject *parent = nullptr);
+            explicit RequestHandlerPrivate(const QString &clientId, const QString &clientSecret, int replyPort,
+                                           QNetworkAccessManager *networkAccessManager = nullptr, QObject *parent = nullptr);
             ~RequestHandlerPrivate();
 
             void init();
+            void shutdown(QThread *thread);
+            void prewarmConnections();
             void grant();
             void restoreTokens(const QString &accessToken, const QString &refreshToken);
 
             // Data access functions
             void getCurrentUserInformation();
             void getCurrentPlaybackInformation();
+            void subscribePlayback();
+            void unsubscribePlayback();
+            void getTracks(const QStringList &ids);
+            void getAlbums(const QStringList &ids);
+            void getArtists(const QStringList &ids);
+            void getSavedTracks();
+            void getAlbumTracks(const QString &albumId);
+            void getPlaylistTracks(const QString &playlistId);
+            void getAlbumArt(const Album &album, const QSize &size);
 
             // Interaction
             void resumePlayback();
@@ -92,41 +196,191 @@ namespace Qtify
             void previousTrack();
             void seek(int positionMs);
 
+            // Configuration
+            void setServiceUrls(const QUrl &apiUrl, const QUrl &authorizationUrl, const QUrl &tokenUrl);
+            void setRateLimit(double requestsPerSecond, int burst);
+            void setMaxBackgroundRequests(int maxRequests);
+            void setRetryPolicy(SpotifyApiRequest requestType, const RetryPolicy &policy);
+            void setCatalogCache(const QString &path, qint64 maxSize, std::chrono::seconds timeToLive);
+            void setCatalogMemoryCacheSize(int maxSize);
+            void invalidateCatalogObject(const QString &id);
+            void setAlbumArtCacheSize(int maxSize);
+            void setAlbumArtPrefetchSize(const QSize &size);
+            void setMetricsPort(int port);
+
+            // Statistics
+            int getCoalescedRequestCount() const;
+            LatencyStatistics getLatencyStatistics(RequestLane lane) const;
+            RetryStatistics getRetryStatistics(SpotifyApiRequest requestType) const;
+            CacheStatistics getCatalogMemoryCacheStatistics() const;
+            CacheStatistics getAlbumArtCacheStatistics() const;
+            std::vector<EndpointMetrics> getEndpointMetrics() const;
+            TokenRefreshStatistics getTokenRefreshStatistics() const;
+            void collectMetrics(MetricFamilies &families) const;
+
         signals:
             void accessGranted(const QString &accessToken, const QString &refreshToken);
             void accessDenied(const QString &error);
             void tokenRefreshed(const QString &refreshToken);
-            void userDataAvailable(const QSharedPointer<User> &user);
-            void currentPlaybackUpdated(const QSharedPointer<CurrentPlayback> &playback);
+            void userDataAvailable(const User &user);
+            void currentPlaybackUpdated(const CurrentPlayback &playback);
+            void tracksAvailable(const std::vector<Track> &tracks);
+            void albumsAvailable(const std::vector<Album> &albums);
+            void artistsAvailable(const std::vector<Artist> &artists);
+            void savedTracksPageAvailable(int offset, int total, const std::vector<Track> &tracks);
+            void albumTracksPageAvailable(const QString &albumId, int offset, int total, const std::vector<Track> &tracks);
+            void playlistTracksPageAvailable(const QString &playlistId, int offset, int total, const std::vector<Track> &tracks);
+            void savedTracksFetchFinished(bool success);
+            void albumTracksFetchFinished(const QString &albumId, bool success);
+            void playlistTracksFetchFinished(const QString &playlistId, bool success);
+            void albumArtAvailable(const QString &albumId, const QSize &size, const QImage &image);
+            void schedulerStatusChanged(int queuedRequests, qint64 throttledMilliseconds);
 
         private:
             // Utility functions
-            QUrl buildUrl(SpotifyApiRequest requestType, const QVariantMap &parameters = QVariantMap{});
+            QUrl buildUrl(SpotifyApiRequest requestType, const QVariantMap &parameters = QVariantMap{},
+                          const QString &resourceId = QString());
+            void pollPlayback();
+            void schedulePlaybackPoll(const CurrentPlayback *playback);
+            QNetworkRequest buildRequest(const QUrl &url) const;
+            static bool isNotModified(QNetworkReply *reply);
+            void storeETag(QNetworkReply *reply);
+            bool readJsonObject(QNetworkReply *reply, ErrorContext context, QJsonObject &json);
+            bool readPlayback(QNetworkReply *reply, ErrorContext context, CurrentPlayback &playback);
+            void reportInvalidJson(QNetworkReply *reply, ErrorContext context, const QString &message);
             void refreshToken();
-            void get(const QUrl &url, void (RequestHandlerPrivate::*callback)());
-            void put(const QUrl &url, ErrorContext context);
-            void post(const QUrl &url, ErrorContext context);
+            void scheduleTokenRefresh(std::chrono::seconds expiresIn);
+            void get(SpotifyApiRequest requestType, ErrorContext context, ReplyCallback callback,
+                     const QVariantMap &parameters = QVariantMap{}, const QString &resourceId = QString());
+            void put(SpotifyApiRequest requestType, ErrorContext context, const QVariantMap &parameters = QVariantMap{},
+                     ReplyCallback callback = &RequestHandlerPrivate::onPutPostReplyReceived);
+            void post(SpotifyApiRequest requestType, ErrorContext context, const QVariantMap &parameters = QVariantMap{},
+                      ReplyCallback callback = &RequestHandlerPrivate::onPutPostReplyReceived);
+            void skip(int count);
+            void requestCatalog(CatalogType type, const QStringList &ids);
+            void completeCatalogBatches();
+            static QString catalogCacheKey(CatalogType type, const QString &id);
+            bool findCachedCatalogObject(CatalogType type, const QString &id, QVariant &object);
+            void cacheCatalogObject(CatalogType type, const QString &id, const QVariant &object, int size,
+                                    bool persistent);
+            void fetchPages(SpotifyApiRequest requestType, ErrorContext context, int pageSize,
+                            const QString &resourceId = QString());
+            void requestPages(const QUrl &collectionUrl);
+            void enqueue(PendingRequest request);
+            void requeue(PendingRequest request);
+            QList<PendingRequest> *nextQueue();
+            void dispatchRequests();
+            void send(const PendingRequest &request);
+            void throttle(QNetworkReply *reply);
+            void reportSchedulerStatus();
+            void recordLatency(const PendingRequest &request);
+            void recordReplyMetrics(const PendingRequest &request, QNetworkReply *reply);
+            void recordParseTime(const PendingRequest &request, std::chrono::steady_clock::duration parseTime);
+            bool retry(const PendingRequest &request, QNetworkReply *reply);
             void handleRegularError(ErrorContext context, const QByteArray &errorData);
             void handleAuthenticationError(ErrorContext context, const QByteArray &errorData);
             // Internal callbacks.
             void onAccessGranted();
             void onRefreshTokenReplyReceived();
-            void onPutPostReplyReceived();
-            void onGetCurrentUserInformationReplyReceived();
-            void onGetCurrentPlaybackInformationReceived();
+            void onReplyReceived();
+            void onPutPostReplyReceived(QNetworkReply *reply, ErrorContext context);
+            void onSeekReplyReceived(QNetworkReply *reply, ErrorContext context);
+            void onSkipReplyReceived(QNetworkReply *reply, ErrorContext context);
+            void onGetCurrentUserInformationReplyReceived(QNetworkReply *reply, ErrorContext context);
+            void onGetCurrentPlaybackInformationReceived(QNetworkReply *reply, ErrorContext context);
+            void onGetCatalogReplyReceived(QNetworkReply *reply, ErrorContext context);
+            void onGetPageReplyReceived(QNetworkReply *reply, ErrorContext context);
 
-            std::unique_ptr<QNetworkAccessManager> m_networkAccessManager;
+            // Network access manager created by init() when none is shared with other workers.
+            std::unique_ptr<QNetworkAccessManager> m_ownedNetworkAccessManager;
+            QNetworkAccessManager *m_networkAccessManager;
             std::unique_ptr<QOAuth2AuthorizationCodeFlow> m_authManager;
+            // Listens for authorization replies. Only created by grant().
             std::unique_ptr<QOAuthHttpServerReplyHandler> m_replyHandler;
+            // Serves the metrics to Prometheus. Created when a port is set.
+            std::unique_ptr<MetricsExporter> m_metricsExporter;
             QString m_clientId;
             QString m_clientSecret;
             int m_replyPort;
+            // Base URL of the API requests, ending with a slash.
+            QString m_apiUrl;
             QTimer m_tokenRefreshTimer;
-            // Last time a refresh token reply was received (successful or not).
-            std::chrono::time_point<std::chrono::system_clock> m_lastTokenRefresh;
-            // Mapping of a QNetworkReply to an error context to know what context the POST or PUT
-            // reply refers to.
-            QMap<QNetworkReply*, ErrorContext> m_postPutReplyContexts;
+            // A token refresh request is pending. API requests are held until it completes.
+            bool m_tokenRefreshPending = false;
+            // Timer of the playback polling loop shared by all subscribers.
+            QTimer m_playbackPollTimer;
+            // Number of subscribers to the playback polling loop.
+            int m_playbackSubscriberCount = 0;
+            // A poll of the loop is waiting for its reply. Replies to other requests leave the loop as is.
+            bool m_playbackPollPending = false;
+            // Next poll interval used while no device is active (exponential back off).
+            std::chrono::milliseconds m_idlePlaybackPollInterval;
+            // Requests waiting to be sent, in sending order, for each lane.
+            QList<PendingRequest> m_requestQueues[RequestLane_Count];
+            // Number of requests sent and waiting for their reply, for each lane.
+            int m_activeRequestCounts[RequestLane_Count] = {};
+            // Maximum number of background requests waiting for their reply.
+            int m_maxBackgroundRequests;
+            // Timers of the retries waiting for their back off delay, stopped by shutdown().
+            QList<QTimer*> m_retryTimers;
+            // How failed requests of each type are retried.
+            RetryPolicy m_retryPolicies[static_cast<int>(SpotifyApiRequest::SpotifyRequest_Count)];
+            // Requests sent and waiting for their reply.
+            QMap<QNetworkReply*, PendingRequest> m_activeRequests;
+            // URLs of the GET requests queued or in flight. Used to coalesce identical requests.
+            QSet<QUrl> m_pendingGets;
+            // Limits the rate at which requests are sent.
+            TokenBucket m_tokenBucket;
+            // Wakes the dispatcher up when the rate limit or the throttling allows sending again.
+            QTimer m_dispatchTimer;
+            // The API asked not to send anything before that time (HTTP 429 "Retry-After").
+            std::chrono::steady_clock::time_point m_throttledUntil;
+            // Total time spent throttled by the API.
+            std::chrono::milliseconds m_throttledTime{0};
+            // Last status reported with schedulerStatusChanged.
+            int m_reportedQueueDepth = 0;
+            std::chrono::milliseconds m_reportedThrottledTime{0};
+            // ETag of the last reply received for each GET URL, sent back in "If-None-Match".
+            QMap<QUrl, QByteArray> m_eTags;
+            // Last objects received, emitted again when the server answers "304 Not Modified".
+            User m_cachedUser;
+            CurrentPlayback m_cachedPlayback;
+            // Time m_cachedPlayback was received, to estimate its progress when it is emitted again.
+            std::chrono::steady_clock::time_point m_cachedPlaybackTime;
+            // A seek request is pending. Other positions are held in m_nextSeekPosition (-1 if none).
+            bool m_seekPending = false;
+            int m_nextSeekPosition = -1;
+            // A skip request is pending. Other skips are summed in m_queuedSkips (positive for next).
+            bool m_skipPending = false;
+            int m_queuedSkips = 0;
+            // Catalog lookups waiting for some of their objects, in request order.
+            QList<CatalogBatch> m_catalogBatches;
+            // Catalog ids requested and not received yet, for each type.
+            QSet<QString> m_catalogIdsInFlight[Catalog_Count];
+            // Catalog objects received for the pending lookups, for each type. Invalid for unknown ids.
+            QHash<QString, QVariant> m_catalogObjects[Catalog_Count];
+            // Catalog objects recently used, looked up before the persistent cache.
+            CatalogMemoryCache m_catalogMemoryCache;
+            // Catalog objects received in previous runs, looked up before sending requests.
+            CatalogCache m_catalogCache;
+            // Downloads, decodes and caches album artwork.
+            ArtworkLoader m_artworkLoader;
+            // Size of the artwork prefetched when the current track changes. Empty to disable prefetch.
+            QSize m_albumArtPrefetchSize;
+            // Paginated collections being fetched, by URL without query.
+            QMap<QUrl, PagedFetch> m_pagedFetches;
+            // Number of requests merged with another one.
+            std::atomic<int> m_coalescedRequestCount{0};
+            // Latency of each lane. Protected by m_statisticsMutex as it is read from other threads.
+            mutable QMutex m_statisticsMutex;
+            LatencyStatistics m_latencyStatistics[RequestLane_Count];
+            qint64 m_totalLatencies[RequestLane_Count] = {};
+            // Retries of each request type. Protected by m_statisticsMutex.
+            RetryStatistics m_retryStatistics[static_cast<int>(SpotifyApiRequest::SpotifyRequest_Count)];
+            // Activity of each request type for each action. Protected by m_statisticsMutex.
+            QMap<QPair<SpotifyApiRequest, ErrorContext>, EndpointMetrics> m_endpointMetrics;
+            // Outcomes of the token refreshes. Protected by m_statisticsMutex.
+            TokenRefreshStatistics m_tokenRefreshStatistics;
     };
 }
 #endif // REQUESTHANDLERPRIVATE_H
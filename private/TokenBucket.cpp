@@ -0,0 +1,89 @@
+#include "TokenBucket.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace Qtify
+{
+    /** ************************************************************************************************
+    * @brief        Constructor.
+    *
+    * @param[in]    rate: The number of tokens added per second. 0 to disable the limit.
+    * @param[in]    capacity: The maximum number of tokens, i.e. the maximum burst size.
+    ***************************************************************************************************/
+    TokenBucket::TokenBucket(double rate, int capacity) :
+        m_rate(rate),
+        m_capacity(std::max(capacity, 1)),
+        m_tokens(m_capacity),
+        m_lastRefill(Clock::now())
+    {
+
+    }
+
+    /** ************************************************************************************************
+    * @brief        Change the rate and capacity of the bucket. The bucket is filled.
+    ***************************************************************************************************/
+    void TokenBucket::configure(double rate, int capacity)
+    {
+        m_rate       = rate;
+        m_capacity   = std::max(capacity, 1);
+        m_tokens     = m_capacity;
+        m_lastRefill = Clock::now();
+    }
+
+    /** ************************************************************************************************
+    * @brief        Consume a token if one is available.
+    *
+    * @return       True if a token was consumed.
+    ***************************************************************************************************/
+    bool TokenBucket::tryAcquire(Clock::time_point now)
+    {
+        if (m_rate <= 0)
+        {
+            return true;
+        }
+
+        refill(now);
+
+        if (m_tokens < 1)
+        {
+            return false;
+        }
+
+        m_tokens -= 1;
+        return true;
+    }
+
+    /** ************************************************************************************************
+    * @brief        Get the time to wait for the next token.
+    ***************************************************************************************************/
+    std::chrono::milliseconds TokenBucket::timeUntilAvailable(Clock::time_point now)
+    {
+        if (m_rate <= 0)
+        {
+            return std::chrono::milliseconds(0);
+        }
+
+        refill(now);
+
+        if (m_tokens >= 1)
+        {
+            return std::chrono::milliseconds(0);
+        }
+
+        return std::chrono::milliseconds(static_cast<long long>(std::ceil((1 - m_tokens) * 1000 / m_rate)));
+    }
+
+    /** ************************************************************************************************
+    * @brief        Add the tokens earned since the last refill.
+    ***************************************************************************************************/
+    void TokenBucket::refill(Clock::time_point now)
+    {
+        const std::chrono::duration<double> elapsed = now - m_lastRefill;
+        if (elapsed.count() > 0)
+        {
+            m_tokens     = std::min(m_capacity, m_tokens + elapsed.count() * m_rate);
+            m_lastRefill = now;
+        }
+    }
+}
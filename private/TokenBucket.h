@@ -0,0 +1,41 @@
+#ifndef TOKENBUCKET_H
+#define TOKENBUCKET_H
+
+#include <chrono>
+
+namespace Qtify
+{
+    /** ************************************************************************************************
+    * @class    TokenBucket
+    *
+    * @brief    Token bucket rate limiter.
+    *
+    * @details  The bucket holds up to "capacity" tokens and is refilled at "rate" tokens per second.
+    *           Each request consumes one token. A rate of 0 disables the limit.
+    ***************************************************************************************************/
+    class TokenBucket
+    {
+        public:
+            using Clock = std::chrono::steady_clock;
+
+            TokenBucket(double rate, int capacity);
+
+            void configure(double rate, int capacity);
+            bool tryAcquire(Clock::time_point now);
+            std::chrono::milliseconds timeUntilAvailable(Clock::time_point now);
+
+        private:
+            void refill(Clock::time_point now);
+
+            // Tokens added per second.
+            double m_rate;
+            // Maximum number of tokens.
+            double m_capacity;
+            // Tokens currently available.
+            double m_tokens;
+            // Last time tokens were added.
+            Clock::time_point m_lastRefill;
+    };
+}
+
+#endif // TOKENBUCKET_H
@@ -0,0 +1,18 @@
+# Benchmarks of the model parsing, on synthetic payloads shaped like replies of the Spotify Web API.
+# Run with "make check", or run tst_bench with the usual QtTest options (-iterations, -callgrind...).
+# Add DEFINES+=QTIFY_BENCH_NO_MALLOC_HOOK to count only the allocations done with new.
+
+QT += testlib
+
+CONFIG += testcase console
+CONFIG -= app_bundle
+
+TARGET = tst_bench
+
+include(../../Qtify.pri)
+
+SOURCES += \
+    tst_bench.cpp
+
+RESOURCES += \
+    ../fixtures.qrc
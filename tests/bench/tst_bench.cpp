@@ -0,0 +1,477 @@
+#include <QtTest>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include "models/Album.h"
+#include "models/CurrentPlayback.h"
+#include "models/JsonReader.h"
+#include "models/Serialization.h"
+#include "models/Track.h"
+#include "models/User.h"
+
+using namespace Qtify;
+
+namespace
+{
+    /// Number of memory allocations since the start of the process.
+    std::atomic<quint64> allocationCount{0};
+}
+
+/** ****************************************************************************************************
+*   Allocations are counted by replacing the allocation functions of the process. With glibc, malloc()
+* itself is replaced, so the buffers Qt allocates for strings and containers are counted too. This relies
+* on the __libc_* entry points, so it is left out under the sanitizers, which replace malloc() too, and
+* when QTIFY_BENCH_NO_MALLOC_HOOK is defined. Otherwise, only the allocations done with new are counted.
+*******************************************************************************************************/
+#if defined(__has_feature)
+#if __has_feature(address_sanitizer) || __has_feature(memory_sanitizer) || __has_feature(thread_sanitizer)
+#define QTIFY_BENCH_SANITIZER
+#endif
+#endif
+#if defined(__SANITIZE_ADDRESS__) || defined(__SANITIZE_THREAD__)
+#define QTIFY_BENCH_SANITIZER
+#endif
+
+#if defined(__GLIBC__) && !defined(QTIFY_BENCH_SANITIZER) && !defined(QTIFY_BENCH_NO_MALLOC_HOOK)
+extern "C"
+{
+    void *__libc_malloc(size_t size);
+    void *__libc_calloc(size_t count, size_t size);
+    void *__libc_realloc(void *pointer, size_t size);
+
+    void *malloc(size_t size)
+    {
+        allocationCount.fetch_add(1, std::memory_order_relaxed);
+        return __libc_malloc(size);
+    }
+
+    void *calloc(size_t count, size_t size)
+    {
+        allocationCount.fetch_add(1, std::memory_order_relaxed);
+        return __libc_calloc(count, size);
+    }
+
+    void *realloc(void *pointer, size_t size)
+    {
+        allocationCount.fetch_add(1, std::memory_order_relaxed);
+        return __libc_realloc(pointer, size);
+    }
+}
+#else
+void *operator new(std::size_t size)
+{
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    if (void *pointer = std::malloc(size ? size : 1))
+    {
+        return pointer;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void *pointer) noexcept
+{
+    std::free(pointer);
+}
+#endif
+
+/** ****************************************************************************************************
+* @class    ModelBenchmark
+*
+* @brief    Speed and allocations of the parsing of the models.
+*
+* @details  The payloads are synthetic, see fixtures/: they have the keys, nesting and sizes of replies
+*           of the Spotify Web API, with made up ids and names. Besides the time per iteration measured
+*           by QBENCHMARK, each benchmark reports the objects parsed per second and the memory
+*           allocations per object. The lazy members are read, so that the whole object is decoded.
+*           The reply benchmarks parse the body of a reply like the request handler does: the JSON
+*           document is built from the bytes, then the model from the document. The document benchmarks
+*           only build the document, to tell the share of each step. The stream benchmarks build the
+*           same models in a single pass with a JsonReader, as the request handler does for the playback,
+*           to compare with the reply benchmarks. The decode benchmarks build the same models from their
+*           binary serialization.
+*******************************************************************************************************/
+class ModelBenchmark : public QObject
+{
+    Q_OBJECT
+
+    private slots:
+        void parseCurrentPlayback_data();
+        void parseCurrentPlayback();
+        void parseTrack_data();
+        void parseTrack();
+        void parseAlbum_data();
+        void parseAlbum();
+        void parseUser_data();
+        void parseUser();
+        void parseDocument_data();
+        void parseDocument();
+        void parseReply_data();
+        void parseReply();
+        void parseStream_data();
+        void parseStream();
+        void decode_data();
+        void decode();
+
+    private:
+        enum Model
+        {
+            Model_CurrentPlayback,
+            Model_Track,
+            Model_Album,
+            Model_User,
+        };
+
+        static void addReplyRows(bool withUser = true);
+        static int parseModel(Model model, const QJsonObject &json);
+        static int readModel(Model model, const QByteArray &body);
+        static QByteArray serializeModel(Model model, const QJsonObject &json);
+        static int decodeModel(Model model, const QByteArray &data);
+        static QByteArray readFixture(const QString &name);
+        static QJsonObject readJsonFixture(const QString &name);
+        static int readTrack(const Track &track);
+        static int readAlbum(const Album &album);
+
+        template<typename Function>
+        void benchmark(Function function);
+
+        // Results of the parsing, so that it is not optimized away.
+        int m_sink = 0;
+};
+
+/** ****************************************************************************************************
+* @brief        Read a payload.
+*******************************************************************************************************/
+QByteArray ModelBenchmark::readFixture(const QString &name)
+{
+    QFile file(":/fixtures/" + name + ".json");
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        qFatal("Cannot read the fixture %s", qPrintable(name));
+    }
+
+    return file.readAll();
+}
+
+/** ****************************************************************************************************
+* @brief        Read a payload as a JSON object.
+*******************************************************************************************************/
+QJsonObject ModelBenchmark::readJsonFixture(const QString &name)
+{
+    return QJsonDocument::fromJson(readFixture(name)).object();
+}
+
+/** ****************************************************************************************************
+* @brief        Read the members of a track decoded on first access.
+*******************************************************************************************************/
+int ModelBenchmark::readTrack(const Track &track)
+{
+    return static_cast<int>(track.getArtists().size()) + track.getMarkets().count() + readAlbum(track.getAlbum());
+}
+
+/** ****************************************************************************************************
+* @brief        Read the members of an album decoded on first access.
+*******************************************************************************************************/
+int ModelBenchmark::readAlbum(const Album &album)
+{
+    return static_cast<int>(album.getArtists().size() + album.getImages().size()) + album.getMarkets().count();
+}
+
+/** ****************************************************************************************************
+* @brief        Add the rows of the reply and document benchmarks: a body and the model it holds.
+*
+* @param[in]    withUser: Add the user, which is not built with a JsonReader.
+*******************************************************************************************************/
+void ModelBenchmark::addReplyRows(bool withUser)
+{
+    QTest::addColumn<QByteArray>("body");
+    QTest::addColumn<int>("model");
+
+    QTest::newRow("current playback")   << readFixture("current_playback")   << static_cast<int>(Model_CurrentPlayback);
+    QTest::newRow("track all markets")  << readFixture("track_markets")      << static_cast<int>(Model_Track);
+    QTest::newRow("track no markets")   << readFixture("track_no_markets")   << static_cast<int>(Model_Track);
+    QTest::newRow("album many artists") << readFixture("album_many_artists") << static_cast<int>(Model_Album);
+    if (withUser)
+    {
+        QTest::newRow("user")           << readFixture("user")               << static_cast<int>(Model_User);
+    }
+}
+
+/** ****************************************************************************************************
+* @brief        Build a model from its JSON object and read its lazy members.
+*******************************************************************************************************/
+int ModelBenchmark::parseModel(Model model, const QJsonObject &json)
+{
+    switch (model)
+    {
+        case Model_CurrentPlayback:
+        {
+            const CurrentPlayback playback(json);
+            return playback.getProgressMilliseconds() + readTrack(playback.getTrack());
+        }
+        case Model_Track:
+            return readTrack(Track(json));
+        case Model_Album:
+            return readAlbum(Album(json));
+        case Model_User:
+            return User(json).getId().size();
+    }
+
+    return 0;
+}
+
+/** ****************************************************************************************************
+* @brief        Build a model straight from the body of its reply with a JsonReader and read it like
+*               parseModel().
+*******************************************************************************************************/
+int ModelBenchmark::readModel(Model model, const QByteArray &body)
+{
+    JsonReader reader(body);
+
+    switch (model)
+    {
+        case Model_CurrentPlayback:
+        {
+            const CurrentPlayback playback(reader);
+            return reader.finish() ? playback.getProgressMilliseconds() + readTrack(playback.getTrack()) : 0;
+        }
+        case Model_Track:
+        {
+            const Track track(reader);
+            return reader.finish() ? readTrack(track) : 0;
+        }
+        case Model_Album:
+        {
+            const Album album(reader);
+            return reader.finish() ? readAlbum(album) : 0;
+        }
+        case Model_User:
+            break;
+    }
+
+    return 0;
+}
+
+/** ****************************************************************************************************
+* @brief        Build a model from its JSON object and serialize it.
+*******************************************************************************************************/
+QByteArray ModelBenchmark::serializeModel(Model model, const QJsonObject &json)
+{
+    switch (model)
+    {
+        case Model_CurrentPlayback:
+            return Serialization::serialize(CurrentPlayback(json));
+        case Model_Track:
+            return Serialization::serialize(Track(json));
+        case Model_Album:
+            return Serialization::serialize(Album(json));
+        case Model_User:
+            return Serialization::serialize(User(json));
+    }
+
+    return QByteArray();
+}
+
+/** ****************************************************************************************************
+* @brief        Build a model from its serialization and read it like parseModel().
+*******************************************************************************************************/
+int ModelBenchmark::decodeModel(Model model, const QByteArray &data)
+{
+    switch (model)
+    {
+        case Model_CurrentPlayback:
+        {
+            const CurrentPlayback playback = Serialization::deserialize<CurrentPlayback>(data);
+            return playback.getProgressMilliseconds() + readTrack(playback.getTrack());
+        }
+        case Model_Track:
+            return readTrack(Serialization::deserialize<Track>(data));
+        case Model_Album:
+            return readAlbum(Serialization::deserialize<Album>(data));
+        case Model_User:
+            return Serialization::deserialize<User>(data).getId().size();
+    }
+
+    return 0;
+}
+
+/** ****************************************************************************************************
+* @brief        Run a benchmark building one object per iteration, and report the objects parsed per
+*               second and the allocations per object.
+*******************************************************************************************************/
+template<typename Function>
+void ModelBenchmark::benchmark(Function function)
+{
+    quint64 objects = 0;
+    const quint64 allocations = allocationCount.load();
+    QElapsedTimer timer;
+    timer.start();
+
+    QBENCHMARK
+    {
+        m_sink += function();
+        ++objects;
+    }
+
+    const qint64 elapsed = timer.nsecsElapsed();
+    const quint64 allocated = allocationCount.load() - allocations;
+
+    if (objects > 0 && elapsed > 0)
+    {
+        qInfo("%.0f objects/s, %.1f allocations/object",
+              objects * 1e9 / elapsed, static_cast<double>(allocated) / objects);
+    }
+}
+
+void ModelBenchmark::parseCurrentPlayback_data()
+{
+    QTest::addColumn<QJsonObject>("json");
+
+    QTest::newRow("playing track") << readJsonFixture("current_playback");
+}
+
+void ModelBenchmark::parseCurrentPlayback()
+{
+    QFETCH(QJsonObject, json);
+
+    benchmark([&json]()
+    {
+        return parseModel(Model_CurrentPlayback, json);
+    });
+}
+
+void ModelBenchmark::parseTrack_data()
+{
+    QTest::addColumn<QJsonObject>("json");
+
+    QTest::newRow("all markets")  << readJsonFixture("track_markets");
+    QTest::newRow("no markets")   << readJsonFixture("track_no_markets");
+    QTest::newRow("many artists") << readJsonFixture("track_many_artists");
+}
+
+void ModelBenchmark::parseTrack()
+{
+    QFETCH(QJsonObject, json);
+
+    benchmark([&json]()
+    {
+        return parseModel(Model_Track, json);
+    });
+}
+
+void ModelBenchmark::parseAlbum_data()
+{
+    QTest::addColumn<QJsonObject>("json");
+
+    QTest::newRow("one artist")   << readJsonFixture("album");
+    QTest::newRow("many artists") << readJsonFixture("album_many_artists");
+}
+
+void ModelBenchmark::parseAlbum()
+{
+    QFETCH(QJsonObject, json);
+
+    benchmark([&json]()
+    {
+        return parseModel(Model_Album, json);
+    });
+}
+
+void ModelBenchmark::parseUser_data()
+{
+    QTest::addColumn<QJsonObject>("json");
+
+    QTest::newRow("premium") << readJsonFixture("user");
+}
+
+void ModelBenchmark::parseUser()
+{
+    QFETCH(QJsonObject, json);
+
+    benchmark([&json]()
+    {
+        return parseModel(Model_User, json);
+    });
+}
+
+void ModelBenchmark::parseDocument_data()
+{
+    addReplyRows();
+}
+
+void ModelBenchmark::parseDocument()
+{
+    QFETCH(QByteArray, body);
+
+    benchmark([&body]()
+    {
+        return QJsonDocument::fromJson(body).object().size();
+    });
+}
+
+void ModelBenchmark::parseReply_data()
+{
+    addReplyRows();
+}
+
+void ModelBenchmark::parseReply()
+{
+    QFETCH(QByteArray, body);
+    QFETCH(int, model);
+
+    benchmark([&body, model]()
+    {
+        QJsonParseError error;
+        const QJsonDocument document = QJsonDocument::fromJson(body, &error);
+        return error.error == QJsonParseError::NoError
+               ? parseModel(static_cast<Model>(model), document.object())
+               : 0;
+    });
+}
+
+void ModelBenchmark::parseStream_data()
+{
+    addReplyRows(false);
+}
+
+void ModelBenchmark::parseStream()
+{
+    QFETCH(QByteArray, body);
+    QFETCH(int, model);
+
+    // Both paths must build the same model for the comparison to be fair.
+    QCOMPARE(readModel(static_cast<Model>(model), body),
+             parseModel(static_cast<Model>(model), QJsonDocument::fromJson(body).object()));
+
+    benchmark([&body, model]()
+    {
+        return readModel(static_cast<Model>(model), body);
+    });
+}
+
+void ModelBenchmark::decode_data()
+{
+    addReplyRows();
+}
+
+void ModelBenchmark::decode()
+{
+    QFETCH(QByteArray, body);
+    QFETCH(int, model);
+
+    const QByteArray data = serializeModel(static_cast<Model>(model), QJsonDocument::fromJson(body).object());
+
+    benchmark([&data, model]()
+    {
+        return decodeModel(static_cast<Model>(model), data);
+    });
+}
+
+QTEST_GUILESS_MAIN(ModelBenchmark)
+#include "tst_bench.moc"
@@ -0,0 +1,29 @@
+# Benchmark of the time to the first reply over TLS, with HTTP/1.1 and HTTP/2, against the mock server.
+# Run with "make check", or run tst_connection with the usual QtTest options.
+
+QT += testlib network
+
+CONFIG += testcase console
+CONFIG -= app_bundle
+
+TARGET = tst_connection
+
+include(../../Qtify.pri)
+
+MOCKSERVER = ../../tools/mockserver
+
+INCLUDEPATH += $$MOCKSERVER
+
+HEADERS += \
+    $$MOCKSERVER/Hpack.h \
+    $$MOCKSERVER/MockServer.h \
+    $$MOCKSERVER/TlsServer.h
+
+SOURCES += \
+    $$MOCKSERVER/Hpack.cpp \
+    $$MOCKSERVER/MockServer.cpp \
+    $$MOCKSERVER/TlsServer.cpp \
+    tst_connection.cpp
+
+RESOURCES += \
+    $$MOCKSERVER/mockserver.qrc
@@ -0,0 +1,139 @@
+#include <QtTest>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QHostAddress>
+#include <QSslCertificate>
+#include <QSslConfiguration>
+#include <QSslSocket>
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+#include "MockServer.h"
+#include "RequestHandler.h"
+
+using namespace Qtify;
+
+/// Delay before each TLS handshake of the mock server, standing for the round trips to a remote host.
+const std::chrono::milliseconds BENCH_HANDSHAKE_LATENCY{60};
+/// Delay of every reply of the mock server, standing for a round trip to a remote host.
+const std::chrono::milliseconds BENCH_REPLY_LATENCY{20};
+/// Time left to the worker thread to start and to the prewarmed connections to be encrypted.
+const int BENCH_SETTLE_TIME_MS{500};
+/// Longest wait for the first reply.
+const int BENCH_TIMEOUT_MS{5000};
+/// Number of measures of each row, of which the median is reported.
+const int BENCH_RUN_COUNT{7};
+
+/** ****************************************************************************************************
+* @class    ConnectionBenchmark
+*
+* @brief    Time from the first call of a new RequestHandler to its first reply, over TLS.
+*
+* @details  The RequestHandler restores its tokens, which refreshes them, then gets the current playback
+*           from an in-process MockServer serving HTTPS with its test certificate. The server offers
+*           HTTP/2 or only HTTP/1.1 with ALPN, and delays its handshakes and replies so that the
+*           connection setup weighs as it would over a real network. Each protocol is measured with and
+*           without prewarmConnections() called beforehand, on a new RequestHandler and so on new
+*           connections every run. The median wall time of the runs is reported.
+*******************************************************************************************************/
+class ConnectionBenchmark : public QObject
+{
+    Q_OBJECT
+
+    private slots:
+        void initTestCase();
+        void firstReply_data();
+        void firstReply();
+};
+
+/** ****************************************************************************************************
+* @brief        Trust the test certificate of the mock server in the default SSL configuration, which the
+*               RequestHandler uses.
+*******************************************************************************************************/
+void ConnectionBenchmark::initTestCase()
+{
+    if (!QSslSocket::supportsSsl())
+    {
+        QSKIP("SSL is not supported");
+    }
+
+    QFile certificateFile(":/certs/localhost.crt");
+    QVERIFY(certificateFile.open(QIODevice::ReadOnly));
+
+    const QSslCertificate certificate(&certificateFile, QSsl::Pem);
+    QVERIFY(!certificate.isNull());
+
+    QSslConfiguration configuration = QSslConfiguration::defaultConfiguration();
+    configuration.setCaCertificates(configuration.caCertificates() << certificate);
+    QSslConfiguration::setDefaultConfiguration(configuration);
+}
+
+void ConnectionBenchmark::firstReply_data()
+{
+    QTest::addColumn<bool>("http2");
+    QTest::addColumn<bool>("prewarm");
+
+    QTest::newRow("http/1.1")           << false << false;
+    QTest::newRow("http/1.1 prewarmed") << false << true;
+    QTest::newRow("http/2")             << true  << false;
+    QTest::newRow("http/2 prewarmed")   << true  << true;
+}
+
+void ConnectionBenchmark::firstReply()
+{
+    QFETCH(bool, http2);
+    QFETCH(bool, prewarm);
+
+    MockServer::Options options;
+    options.latency          = BENCH_REPLY_LATENCY;
+    options.tls              = true;
+    options.http2            = http2;
+    options.handshakeLatency = BENCH_HANDSHAKE_LATENCY;
+
+    MockServer server(options);
+    QVERIFY(server.listen(QHostAddress::LocalHost, 0));
+    QSignalSpy encryptedSpy(&server, &MockServer::connectionEncrypted);
+
+    // The test certificate is issued for 127.0.0.1 too, which avoids resolving localhost to ::1.
+    const QString baseUrl = QString("https://127.0.0.1:%1/").arg(server.getPort());
+
+    std::vector<qint64> durations;
+    for (int run = 0; run < BENCH_RUN_COUNT; ++run)
+    {
+        RequestHandler handler("mock-client-id", "mock-client-secret", 0);
+        QSignalSpy playbackSpy(&handler, &RequestHandler::currentPlaybackUpdated);
+
+        handler.setServiceUrls(QUrl(baseUrl + "v1/"), QUrl(baseUrl + "authorize"), QUrl(baseUrl + "api/token"));
+        if (prewarm)
+        {
+            handler.prewarmConnections();
+        }
+        QTest::qWait(BENCH_SETTLE_TIME_MS);
+
+        QElapsedTimer timer;
+        timer.start();
+
+        handler.restoreTokens(QString(), "mock-refresh-token");
+        handler.getCurrentPlayback();
+        QVERIFY(playbackSpy.wait(BENCH_TIMEOUT_MS));
+
+        durations.push_back(timer.elapsed());
+    }
+
+    // The protocol offered by the server is the one used.
+    QVERIFY(!encryptedSpy.isEmpty());
+    for (const QList<QVariant> &arguments : encryptedSpy)
+    {
+        QCOMPARE(arguments.first().toByteArray(),
+                 QByteArray(http2 ? QSslConfiguration::ALPNProtocolHTTP2 : QSslConfiguration::NextProtocolHttp1_1));
+    }
+
+    const auto median = durations.begin() + BENCH_RUN_COUNT / 2;
+    std::nth_element(durations.begin(), median, durations.end());
+    QTest::setBenchmarkResult(static_cast<qreal>(*median), QTest::WalltimeMilliseconds);
+}
+
+QTEST_GUILESS_MAIN(ConnectionBenchmark)
+#include "tst_connection.moc"
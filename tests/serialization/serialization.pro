@@ -0,0 +1,17 @@
+# Tests of the binary serialization of the models.
+# Run with "make check", or run tst_serialization with the usual QtTest options.
+
+QT += testlib
+
+CONFIG += testcase console
+CONFIG -= app_bundle
+
+TARGET = tst_serialization
+
+include(../../Qtify.pri)
+
+SOURCES += \
+    tst_serialization.cpp
+
+RESOURCES += \
+    ../fixtures.qrc
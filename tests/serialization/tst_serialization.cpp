@@ -0,0 +1,414 @@
+#include <QtTest>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+#include "models/Album.h"
+#include "models/Artist.h"
+#include "models/Context.h"
+#include "models/CurrentPlayback.h"
+#include "models/Device.h"
+#include "models/Image.h"
+#include "models/JsonReader.h"
+#include "models/Serialization.h"
+#include "models/Track.h"
+#include "models/User.h"
+
+using namespace Qtify;
+
+/** ****************************************************************************************************
+*   Compare two models with one of the compare functions, and leave the calling test function if they
+* differ. QCOMPARE only returns from the function it is used in.
+*******************************************************************************************************/
+#define COMPARE_MODELS(function, actual, expected) \
+    do \
+    { \
+        function(actual, expected); \
+        if (QTest::currentTestFailed()) \
+        { \
+            return; \
+        } \
+    } while (false)
+
+/** ****************************************************************************************************
+*   Serialize a model and build it again from the data, leaving the calling test function if the data
+* is rejected.
+*******************************************************************************************************/
+#define ROUND_TRIP(type, copy, model) \
+    bool copy##Ok = false; \
+    const type copy = Serialization::deserialize<type>(Serialization::serialize(model), &copy##Ok); \
+    QVERIFY2(copy##Ok, "The serialized data is rejected")
+
+/** ****************************************************************************************************
+* @class    SerializationTest
+*
+* @brief    Tests of the binary serialization of the models, and of their building with a JsonReader.
+*
+* @details  Each model is built from a payload shaped like a reply of the Spotify Web API, see
+*           fixtures/, serialized then deserialized, and all its members are compared with the original.
+*           Truncated data, data of another format version and enumeration values out of range must be
+*           rejected.
+*           The models built with a JsonReader must be equal to the ones built from a JSON document, and
+*           invalid JSON must be reported by the reader.
+*******************************************************************************************************/
+class SerializationTest : public QObject
+{
+    Q_OBJECT
+
+    private slots:
+        void roundTripImage();
+        void roundTripArtist();
+        void roundTripDevice();
+        void roundTripContext();
+        void roundTripUser();
+        void roundTripAlbum_data();
+        void roundTripAlbum();
+        void roundTripTrack_data();
+        void roundTripTrack();
+        void roundTripCurrentPlayback();
+        void rejectInvalidData();
+        void rejectEnumOutOfRange();
+        void readTrack_data();
+        void readTrack();
+        void readAlbum();
+        void readCurrentPlayback();
+        void readUnknownKeys();
+        void rejectInvalidJson_data();
+        void rejectInvalidJson();
+
+    private:
+        static void compareImage(const Image &actual, const Image &expected);
+        static void compareArtist(const Artist &actual, const Artist &expected);
+        static void compareDevice(const Device &actual, const Device &expected);
+        static void compareContext(const Context &actual, const Context &expected);
+        static void compareUser(const User &actual, const User &expected);
+        static void compareAlbum(const Album &actual, const Album &expected);
+        static void compareTrack(const Track &actual, const Track &expected);
+        static QJsonObject readJsonFixture(const QString &name);
+};
+
+/** ****************************************************************************************************
+* @brief        Read a payload as a JSON object.
+*******************************************************************************************************/
+QJsonObject SerializationTest::readJsonFixture(const QString &name)
+{
+    QFile file(":/fixtures/" + name + ".json");
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        qFatal("Cannot read the fixture %s", qPrintable(name));
+    }
+
+    return QJsonDocument::fromJson(file.readAll()).object();
+}
+
+void SerializationTest::compareImage(const Image &actual, const Image &expected)
+{
+    QCOMPARE(actual.getHeight(), expected.getHeight());
+    QCOMPARE(actual.getUrl(),    expected.getUrl());
+    QCOMPARE(actual.getWidth(),  expected.getWidth());
+}
+
+void SerializationTest::compareArtist(const Artist &actual, const Artist &expected)
+{
+    QCOMPARE(actual.getExternalUrl().getKey(),   expected.getExternalUrl().getKey());
+    QCOMPARE(actual.getExternalUrl().getValue(), expected.getExternalUrl().getValue());
+    QCOMPARE(actual.getApiEndPoint(),            expected.getApiEndPoint());
+    QCOMPARE(actual.getId(),                     expected.getId());
+    QCOMPARE(actual.getName(),                   expected.getName());
+    QCOMPARE(actual.getUri(),                    expected.getUri());
+}
+
+void SerializationTest::compareDevice(const Device &actual, const Device &expected)
+{
+    QCOMPARE(actual.getId(),             expected.getId());
+    QCOMPARE(actual.isActive(),          expected.isActive());
+    QCOMPARE(actual.isPrivateSession(),  expected.isPrivateSession());
+    QCOMPARE(actual.isRestricted(),      expected.isRestricted());
+    QCOMPARE(actual.getName(),           expected.getName());
+    QCOMPARE(actual.getType(),           expected.getType());
+    QCOMPARE(actual.getVolumePercent(),  expected.getVolumePercent());
+}
+
+void SerializationTest::compareContext(const Context &actual, const Context &expected)
+{
+    QCOMPARE(actual.getUri(),                    expected.getUri());
+    QCOMPARE(actual.getHref(),                   expected.getHref());
+    QCOMPARE(actual.getExternalUrl().getValue(), expected.getExternalUrl().getValue());
+    QCOMPARE(static_cast<int>(actual.getType()), static_cast<int>(expected.getType()));
+}
+
+void SerializationTest::compareUser(const User &actual, const User &expected)
+{
+    QCOMPARE(actual.getCountry(),     expected.getCountry());
+    QCOMPARE(actual.getDisplayName(), expected.getDisplayName());
+    QCOMPARE(actual.getEmail(),       expected.getEmail());
+    QCOMPARE(actual.getApiEndPoint(), expected.getApiEndPoint());
+    QCOMPARE(actual.getId(),          expected.getId());
+    QCOMPARE(actual.getProduct(),     expected.getProduct());
+    QCOMPARE(actual.getType(),        expected.getType());
+    QCOMPARE(actual.getSpotifyUri(),  expected.getSpotifyUri());
+}
+
+void SerializationTest::compareAlbum(const Album &actual, const Album &expected)
+{
+    QCOMPARE(static_cast<int>(actual.getAlbumGroup()), static_cast<int>(expected.getAlbumGroup()));
+    QCOMPARE(static_cast<int>(actual.getAlbumType()),  static_cast<int>(expected.getAlbumType()));
+    QCOMPARE(actual.getArtists().size(),               expected.getArtists().size());
+    for (size_t i = 0; i < actual.getArtists().size(); ++i)
+    {
+        COMPARE_MODELS(compareArtist, actual.getArtists()[i], expected.getArtists()[i]);
+    }
+    QCOMPARE(actual.getAvailableMarkets(),             expected.getAvailableMarkets());
+    QCOMPARE(actual.getExternalUrl().getValue(),       expected.getExternalUrl().getValue());
+    QCOMPARE(actual.getApiEndPoint(),                  expected.getApiEndPoint());
+    QCOMPARE(actual.getId(),                           expected.getId());
+    QCOMPARE(actual.getImages().size(),                expected.getImages().size());
+    for (size_t i = 0; i < actual.getImages().size(); ++i)
+    {
+        COMPARE_MODELS(compareImage, actual.getImages()[i], expected.getImages()[i]);
+    }
+    QCOMPARE(actual.getName(),                         expected.getName());
+    QCOMPARE(actual.getReleaseDate(),                  expected.getReleaseDate());
+    QCOMPARE(static_cast<int>(actual.getReleaseDatePrecision()),
+             static_cast<int>(expected.getReleaseDatePrecision()));
+    QCOMPARE(actual.getUri(),                          expected.getUri());
+}
+
+void SerializationTest::compareTrack(const Track &actual, const Track &expected)
+{
+    COMPARE_MODELS(compareAlbum, actual.getAlbum(), expected.getAlbum());
+    QCOMPARE(actual.getArtists().size(),                 expected.getArtists().size());
+    for (size_t i = 0; i < actual.getArtists().size(); ++i)
+    {
+        COMPARE_MODELS(compareArtist, actual.getArtists()[i], expected.getArtists()[i]);
+    }
+    QCOMPARE(actual.getAvailableMarkets(),               expected.getAvailableMarkets());
+    QCOMPARE(actual.getDiscNumber(),                     expected.getDiscNumber());
+    QCOMPARE(actual.getDurationMilliseconds(),           expected.getDurationMilliseconds());
+    QCOMPARE(actual.hasExplicitLyrics(),                 expected.hasExplicitLyrics());
+    QCOMPARE(actual.getExternalId().getKey(),            expected.getExternalId().getKey());
+    QCOMPARE(actual.getExternalId().getValue(),          expected.getExternalId().getValue());
+    QCOMPARE(actual.getExternalUrl().getValue(),         expected.getExternalUrl().getValue());
+    QCOMPARE(actual.getApiEndPoint(),                    expected.getApiEndPoint());
+    QCOMPARE(actual.getId(),                             expected.getId());
+    QCOMPARE(actual.isPlayable(),                        expected.isPlayable());
+    QCOMPARE(actual.getName(),                           expected.getName());
+    QCOMPARE(actual.getPopularity(),                     expected.getPopularity());
+    QCOMPARE(actual.getPreviewUrl(),                     expected.getPreviewUrl());
+    QCOMPARE(actual.getTrackNumber(),                    expected.getTrackNumber());
+    QCOMPARE(actual.getUri(),                            expected.getUri());
+    QCOMPARE(actual.isLocalFile(),                       expected.isLocalFile());
+}
+
+void SerializationTest::roundTripImage()
+{
+    const Image image(readJsonFixture("album")["images"].toArray().first().toObject());
+    ROUND_TRIP(Image, copy, image);
+    compareImage(copy, image);
+}
+
+void SerializationTest::roundTripArtist()
+{
+    const Artist artist(readJsonFixture("album")["artists"].toArray().first().toObject());
+    ROUND_TRIP(Artist, copy, artist);
+    compareArtist(copy, artist);
+}
+
+void SerializationTest::roundTripDevice()
+{
+    const Device device(readJsonFixture("current_playback")["device"].toObject());
+    ROUND_TRIP(Device, copy, device);
+    compareDevice(copy, device);
+}
+
+void SerializationTest::roundTripContext()
+{
+    const Context context(readJsonFixture("current_playback")["context"].toObject());
+    ROUND_TRIP(Context, copy, context);
+    compareContext(copy, context);
+}
+
+void SerializationTest::roundTripUser()
+{
+    const User user(readJsonFixture("user"));
+    ROUND_TRIP(User, copy, user);
+    compareUser(copy, user);
+}
+
+void SerializationTest::roundTripAlbum_data()
+{
+    QTest::addColumn<QJsonObject>("json");
+
+    QTest::newRow("one artist")   << readJsonFixture("album");
+    QTest::newRow("many artists") << readJsonFixture("album_many_artists");
+}
+
+void SerializationTest::roundTripAlbum()
+{
+    QFETCH(QJsonObject, json);
+
+    const Album album(json);
+    ROUND_TRIP(Album, copy, album);
+    compareAlbum(copy, album);
+}
+
+void SerializationTest::roundTripTrack_data()
+{
+    QTest::addColumn<QJsonObject>("json");
+
+    QTest::newRow("all markets")  << readJsonFixture("track_markets");
+    QTest::newRow("no markets")   << readJsonFixture("track_no_markets");
+    QTest::newRow("many artists") << readJsonFixture("track_many_artists");
+}
+
+void SerializationTest::roundTripTrack()
+{
+    QFETCH(QJsonObject, json);
+
+    const Track track(json);
+    ROUND_TRIP(Track, copy, track);
+    compareTrack(copy, track);
+}
+
+void SerializationTest::roundTripCurrentPlayback()
+{
+    const CurrentPlayback playback(readJsonFixture("current_playback"));
+    ROUND_TRIP(CurrentPlayback, copy, playback);
+
+    COMPARE_MODELS(compareDevice, copy.getDevice(), playback.getDevice());
+    QCOMPARE(static_cast<int>(copy.getRepeatState()), static_cast<int>(playback.getRepeatState()));
+    QCOMPARE(copy.isShuffleEnabled(),                 playback.isShuffleEnabled());
+    COMPARE_MODELS(compareContext, copy.getContext(), playback.getContext());
+    QCOMPARE(copy.getDataTimeStamp(),                 playback.getDataTimeStamp());
+    QCOMPARE(copy.getProgressMilliseconds(),          playback.getProgressMilliseconds());
+    QCOMPARE(copy.isPlaying(),                        playback.isPlaying());
+    COMPARE_MODELS(compareTrack, copy.getTrack(), playback.getTrack());
+    QCOMPARE(static_cast<int>(copy.getCurrentlyPlayingType()),
+             static_cast<int>(playback.getCurrentlyPlayingType()));
+}
+
+void SerializationTest::rejectInvalidData()
+{
+    const QByteArray data = Serialization::serialize(Track(readJsonFixture("track_markets")));
+    bool ok = true;
+
+    // Truncated data.
+    const Track truncated = Serialization::deserialize<Track>(data.left(data.size() / 2), &ok);
+    QVERIFY(!ok);
+    QVERIFY(truncated.getId().isEmpty());
+
+    // Another format version.
+    QByteArray otherVersion = data;
+    otherVersion[1] = static_cast<char>(Serialization::SERIALIZATION_VERSION + 1);
+    ok = true;
+    Serialization::deserialize<Track>(otherVersion, &ok);
+    QVERIFY(!ok);
+
+    // Empty data.
+    ok = true;
+    Serialization::deserialize<Track>(QByteArray(), &ok);
+    QVERIFY(!ok);
+}
+
+void SerializationTest::rejectEnumOutOfRange()
+{
+    const Context context(readJsonFixture("current_playback")["context"].toObject());
+    QByteArray data = Serialization::serialize(context);
+    bool ok = false;
+
+    Serialization::deserialize<Context>(data, &ok);
+    QVERIFY(ok);
+
+    // The type is the last field, a big endian qint32.
+    data[data.size() - 1] = static_cast<char>(99);
+    ok = true;
+    const Context invalid = Serialization::deserialize<Context>(data, &ok);
+    QVERIFY(!ok);
+    QVERIFY(invalid.getUri().isEmpty());
+}
+
+void SerializationTest::readTrack_data()
+{
+    roundTripTrack_data();
+}
+
+void SerializationTest::readTrack()
+{
+    QFETCH(QJsonObject, json);
+
+    JsonReader reader(QJsonDocument(json).toJson());
+    const Track track(reader);
+    QVERIFY(reader.finish());
+    compareTrack(track, Track(json));
+}
+
+void SerializationTest::readAlbum()
+{
+    const QJsonObject json = readJsonFixture("album_many_artists");
+
+    JsonReader reader(QJsonDocument(json).toJson());
+    const Album album(reader);
+    QVERIFY(reader.finish());
+    compareAlbum(album, Album(json));
+}
+
+void SerializationTest::readCurrentPlayback()
+{
+    const QJsonObject json = readJsonFixture("current_playback");
+
+    JsonReader reader(QJsonDocument(json).toJson());
+    const CurrentPlayback playback(reader);
+    QVERIFY(reader.finish());
+
+    const CurrentPlayback expected(json);
+    COMPARE_MODELS(compareDevice, playback.getDevice(), expected.getDevice());
+    QCOMPARE(static_cast<int>(playback.getRepeatState()), static_cast<int>(expected.getRepeatState()));
+    QCOMPARE(playback.isShuffleEnabled(),                 expected.isShuffleEnabled());
+    COMPARE_MODELS(compareContext, playback.getContext(), expected.getContext());
+    QCOMPARE(playback.getDataTimeStamp(),                 expected.getDataTimeStamp());
+    QCOMPARE(playback.getProgressMilliseconds(),          expected.getProgressMilliseconds());
+    QCOMPARE(playback.isPlaying(),                        expected.isPlaying());
+    COMPARE_MODELS(compareTrack, playback.getTrack(), expected.getTrack());
+    QCOMPARE(static_cast<int>(playback.getCurrentlyPlayingType()),
+             static_cast<int>(expected.getCurrentlyPlayingType()));
+}
+
+void SerializationTest::readUnknownKeys()
+{
+    JsonReader reader("{\"unknown\": {\"nested\": [1, 2.5e3, \"\\u00e9\", null, true]},"
+                      " \"name\": \"Caf\\u00e9\", \"type\": 3, \"id\": \"artist\"}");
+    const Artist artist(reader);
+
+    QVERIFY(reader.finish());
+    QCOMPARE(artist.getName(), QString("Caf") + QChar(0xE9));
+    QCOMPARE(artist.getId(),   QStringLiteral("artist"));
+}
+
+void SerializationTest::rejectInvalidJson_data()
+{
+    QTest::addColumn<QByteArray>("body");
+
+    QTest::newRow("truncated")       << QByteArray("{\"id\": \"track\", \"name\": \"Na");
+    QTest::newRow("missing comma")   << QByteArray("{\"id\": \"track\" \"name\": \"Name\"}");
+    QTest::newRow("trailing comma")  << QByteArray("{\"id\": \"track\",}");
+    QTest::newRow("trailing data")   << QByteArray("{\"id\": \"track\"} {}");
+    QTest::newRow("invalid number")  << QByteArray("{\"disc_number\": 01}");
+    QTest::newRow("invalid literal") << QByteArray("{\"explicit\": tru}");
+    QTest::newRow("invalid escape")  << QByteArray("{\"name\": \"\\x\"}");
+}
+
+void SerializationTest::rejectInvalidJson()
+{
+    QFETCH(QByteArray, body);
+
+    JsonReader reader(body);
+    const Track track(reader);
+
+    QVERIFY(!reader.finish());
+    QVERIFY(reader.hasError());
+    QVERIFY(reader.errorOffset() >= 0);
+}
+
+QTEST_GUILESS_MAIN(SerializationTest)
+#include "tst_serialization.moc"
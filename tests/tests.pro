@@ -0,0 +1,8 @@
+# All the test targets, run them with "make check".
+
+TEMPLATE = subdirs
+
+SUBDIRS += \
+    bench \
+    connection \
+    serialization
@@ -0,0 +1,483 @@
+#include "Hpack.h"
+
+#include <vector>
+
+namespace Qtify
+{
+    /// Size of the dynamic table allowed by the default SETTINGS_HEADER_TABLE_SIZE of HTTP/2.
+    const int HPACK_MAX_TABLE_SIZE{4096};
+    /// Size of a dynamic table entry besides its name and value.
+    const int HPACK_ENTRY_OVERHEAD{32};
+    /// Symbol of the end of string, which must not appear in a Huffman coded string.
+    const int HPACK_HUFFMAN_EOS{256};
+
+    /// Huffman codes of the 256 octets and of the end of string, RFC 7541 appendix B.
+    const quint32 HPACK_HUFFMAN_CODES[]
+    {
+        0x1ff8, 0x7fffd8, 0xfffffe2, 0xfffffe3, 0xfffffe4, 0xfffffe5, 0xfffffe6, 0xfffffe7,
+        0xfffffe8, 0xffffea, 0x3ffffffc, 0xfffffe9, 0xfffffea, 0x3ffffffd, 0xfffffeb, 0xfffffec,
+        0xfffffed, 0xfffffee, 0xfffffef, 0xffffff0, 0xffffff1, 0xffffff2, 0x3ffffffe, 0xffffff3,
+        0xffffff4, 0xffffff5, 0xffffff6, 0xffffff7, 0xffffff8, 0xffffff9, 0xffffffa, 0xffffffb,
+        0x14, 0x3f8, 0x3f9, 0xffa, 0x1ff9, 0x15, 0xf8, 0x7fa,
+        0x3fa, 0x3fb, 0xf9, 0x7fb, 0xfa, 0x16, 0x17, 0x18,
+        0x0, 0x1, 0x2, 0x19, 0x1a, 0x1b, 0x1c, 0x1d,
+        0x1e, 0x1f, 0x5c, 0xfb, 0x7ffc, 0x20, 0xffb, 0x3fc,
+        0x1ffa, 0x21, 0x5d, 0x5e, 0x5f, 0x60, 0x61, 0x62,
+        0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69, 0x6a,
+        0x6b, 0x6c, 0x6d, 0x6e, 0x6f, 0x70, 0x71, 0x72,
+        0xfc, 0x73, 0xfd, 0x1ffb, 0x7fff0, 0x1ffc, 0x3ffc, 0x22,
+        0x7ffd, 0x3, 0x23, 0x4, 0x24, 0x5, 0x25, 0x26,
+        0x27, 0x6, 0x74, 0x75, 0x28, 0x29, 0x2a, 0x7,
+        0x2b, 0x76, 0x2c, 0x8, 0x9, 0x2d, 0x77, 0x78,
+        0x79, 0x7a, 0x7b, 0x7ffe, 0x7fc, 0x3ffd, 0x1ffd, 0xffffffc,
+        0xfffe6, 0x3fffd2, 0xfffe7, 0xfffe8, 0x3fffd3, 0x3fffd4, 0x3fffd5, 0x7fffd9,
+        0x3fffd6, 0x7fffda, 0x7fffdb, 0x7fffdc, 0x7fffdd, 0x7fffde, 0xffffeb, 0x7fffdf,
+        0xffffec, 0xffffed, 0x3fffd7, 0x7fffe0, 0xffffee, 0x7fffe1, 0x7fffe2, 0x7fffe3,
+        0x7fffe4, 0x1fffdc, 0x3fffd8, 0x7fffe5, 0x3fffd9, 0x7fffe6, 0x7fffe7, 0xffffef,
+        0x3fffda, 0x1fffdd, 0xfffe9, 0x3fffdb, 0x3fffdc, 0x7fffe8, 0x7fffe9, 0x1fffde,
+        0x7fffea, 0x3fffdd, 0x3fffde, 0xfffff0, 0x1fffdf, 0x3fffdf, 0x7fffeb, 0x7fffec,
+        0x1fffe0, 0x1fffe1, 0x3fffe0, 0x1fffe2, 0x7fffed, 0x3fffe1, 0x7fffee, 0x7fffef,
+        0xfffea, 0x3fffe2, 0x3fffe3, 0x3fffe4, 0x7ffff0, 0x3fffe5, 0x3fffe6, 0x7ffff1,
+        0x3ffffe0, 0x3ffffe1, 0xfffeb, 0x7fff1, 0x3fffe7, 0x7ffff2, 0x3fffe8, 0x1ffffec,
+        0x3ffffe2, 0x3ffffe3, 0x3ffffe4, 0x7ffffde, 0x7ffffdf, 0x3ffffe5, 0xfffff1, 0x1ffffed,
+        0x7fff2, 0x1fffe3, 0x3ffffe6, 0x7ffffe0, 0x7ffffe1, 0x3ffffe7, 0x7ffffe2, 0xfffff2,
+        0x1fffe4, 0x1fffe5, 0x3ffffe8, 0x3ffffe9, 0xffffffd, 0x7ffffe3, 0x7ffffe4, 0x7ffffe5,
+        0xfffec, 0xfffff3, 0xfffed, 0x1fffe6, 0x3fffe9, 0x1fffe7, 0x1fffe8, 0x7ffff3,
+        0x3fffea, 0x3fffeb, 0x1ffffee, 0x1ffffef, 0xfffff4, 0xfffff5, 0x3ffffea, 0x7ffff4,
+        0x3ffffeb, 0x7ffffe6, 0x3ffffec, 0x3ffffed, 0x7ffffe7, 0x7ffffe8, 0x7ffffe9, 0x7ffffea,
+        0x7ffffeb, 0xffffffe, 0x7ffffec, 0x7ffffed, 0x7ffffee, 0x7ffffef, 0x7fffff0, 0x3ffffee,
+        0x3fffffff,
+    };
+    /// Length in bits of the Huffman codes.
+    const quint8 HPACK_HUFFMAN_CODE_LENGTHS[]
+    {
+        13, 23, 28, 28, 28, 28, 28, 28, 28, 24, 30, 28, 28, 30, 28, 28,
+        28, 28, 28, 28, 28, 28, 30, 28, 28, 28, 28, 28, 28, 28, 28, 28,
+        6, 10, 10, 12, 13, 6, 8, 11, 10, 10, 8, 11, 8, 6, 6, 6,
+        5, 5, 5, 6, 6, 6, 6, 6, 6, 6, 7, 8, 15, 6, 12, 10,
+        13, 6, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+        7, 7, 7, 7, 7, 7, 7, 7, 8, 7, 8, 13, 19, 13, 14, 6,
+        15, 5, 6, 5, 6, 5, 6, 6, 6, 5, 7, 7, 6, 6, 6, 5,
+        6, 7, 6, 5, 5, 6, 7, 7, 7, 7, 7, 15, 11, 14, 13, 28,
+        20, 22, 20, 20, 22, 22, 22, 23, 22, 23, 23, 23, 23, 23, 24, 23,
+        24, 24, 22, 23, 24, 23, 23, 23, 23, 21, 22, 23, 22, 23, 23, 24,
+        22, 21, 20, 22, 22, 23, 23, 21, 23, 22, 22, 24, 21, 22, 23, 23,
+        21, 21, 22, 21, 23, 22, 23, 23, 20, 22, 22, 22, 23, 22, 22, 23,
+        26, 26, 20, 19, 22, 23, 22, 25, 26, 26, 26, 27, 27, 26, 24, 25,
+        19, 21, 26, 27, 27, 26, 27, 24, 21, 21, 26, 26, 28, 27, 27, 27,
+        20, 24, 20, 21, 22, 21, 21, 23, 22, 22, 25, 25, 24, 24, 26, 23,
+        26, 27, 26, 26, 27, 27, 27, 27, 27, 28, 27, 27, 27, 27, 27, 26,
+        30,
+    };
+    /// Header fields of the static table, RFC 7541 appendix A. Index 1 is the first entry.
+    const char *const HPACK_STATIC_TABLE[][2]
+    {
+        {":authority", ""},
+        {":method", "GET"},
+        {":method", "POST"},
+        {":path", "/"},
+        {":path", "/index.html"},
+        {":scheme", "http"},
+        {":scheme", "https"},
+        {":status", "200"},
+        {":status", "204"},
+        {":status", "206"},
+        {":status", "304"},
+        {":status", "400"},
+        {":status", "404"},
+        {":status", "500"},
+        {"accept-charset", ""},
+        {"accept-encoding", "gzip, deflate"},
+        {"accept-language", ""},
+        {"accept-ranges", ""},
+        {"accept", ""},
+        {"access-control-allow-origin", ""},
+        {"age", ""},
+        {"allow", ""},
+        {"authorization", ""},
+        {"cache-control", ""},
+        {"content-disposition", ""},
+        {"content-encoding", ""},
+        {"content-language", ""},
+        {"content-length", ""},
+        {"content-location", ""},
+        {"content-range", ""},
+        {"content-type", ""},
+        {"cookie", ""},
+        {"date", ""},
+        {"etag", ""},
+        {"expect", ""},
+        {"expires", ""},
+        {"from", ""},
+        {"host", ""},
+        {"if-match", ""},
+        {"if-modified-since", ""},
+        {"if-none-match", ""},
+        {"if-range", ""},
+        {"if-unmodified-since", ""},
+        {"last-modified", ""},
+        {"link", ""},
+        {"location", ""},
+        {"max-forwards", ""},
+        {"proxy-authenticate", ""},
+        {"proxy-authorization", ""},
+        {"range", ""},
+        {"referer", ""},
+        {"refresh", ""},
+        {"retry-after", ""},
+        {"server", ""},
+        {"set-cookie", ""},
+        {"strict-transport-security", ""},
+        {"transfer-encoding", ""},
+        {"user-agent", ""},
+        {"vary", ""},
+        {"via", ""},
+        {"www-authenticate", ""},
+    };
+
+    static_assert(sizeof(HPACK_HUFFMAN_CODES) / sizeof(HPACK_HUFFMAN_CODES[0]) == HPACK_HUFFMAN_EOS + 1,
+                  "HPACK_HUFFMAN_CODES must have a code for each octet and the end of string");
+    static_assert(sizeof(HPACK_HUFFMAN_CODE_LENGTHS) == HPACK_HUFFMAN_EOS + 1,
+                  "HPACK_HUFFMAN_CODE_LENGTHS must have a length for each code");
+    static_assert(sizeof(HPACK_STATIC_TABLE) / sizeof(HPACK_STATIC_TABLE[0]) == 61,
+                  "HPACK_STATIC_TABLE must have the 61 entries of the RFC");
+
+    namespace
+    {
+        /** ********************************************************************************************
+        * @struct   HuffmanNode
+        *
+        * @brief    Node of the tree decoding the Huffman codes one bit at a time.
+        ***********************************************************************************************/
+        struct HuffmanNode
+        {
+            int children[2] = {-1, -1};
+            // Decoded symbol, -1 for inner nodes.
+            int symbol = -1;
+        };
+
+        /** ********************************************************************************************
+        * @brief        Get the decoding tree of the Huffman codes, built on first use. The root is the
+        *               first node.
+        ***********************************************************************************************/
+        const std::vector<HuffmanNode> &huffmanTree()
+        {
+            static const std::vector<HuffmanNode> tree = []()
+            {
+                std::vector<HuffmanNode> nodes(1);
+
+                for (int symbol = 0; symbol <= HPACK_HUFFMAN_EOS; ++symbol)
+                {
+                    size_t node = 0;
+                    for (int bit = HPACK_HUFFMAN_CODE_LENGTHS[symbol] - 1; bit >= 0; --bit)
+                    {
+                        const int branch = (HPACK_HUFFMAN_CODES[symbol] >> bit) & 1;
+                        if (nodes[node].children[branch] < 0)
+                        {
+                            nodes[node].children[branch] = static_cast<int>(nodes.size());
+                            nodes.emplace_back();
+                        }
+                        node = static_cast<size_t>(nodes[node].children[branch]);
+                    }
+                    nodes[node].symbol = symbol;
+                }
+
+                return nodes;
+            }();
+
+            return tree;
+        }
+    }
+
+    /** ************************************************************************************************
+    * @brief        Decode a complete header block.
+    *
+    * @param[out]   headers: The header fields, in the order of the block. Names are lower case.
+    *
+    * @return       False if the block is invalid: the connection must then be closed, as the dynamic
+    *               table may be out of sync with the client.
+    ***************************************************************************************************/
+    bool Hpack::decode(const QByteArray &block, QList<Header> &headers)
+    {
+        const uchar *position = reinterpret_cast<const uchar*>(block.constData());
+        const uchar *end = position + block.size();
+
+        headers.clear();
+        while (position < end)
+        {
+            const uchar first = *position;
+            quint32 index = 0;
+            Header header;
+
+            if (first & 0x80)
+            {
+                // Indexed header field.
+                if (!decodeInteger(position, end, 7, index) || !lookup(index, header))
+                {
+                    return false;
+                }
+                headers.append(header);
+                continue;
+            }
+
+            if ((first & 0xE0) == 0x20)
+            {
+                // Dynamic table size update.
+                if (!decodeInteger(position, end, 5, index) || index > static_cast<quint32>(HPACK_MAX_TABLE_SIZE))
+                {
+                    return false;
+                }
+                m_maxDynamicTableSize = static_cast<int>(index);
+                evict(m_maxDynamicTableSize);
+                continue;
+            }
+
+            // Literal header field, with incremental indexing (6 bit prefix) or without indexing or never
+            // indexed (4 bit prefix). The name is a literal if its index is 0.
+            const bool indexing = (first & 0xC0) == 0x40;
+            if (!decodeInteger(position, end, indexing ? 6 : 4, index))
+            {
+                return false;
+            }
+            if (index != 0)
+            {
+                Header indexed;
+                if (!lookup(index, indexed))
+                {
+                    return false;
+                }
+                header.first = indexed.first;
+            }
+            else if (!decodeString(position, end, header.first))
+            {
+                return false;
+            }
+            if (!decodeString(position, end, header.second))
+            {
+                return false;
+            }
+
+            if (indexing)
+            {
+                insert(header);
+            }
+            headers.append(header);
+        }
+
+        return true;
+    }
+
+    /** ************************************************************************************************
+    * @brief        Encode header fields as literals without indexing, with literal names.
+    ***************************************************************************************************/
+    QByteArray Hpack::encode(const QList<Header> &headers)
+    {
+        QByteArray block;
+
+        for (const Header &header : headers)
+        {
+            block.append('\0');
+            encodeInteger(block, 0x00, 7, static_cast<quint32>(header.first.size()));
+            block.append(header.first.toLower());
+            encodeInteger(block, 0x00, 7, static_cast<quint32>(header.second.size()));
+            block.append(header.second);
+        }
+
+        return block;
+    }
+
+    /** ************************************************************************************************
+    * @brief        Decode an integer with the given prefix size, RFC 7541 section 5.1.
+    ***************************************************************************************************/
+    bool Hpack::decodeInteger(const uchar *&position, const uchar *end, int prefixBits, quint32 &value)
+    {
+        if (position >= end)
+        {
+            return false;
+        }
+
+        const quint32 prefixMask = (1u << prefixBits) - 1;
+        value = *position++ & prefixMask;
+        if (value < prefixMask)
+        {
+            return true;
+        }
+
+        // Larger values continue with 7 bits per byte. Values above 2^28 are not needed by any header.
+        for (int shift = 0; shift <= 21; shift += 7)
+        {
+            if (position >= end)
+            {
+                return false;
+            }
+
+            const uchar byte = *position++;
+            value += static_cast<quint32>(byte & 0x7F) << shift;
+            if (!(byte & 0x80))
+            {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    /** ************************************************************************************************
+    * @brief        Decode a string literal, Huffman coded or not, RFC 7541 section 5.2.
+    ***************************************************************************************************/
+    bool Hpack::decodeString(const uchar *&position, const uchar *end, QByteArray &string)
+    {
+        if (position >= end)
+        {
+            return false;
+        }
+
+        const bool huffman = *position & 0x80;
+        quint32 size = 0;
+        if (!decodeInteger(position, end, 7, size) || size > static_cast<quint32>(end - position))
+        {
+            return false;
+        }
+
+        const int length = static_cast<int>(size);
+        if (huffman)
+        {
+            if (!decodeHuffman(position, length, string))
+            {
+                return false;
+            }
+        }
+        else
+        {
+            string = QByteArray(reinterpret_cast<const char*>(position), length);
+        }
+
+        position += length;
+        return true;
+    }
+
+    /** ************************************************************************************************
+    * @brief        Decode a Huffman coded string.
+    *
+    * @details      The string is padded with the most significant bits of the end of string code, that
+    *               is with at most 7 bits set to 1.
+    ***************************************************************************************************/
+    bool Hpack::decodeHuffman(const uchar *data, int size, QByteArray &string)
+    {
+        const std::vector<HuffmanNode> &tree = huffmanTree();
+        size_t node = 0;
+        int paddingBits = 0;
+        bool paddingOnes = true;
+
+        string.clear();
+        string.reserve(size * 8 / 5);
+
+        for (int i = 0; i < size; ++i)
+        {
+            for (int bit = 7; bit >= 0; --bit)
+            {
+                const int branch = (data[i] >> bit) & 1;
+                const int child = tree[node].children[branch];
+                if (child < 0)
+                {
+                    return false;
+                }
+
+                ++paddingBits;
+                paddingOnes = paddingOnes && branch == 1;
+                node = static_cast<size_t>(child);
+
+                const int symbol = tree[node].symbol;
+                if (symbol == HPACK_HUFFMAN_EOS)
+                {
+                    return false;
+                }
+                if (symbol >= 0)
+                {
+                    string.append(static_cast<char>(symbol));
+                    node = 0;
+                    paddingBits = 0;
+                    paddingOnes = true;
+                }
+            }
+        }
+
+        return node == 0 || (paddingBits <= 7 && paddingOnes);
+    }
+
+    /** ************************************************************************************************
+    * @brief        Encode an integer with the given prefix size, the other bits of the first byte being
+    *               set to flags.
+    ***************************************************************************************************/
+    void Hpack::encodeInteger(QByteArray &block, uchar flags, int prefixBits, quint32 value)
+    {
+        const quint32 prefixMask = (1u << prefixBits) - 1;
+        if (value < prefixMask)
+        {
+            block.append(static_cast<char>(flags | value));
+            return;
+        }
+
+        block.append(static_cast<char>(flags | prefixMask));
+        value -= prefixMask;
+        while (value >= 0x80)
+        {
+            block.append(static_cast<char>((value & 0x7F) | 0x80));
+            value >>= 7;
+        }
+        block.append(static_cast<char>(value));
+    }
+
+    /** ************************************************************************************************
+    * @brief        Get the header field at an index of the static table followed by the dynamic table.
+    ***************************************************************************************************/
+    bool Hpack::lookup(quint32 index, Header &header) const
+    {
+        const quint32 staticSize = sizeof(HPACK_STATIC_TABLE) / sizeof(HPACK_STATIC_TABLE[0]);
+
+        if (index == 0)
+        {
+            return false;
+        }
+        if (index <= staticSize)
+        {
+            header = Header(HPACK_STATIC_TABLE[index - 1][0], HPACK_STATIC_TABLE[index - 1][1]);
+            return true;
+        }
+        if (index - staticSize > m_dynamicTable.size())
+        {
+            return false;
+        }
+
+        header = m_dynamicTable[index - staticSize - 1];
+        return true;
+    }
+
+    /** ************************************************************************************************
+    * @brief        Add a header field to the dynamic table, evicting the oldest entries to make room.
+    ***************************************************************************************************/
+    void Hpack::insert(const Header &header)
+    {
+        const int size = HPACK_ENTRY_OVERHEAD + header.first.size() + header.second.size();
+
+        evict(m_maxDynamicTableSize - size);
+        if (size <= m_maxDynamicTableSize)
+        {
+            m_dynamicTable.push_front(header);
+            m_dynamicTableSize += size;
+        }
+    }
+
+    /** ************************************************************************************************
+    * @brief        Remove the oldest entries of the dynamic table until its size is at most maxSize.
+    ***************************************************************************************************/
+    void Hpack::evict(int maxSize)
+    {
+        while (!m_dynamicTable.empty() && m_dynamicTableSize > maxSize)
+        {
+            const Header &oldest = m_dynamicTable.back();
+            m_dynamicTableSize -= HPACK_ENTRY_OVERHEAD + oldest.first.size() + oldest.second.size();
+            m_dynamicTable.pop_back();
+        }
+    }
+}
@@ -0,0 +1,47 @@
+#ifndef HPACK_H
+#define HPACK_H
+
+#include <deque>
+
+#include <QByteArray>
+#include <QList>
+#include <QPair>
+
+namespace Qtify
+{
+    /** ************************************************************************************************
+    * @class    Hpack
+    *
+    * @brief    Header compression of HTTP/2 (RFC 7541), for the HTTP/2 connections of the MockServer.
+    *
+    * @details  decode() reads the header blocks sent by a client. The dynamic table is kept between the
+    *           blocks, so there must be one object per connection. encode() writes the header blocks of
+    *           the responses with literals that are never indexed nor Huffman coded: this is valid for
+    *           any client and the responses of the mock are small.
+    ***************************************************************************************************/
+    class Hpack
+    {
+        public:
+            using Header = QPair<QByteArray, QByteArray>;
+
+            bool decode(const QByteArray &block, QList<Header> &headers);
+            static QByteArray encode(const QList<Header> &headers);
+
+        private:
+            static bool decodeInteger(const uchar *&position, const uchar *end, int prefixBits, quint32 &value);
+            static bool decodeString(const uchar *&position, const uchar *end, QByteArray &string);
+            static bool decodeHuffman(const uchar *data, int size, QByteArray &string);
+            static void encodeInteger(QByteArray &block, uchar flags, int prefixBits, quint32 value);
+            bool lookup(quint32 index, Header &header) const;
+            void insert(const Header &header);
+            void evict(int maxSize);
+
+            // Entries of the dynamic table, the newest first.
+            std::deque<Header> m_dynamicTable;
+            // Size of the dynamic table as defined by the RFC: 32 bytes per entry plus its name and value.
+            int m_dynamicTableSize = 0;
+            int m_maxDynamicTableSize = 4096;
+    };
+}
+
+#endif // HPACK_H
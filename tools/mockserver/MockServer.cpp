@@ -0,0 +1,1119 @@
+#include "MockServer.h"
+
+#include <QCryptographicHash>
+#include <QFile>
+#include <QHostAddress>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QPointer>
+#include <QRandomGenerator>
+#include <QSslCertificate>
+#include <QSslKey>
+#include <QSslSocket>
+#include <QTimer>
+#include <QUrl>
+#include <QtEndian>
+#include <QDebug>
+
+#include <algorithm>
+#include <iterator>
+
+namespace Qtify
+{
+    /// Maximum size of a request, larger requests are dropped.
+    const int MOCK_REQUEST_MAX_SIZE{1024 * 1024};
+    /// Number of tracks of the mocked playback queue.
+    const int MOCK_TRACK_COUNT{10};
+    /// Duration of the mocked tracks.
+    const qint64 MOCK_TRACK_DURATION_MS{180000};
+    /// Length of the rate limit window.
+    const qint64 MOCK_RATE_LIMIT_WINDOW_MS{1000};
+    /// Test certificate and private key of the TLS connections, for localhost and 127.0.0.1.
+    const char MOCK_CERTIFICATE_PATH[]{":/certs/localhost.crt"};
+    const char MOCK_PRIVATE_KEY_PATH[]{":/certs/localhost.key"};
+
+    /// Connection preface sent by the HTTP/2 clients.
+    const QByteArray HTTP2_CLIENT_PREFACE{"PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n"};
+    /// Size of the header of the HTTP/2 frames.
+    const int HTTP2_FRAME_HEADER_SIZE{9};
+    /// Largest HTTP/2 frame payload, the default SETTINGS_MAX_FRAME_SIZE.
+    const int HTTP2_MAX_FRAME_SIZE{16384};
+
+    /// Types of the HTTP/2 frames.
+    enum Http2FrameType : uchar
+    {
+        Http2Frame_Data         = 0x0,
+        Http2Frame_Headers      = 0x1,
+        Http2Frame_Priority     = 0x2,
+        Http2Frame_RstStream    = 0x3,
+        Http2Frame_Settings     = 0x4,
+        Http2Frame_PushPromise  = 0x5,
+        Http2Frame_Ping         = 0x6,
+        Http2Frame_GoAway       = 0x7,
+        Http2Frame_WindowUpdate = 0x8,
+        Http2Frame_Continuation = 0x9,
+    };
+
+    /// Flags of the HTTP/2 frames.
+    enum Http2Flag : uchar
+    {
+        Http2Flag_EndStream  = 0x1,
+        Http2Flag_Ack        = 0x1,
+        Http2Flag_EndHeaders = 0x4,
+        Http2Flag_Padded     = 0x8,
+        Http2Flag_Priority   = 0x20,
+    };
+
+    /// HTTP/2 error codes sent with GOAWAY.
+    enum Http2Error : quint32
+    {
+        Http2Error_None         = 0x0,
+        Http2Error_Protocol     = 0x1,
+        Http2Error_StreamClosed = 0x5,
+        Http2Error_FrameSize    = 0x6,
+        Http2Error_Compression  = 0x9,
+    };
+
+    /** ************************************************************************************************
+    * @brief        Constructor.
+    ***************************************************************************************************/
+    MockServer::MockServer(const Options &options, QObject *parent) :
+        QObject(parent),
+        m_options(options),
+        m_server(this)
+    {
+        connect(&m_server, &QTcpServer::newConnection, this, &MockServer::onNewConnection);
+        m_clock.start();
+
+        for (int i = 0; i < MOCK_TRACK_COUNT; ++i)
+        {
+            m_tracks.push_back(buildTrack(i));
+        }
+    }
+
+    /** ************************************************************************************************
+    * @brief        Start listening on the given address and port.
+    *
+    * @return       True if the port could be opened.
+    ***************************************************************************************************/
+    bool MockServer::listen(const QHostAddress &address, quint16 port)
+    {
+        if (m_options.tls)
+        {
+            if (!QSslSocket::supportsSsl())
+            {
+                qWarning() << "Cannot serve HTTPS: SSL is not supported";
+                return false;
+            }
+
+            QFile certificateFile(MOCK_CERTIFICATE_PATH);
+            QFile privateKeyFile(MOCK_PRIVATE_KEY_PATH);
+            if (!certificateFile.open(QIODevice::ReadOnly) || !privateKeyFile.open(QIODevice::ReadOnly))
+            {
+                qWarning() << "Cannot read the test certificate";
+                return false;
+            }
+
+            QSslConfiguration configuration = QSslConfiguration::defaultConfiguration();
+            configuration.setLocalCertificate(QSslCertificate(&certificateFile, QSsl::Pem));
+            configuration.setPrivateKey(QSslKey(&privateKeyFile, QSsl::Rsa, QSsl::Pem));
+            configuration.setPeerVerifyMode(QSslSocket::VerifyNone);
+            if (m_options.http2)
+            {
+                configuration.setAllowedNextProtocols({QSslConfiguration::ALPNProtocolHTTP2,
+                                                       QSslConfiguration::NextProtocolHttp1_1});
+            }
+            else
+            {
+                configuration.setAllowedNextProtocols({QSslConfiguration::NextProtocolHttp1_1});
+            }
+
+            m_server.setSslConfiguration(configuration);
+            m_server.setHandshakeLatency(m_options.handshakeLatency);
+        }
+
+        if (!m_server.listen(address, port))
+        {
+            qWarning() << "Cannot listen on port" << port << ":" << m_server.errorString();
+            return false;
+        }
+
+        return true;
+    }
+
+    /** ************************************************************************************************
+    * @brief        Get the port the server listens on, chosen by the system if 0 was given to listen().
+    ***************************************************************************************************/
+    quint16 MockServer::getPort() const
+    {
+        return m_server.serverPort();
+    }
+
+    /** ************************************************************************************************
+    * @brief        Function called when a client connects.
+    ***************************************************************************************************/
+    void MockServer::onNewConnection()
+    {
+        while (QTcpSocket *socket = m_server.nextPendingConnection())
+        {
+            m_connections.insert(socket, Connection());
+            connect(socket, &QTcpSocket::readyRead, this, &MockServer::onReadyRead);
+            connect(socket, &QTcpSocket::disconnected, this, [this, socket]()
+            {
+                m_connections.remove(socket);
+                socket->deleteLater();
+            });
+
+            if (QSslSocket *sslSocket = qobject_cast<QSslSocket*>(socket))
+            {
+                connect(sslSocket, &QSslSocket::encrypted, this, &MockServer::onEncrypted);
+            }
+        }
+    }
+
+    /** ************************************************************************************************
+    * @brief        Function called when the handshake of a TLS connection is done.
+    *
+    * @details      The protocol negotiated with ALPN is kept and emitted with connectionEncrypted(). An
+    *               HTTP/2 connection starts with the SETTINGS frame of the server, the default settings
+    *               being used.
+    ***************************************************************************************************/
+    void MockServer::onEncrypted()
+    {
+        QSslSocket *socket = qobject_cast<QSslSocket*>(QObject::sender());
+        if (!socket || !m_connections.contains(socket))
+        {
+            return;
+        }
+
+        const QByteArray protocol = socket->sslConfiguration().nextNegotiatedProtocol();
+        if (protocol == QSslConfiguration::ALPNProtocolHTTP2)
+        {
+            m_connections[socket].http2 = true;
+            writeFrame(socket, Http2Frame_Settings, 0, 0);
+        }
+
+        emit connectionEncrypted(protocol);
+    }
+
+    /** ************************************************************************************************
+    * @brief        Function called when data is received from a client.
+    ***************************************************************************************************/
+    void MockServer::onReadyRead()
+    {
+        QTcpSocket *socket = qobject_cast<QTcpSocket*>(QObject::sender());
+        if (!socket || !m_connections.contains(socket))
+        {
+            return;
+        }
+
+        // Until the TLS handshake starts, the data received is the hello of the client, left to it.
+        const QSslSocket *sslSocket = qobject_cast<QSslSocket*>(socket);
+        if (sslSocket && !sslSocket->isEncrypted())
+        {
+            return;
+        }
+
+        Connection &connection = m_connections[socket];
+        connection.buffer += socket->readAll();
+
+        if (connection.buffer.size() > MOCK_REQUEST_MAX_SIZE)
+        {
+            socket->abort();
+            return;
+        }
+
+        if (connection.http2)
+        {
+            processFrames(socket);
+        }
+        else
+        {
+            processRequests(socket);
+        }
+    }
+
+    /** ************************************************************************************************
+    * @brief        Answer the next complete request of a connection, unless a response is still delayed.
+    *
+    * @details      The response is sent after the latency. The next request is processed once it is sent,
+    *               so that the responses keep the order of the requests.
+    ***************************************************************************************************/
+    void MockServer::processRequests(QTcpSocket *socket)
+    {
+        Connection &connection = m_connections[socket];
+        if (connection.busy)
+        {
+            return;
+        }
+
+        Request request;
+        bool valid = true;
+        if (!parseRequest(connection.buffer, request, valid))
+        {
+            if (!valid)
+            {
+                send(socket, errorResponse(400, "Malformed request"), true);
+            }
+            return;
+        }
+
+        const Response response = handle(request);
+        const bool close = request.headers.value("connection").toLower() == "close";
+
+        connection.busy = true;
+        QPointer<QTcpSocket> target(socket);
+        QTimer::singleShot(getReplyDelay(), this, [this, target, response, close]()
+        {
+            if (!target || !m_connections.contains(target))
+            {
+                return;
+            }
+
+            m_connections[target].busy = false;
+            send(target, response, close);
+
+            if (!close)
+            {
+                processRequests(target);
+            }
+        });
+    }
+
+    /** ************************************************************************************************
+    * @brief        Take the first request out of the data received.
+    *
+    * @param[out]   valid: Set to false if the data is not an HTTP request.
+    *
+    * @return       True if a complete request was parsed.
+    ***************************************************************************************************/
+    bool MockServer::parseRequest(QByteArray &buffer, Request &request, bool &valid)
+    {
+        const int headersEnd = buffer.indexOf("\r\n\r\n");
+        if (headersEnd < 0)
+        {
+            return false;
+        }
+
+        const QList<QByteArray> lines = buffer.left(headersEnd).split('\n');
+        const QList<QByteArray> requestLine = lines.value(0).trimmed().split(' ');
+        if (requestLine.size() != 3)
+        {
+            valid = false;
+            return false;
+        }
+
+        for (int i = 1; i < lines.size(); ++i)
+        {
+            const int separator = lines[i].indexOf(':');
+            if (separator > 0)
+            {
+                request.headers.insert(lines[i].left(separator).trimmed().toLower(), lines[i].mid(separator + 1).trimmed());
+            }
+        }
+
+        const int bodySize = request.headers.value("content-length", "0").toInt();
+        if (buffer.size() < headersEnd + 4 + bodySize)
+        {
+            return false;
+        }
+
+        request.method = requestLine[0];
+        request.body   = buffer.mid(headersEnd + 4, bodySize);
+        setTarget(request, requestLine[1]);
+
+        buffer.remove(0, headersEnd + 4 + bodySize);
+        return true;
+    }
+
+    /** ************************************************************************************************
+    * @brief        Set the path and query of a request from its target, "/path?query".
+    ***************************************************************************************************/
+    void MockServer::setTarget(Request &request, const QByteArray &target)
+    {
+        const QUrl url(QString::fromUtf8(target));
+        request.path  = url.path().mid(1);
+        request.query = QUrlQuery(url);
+    }
+
+    /** ************************************************************************************************
+    * @brief        Write a response to a client.
+    *
+    * @param[in]    close: Close the connection once the response is written.
+    ***************************************************************************************************/
+    void MockServer::send(QTcpSocket *socket, const Response &response, bool close)
+    {
+        socket->write("HTTP/1.1 " + QByteArray::number(response.status) + ' ' + reasonPhrase(response.status) + "\r\n"
+                      + response.headers
+                      + "Content-Length: " + QByteArray::number(response.body.size()) + "\r\n"
+                      + (close ? "Connection: close\r\n" : "") + "\r\n"
+                      + response.body);
+
+        if (close)
+        {
+            socket->disconnectFromHost();
+        }
+    }
+
+    /** ************************************************************************************************
+    * @brief        Get the delay of the next reply: the latency plus a random jitter.
+    ***************************************************************************************************/
+    qint64 MockServer::getReplyDelay() const
+    {
+        qint64 delay = m_options.latency.count();
+        if (m_options.latencyJitter.count() > 0)
+        {
+            delay += QRandomGenerator::global()->bounded(m_options.latencyJitter.count() + 1);
+        }
+
+        return delay;
+    }
+
+    /** ************************************************************************************************
+    * @brief        Handle the complete frames received on an HTTP/2 connection.
+    *
+    * @details      The connection is closed with GOAWAY on the first protocol error.
+    ***************************************************************************************************/
+    void MockServer::processFrames(QTcpSocket *socket)
+    {
+        Connection &connection = m_connections[socket];
+        if (!connection.prefaceReceived)
+        {
+            if (connection.buffer.size() < HTTP2_CLIENT_PREFACE.size())
+            {
+                return;
+            }
+            if (!connection.buffer.startsWith(HTTP2_CLIENT_PREFACE))
+            {
+                socket->abort();
+                return;
+            }
+
+            connection.buffer.remove(0, HTTP2_CLIENT_PREFACE.size());
+            connection.prefaceReceived = true;
+        }
+
+        while (connection.buffer.size() >= HTTP2_FRAME_HEADER_SIZE)
+        {
+            const uchar *header = reinterpret_cast<const uchar*>(connection.buffer.constData());
+            const int length = (header[0] << 16) | (header[1] << 8) | header[2];
+
+            quint32 error = Http2Error_FrameSize;
+            if (length <= HTTP2_MAX_FRAME_SIZE)
+            {
+                if (connection.buffer.size() < HTTP2_FRAME_HEADER_SIZE + length)
+                {
+                    return;
+                }
+
+                const uchar type = header[3];
+                const uchar flags = header[4];
+                const quint32 streamId = qFromBigEndian<quint32>(header + 5) & 0x7fffffff;
+                const QByteArray payload = connection.buffer.mid(HTTP2_FRAME_HEADER_SIZE, length);
+                connection.buffer.remove(0, HTTP2_FRAME_HEADER_SIZE + length);
+
+                error = handleFrame(socket, type, flags, streamId, payload);
+
+                // The connection is gone if the frame closed it.
+                if (!m_connections.contains(socket) || socket->state() != QAbstractSocket::ConnectedState)
+                {
+                    return;
+                }
+            }
+
+            if (error != Http2Error_None)
+            {
+                QByteArray goAway(8, Qt::Uninitialized);
+                qToBigEndian(connection.lastStream, goAway.data());
+                qToBigEndian(error, goAway.data() + 4);
+
+                writeFrame(socket, Http2Frame_GoAway, 0, 0, goAway);
+                socket->disconnectFromHost();
+                return;
+            }
+        }
+    }
+
+    /** ************************************************************************************************
+    * @brief        Handle an HTTP/2 frame.
+    *
+    * @details      The streams are answered once their request is complete. PRIORITY, WINDOW_UPDATE and
+    *               the unknown frames are ignored.
+    *
+    * @return       The error code to close the connection with, Http2Error_None if the frame is valid.
+    ***************************************************************************************************/
+    quint32 MockServer::handleFrame(QTcpSocket *socket, uchar type, uchar flags, quint32 streamId, QByteArray payload)
+    {
+        Connection &connection = m_connections[socket];
+
+        // A header block must be received as a whole, before any other frame.
+        if (connection.continuedStream != 0 && (type != Http2Frame_Continuation || streamId != connection.continuedStream))
+        {
+            return Http2Error_Protocol;
+        }
+
+        switch (type)
+        {
+            case Http2Frame_Data:
+            case Http2Frame_Headers:
+            {
+                if (streamId == 0)
+                {
+                    return Http2Error_Protocol;
+                }
+
+                // Remove the padding, and the stream priority that is not used.
+                int begin = 0;
+                int end = payload.size();
+                if (flags & Http2Flag_Padded)
+                {
+                    if (payload.isEmpty())
+                    {
+                        return Http2Error_Protocol;
+                    }
+                    begin = 1;
+                    end -= static_cast<uchar>(payload[0]);
+                }
+                if (type == Http2Frame_Headers && (flags & Http2Flag_Priority))
+                {
+                    begin += 5;
+                }
+                if (end < begin)
+                {
+                    return Http2Error_Protocol;
+                }
+                payload = payload.mid(begin, end - begin);
+
+                const bool endStream = flags & Http2Flag_EndStream;
+                if (type == Http2Frame_Headers)
+                {
+                    if (streamId % 2 == 0 || streamId <= connection.lastStream)
+                    {
+                        return Http2Error_Protocol;
+                    }
+                    connection.lastStream = streamId;
+
+                    if (!(flags & Http2Flag_EndHeaders))
+                    {
+                        connection.continuedStream    = streamId;
+                        connection.continuedHeaders   = payload;
+                        connection.continuedEndStream = endStream;
+                        return Http2Error_None;
+                    }
+
+                    return handleHeaders(socket, streamId, payload, endStream);
+                }
+
+                const auto stream = connection.streams.find(streamId);
+                if (stream == connection.streams.end())
+                {
+                    return Http2Error_StreamClosed;
+                }
+
+                stream->body += payload;
+                if (stream->body.size() > MOCK_REQUEST_MAX_SIZE)
+                {
+                    return Http2Error_Protocol;
+                }
+
+                // The body is kept whole: the flow control windows are given back at once.
+                if (!payload.isEmpty())
+                {
+                    QByteArray increment(4, Qt::Uninitialized);
+                    qToBigEndian(static_cast<quint32>(payload.size()), increment.data());
+
+                    writeFrame(socket, Http2Frame_WindowUpdate, 0, 0, increment);
+                    if (!endStream)
+                    {
+                        writeFrame(socket, Http2Frame_WindowUpdate, 0, streamId, increment);
+                    }
+                }
+
+                if (endStream)
+                {
+                    answerStream(socket, streamId);
+                }
+                return Http2Error_None;
+            }
+
+            case Http2Frame_Continuation:
+            {
+                if (connection.continuedStream == 0)
+                {
+                    return Http2Error_Protocol;
+                }
+
+                connection.continuedHeaders += payload;
+                if (!(flags & Http2Flag_EndHeaders))
+                {
+                    return Http2Error_None;
+                }
+
+                const QByteArray block = connection.continuedHeaders;
+                connection.continuedStream = 0;
+                connection.continuedHeaders.clear();
+
+                return handleHeaders(socket, streamId, block, connection.continuedEndStream);
+            }
+
+            case Http2Frame_RstStream:
+                connection.streams.remove(streamId);
+                return Http2Error_None;
+
+            case Http2Frame_Settings:
+                if (streamId != 0)
+                {
+                    return Http2Error_Protocol;
+                }
+                if (!(flags & Http2Flag_Ack))
+                {
+                    writeFrame(socket, Http2Frame_Settings, Http2Flag_Ack, 0);
+                }
+                return Http2Error_None;
+
+            case Http2Frame_PushPromise:
+                return Http2Error_Protocol;
+
+            case Http2Frame_Ping:
+                if (streamId != 0 || payload.size() != 8)
+                {
+                    return Http2Error_Protocol;
+                }
+                if (!(flags & Http2Flag_Ack))
+                {
+                    writeFrame(socket, Http2Frame_Ping, Http2Flag_Ack, 0, payload);
+                }
+                return Http2Error_None;
+
+            case Http2Frame_GoAway:
+                socket->disconnectFromHost();
+                return Http2Error_None;
+
+            default:
+                return Http2Error_None;
+        }
+    }
+
+    /** ************************************************************************************************
+    * @brief        Decode the header block of a request and open its stream.
+    *
+    * @return       The error code to close the connection with, Http2Error_None if the block is valid.
+    ***************************************************************************************************/
+    quint32 MockServer::handleHeaders(QTcpSocket *socket, quint32 streamId, const QByteArray &block, bool endStream)
+    {
+        Connection &connection = m_connections[socket];
+
+        QList<Hpack::Header> headers;
+        if (!connection.hpack.decode(block, headers))
+        {
+            return Http2Error_Compression;
+        }
+
+        Request request;
+        for (const Hpack::Header &header : headers)
+        {
+            if (header.first == ":method")
+            {
+                request.method = header.second;
+            }
+            else if (header.first == ":path")
+            {
+                setTarget(request, header.second);
+            }
+            else if (!header.first.startsWith(':'))
+            {
+                request.headers.insert(header.first, header.second);
+            }
+        }
+
+        if (request.method.isEmpty())
+        {
+            return Http2Error_Protocol;
+        }
+
+        connection.streams.insert(streamId, request);
+        if (endStream)
+        {
+            answerStream(socket, streamId);
+        }
+
+        return Http2Error_None;
+    }
+
+    /** ************************************************************************************************
+    * @brief        Answer the complete request of an HTTP/2 stream after the latency.
+    *
+    * @details      Unlike HTTP/1.1, the streams of a connection are answered concurrently.
+    ***************************************************************************************************/
+    void MockServer::answerStream(QTcpSocket *socket, quint32 streamId)
+    {
+        const Response response = handle(m_connections[socket].streams.take(streamId));
+
+        QPointer<QTcpSocket> target(socket);
+        QTimer::singleShot(getReplyDelay(), this, [this, target, streamId, response]()
+        {
+            if (!target || !m_connections.contains(target))
+            {
+                return;
+            }
+
+            sendStream(target, streamId, response);
+        });
+    }
+
+    /** ************************************************************************************************
+    * @brief        Write a response to an HTTP/2 stream, which ends it.
+    ***************************************************************************************************/
+    void MockServer::sendStream(QTcpSocket *socket, quint32 streamId, const Response &response)
+    {
+        QList<Hpack::Header> headers{{":status", QByteArray::number(response.status)}};
+        for (const QByteArray &line : response.headers.split('\n'))
+        {
+            const int separator = line.indexOf(':');
+            if (separator > 0)
+            {
+                headers.append({line.left(separator).trimmed().toLower(), line.mid(separator + 1).trimmed()});
+            }
+        }
+        headers.append({"content-length", QByteArray::number(response.body.size())});
+
+        const uchar headersFlags = static_cast<uchar>(Http2Flag_EndHeaders
+                                                      | (response.body.isEmpty() ? Http2Flag_EndStream : 0));
+        writeFrame(socket, Http2Frame_Headers, headersFlags, streamId, Hpack::encode(headers));
+
+        for (int offset = 0; offset < response.body.size(); offset += HTTP2_MAX_FRAME_SIZE)
+        {
+            const bool last = offset + HTTP2_MAX_FRAME_SIZE >= response.body.size();
+            writeFrame(socket, Http2Frame_Data, last ? Http2Flag_EndStream : 0, streamId,
+                       response.body.mid(offset, HTTP2_MAX_FRAME_SIZE));
+        }
+    }
+
+    /** ************************************************************************************************
+    * @brief        Write an HTTP/2 frame.
+    ***************************************************************************************************/
+    void MockServer::writeFrame(QTcpSocket *socket, uchar type, uchar flags, quint32 streamId, const QByteArray &payload)
+    {
+        QByteArray frame(HTTP2_FRAME_HEADER_SIZE, Qt::Uninitialized);
+        uchar *header = reinterpret_cast<uchar*>(frame.data());
+        header[0] = static_cast<uchar>(payload.size() >> 16);
+        header[1] = static_cast<uchar>(payload.size() >> 8);
+        header[2] = static_cast<uchar>(payload.size());
+        header[3] = type;
+        header[4] = flags;
+        qToBigEndian(streamId, header + 5);
+
+        socket->write(frame + payload);
+    }
+
+    /** ************************************************************************************************
+    * @brief        Build the response to a request.
+    ***************************************************************************************************/
+    MockServer::Response MockServer::handle(const Request &request)
+    {
+        if (m_options.verbose)
+        {
+            qInfo().noquote() << request.method << request.path << request.query.toString();
+        }
+
+        if (request.path == "authorize")
+        {
+            return handleAuthorize(request);
+        }
+        if (request.path == "api/token")
+        {
+            return handleToken(request);
+        }
+        if (request.path.startsWith("v1/"))
+        {
+            return handleApi(request);
+        }
+
+        return errorResponse(404, "Service not found");
+    }
+
+    /** ************************************************************************************************
+    * @brief        Grant the authorization at once: redirect to the client with an authorization code.
+    ***************************************************************************************************/
+    MockServer::Response MockServer::handleAuthorize(const Request &request)
+    {
+        QUrl redirectUrl(request.query.queryItemValue("redirect_uri", QUrl::FullyDecoded));
+        if (!redirectUrl.isValid() || redirectUrl.isEmpty())
+        {
+            return errorResponse(400, "Missing redirect_uri");
+        }
+
+        QUrlQuery redirectQuery;
+        redirectQuery.addQueryItem("code", "mock-authorization-code");
+        redirectQuery.addQueryItem("state", request.query.queryItemValue("state"));
+        redirectUrl.setQuery(redirectQuery);
+
+        return {302, "Location: " + redirectUrl.toEncoded() + "\r\n", QByteArray()};
+    }
+
+    /** ************************************************************************************************
+    * @brief        Issue an access token for the authorization code and refresh token grants.
+    ***************************************************************************************************/
+    MockServer::Response MockServer::handleToken(const Request &request)
+    {
+        if (request.method != "POST")
+        {
+            return errorResponse(405, "Method not allowed");
+        }
+
+        const QString grantType = QUrlQuery(QString::fromUtf8(request.body)).queryItemValue("grant_type");
+        if (grantType != "authorization_code" && grantType != "refresh_token")
+        {
+            Response response = jsonResponse(request, QJsonObject{{"error", "unsupported_grant_type"}});
+            response.status = 400;
+            return response;
+        }
+
+        const QByteArray accessToken = "mock-access-token-" + QByteArray::number(++m_issuedTokenCount);
+        m_accessTokens.insert(accessToken, m_clock.elapsed());
+
+        QJsonObject json
+        {
+            {"access_token", QString::fromLatin1(accessToken)},
+            {"token_type",   "Bearer"},
+            {"expires_in",   static_cast<int>(m_options.tokenLifetime.count())},
+            {"scope",        "user-read-private user-read-email user-read-playback-state user-modify-playback-state"},
+        };
+        if (grantType == "authorization_code")
+        {
+            json.insert("refresh_token", "mock-refresh-token");
+        }
+
+        Response response = jsonResponse(request, json);
+        response.headers += "Cache-Control: no-store\r\n";
+        return response;
+    }
+
+    /** ************************************************************************************************
+    * @brief        Answer a request of the Web API, after the injected faults and the token check.
+    ***************************************************************************************************/
+    MockServer::Response MockServer::handleApi(const Request &request)
+    {
+        std::chrono::seconds retryAfter;
+        if (isRateLimited(retryAfter))
+        {
+            Response response = errorResponse(429, "API rate limit exceeded");
+            response.headers += "Retry-After: " + QByteArray::number(static_cast<qint64>(retryAfter.count())) + "\r\n";
+            return response;
+        }
+
+        if (m_options.errorRate > 0.0 && QRandomGenerator::global()->generateDouble() < m_options.errorRate)
+        {
+            return errorResponse(503, "Service unavailable");
+        }
+
+        Response response{0, QByteArray(), QByteArray()};
+        if (!checkAccessToken(request, response))
+        {
+            return response;
+        }
+
+        if (request.path == "v1/me")
+        {
+            return request.method == "GET" ? jsonResponse(request, buildUser()) : errorResponse(405, "Method not allowed");
+        }
+        if (request.path == "v1/me/player")
+        {
+            return request.method == "GET" ? jsonResponse(request, buildPlayback()) : errorResponse(405, "Method not allowed");
+        }
+        if (request.path.startsWith("v1/me/player/"))
+        {
+            return handlePlayer(request, request.path.mid(QStringLiteral("v1/me/player/").size()));
+        }
+
+        return errorResponse(404, "Service not found");
+    }
+
+    /** ************************************************************************************************
+    * @brief        Apply a playback command.
+    ***************************************************************************************************/
+    MockServer::Response MockServer::handlePlayer(const Request &request, const QString &command)
+    {
+        const struct
+        {
+            QString command;
+            QByteArray method;
+        }
+        commands[]
+        {
+            {"play",     "PUT" },
+            {"pause",    "PUT" },
+            {"next",     "POST"},
+            {"previous", "POST"},
+            {"seek",     "PUT" },
+        };
+
+        const auto match = std::find_if(std::begin(commands), std::end(commands),
+                                        [&command](const auto &entry)
+                                        {
+                                            return entry.command == command;
+                                        });
+        if (match == std::end(commands))
+        {
+            return errorResponse(404, "Service not found");
+        }
+        if (match->method != request.method)
+        {
+            return errorResponse(405, "Method not allowed");
+        }
+
+        const qint64 progress = getProgressMilliseconds();
+        m_progressTime = m_clock.elapsed();
+
+        if (command == "play")
+        {
+            m_playing  = true;
+            m_progress = progress;
+        }
+        else if (command == "pause")
+        {
+            m_playing  = false;
+            m_progress = progress;
+        }
+        else if (command == "next" || command == "previous")
+        {
+            const int step = command == "next" ? 1 : MOCK_TRACK_COUNT - 1;
+            m_trackIndex = (m_trackIndex + step) % MOCK_TRACK_COUNT;
+            m_progress = 0;
+        }
+        else
+        {
+            bool ok = false;
+            const qint64 position = request.query.queryItemValue("position_ms").toLongLong(&ok);
+            if (!ok || position < 0)
+            {
+                return errorResponse(400, "Invalid position_ms");
+            }
+            m_progress = std::min(position, MOCK_TRACK_DURATION_MS);
+        }
+
+        return {204, QByteArray(), QByteArray()};
+    }
+
+    /** ************************************************************************************************
+    * @brief        Count an API request in the rate limit window.
+    *
+    * @param[out]   retryAfter: The time until the end of the window, if the request is rejected.
+    *
+    * @return       True if the request exceeds the rate limit.
+    ***************************************************************************************************/
+    bool MockServer::isRateLimited(std::chrono::seconds &retryAfter)
+    {
+        if (m_options.rateLimit <= 0)
+        {
+            return false;
+        }
+
+        const qint64 now = m_clock.elapsed();
+        if (now - m_rateLimitWindowStart >= MOCK_RATE_LIMIT_WINDOW_MS)
+        {
+            m_rateLimitWindowStart = now;
+            m_rateLimitWindowCount = 0;
+        }
+
+        if (m_rateLimitWindowCount >= m_options.rateLimit)
+        {
+            // Retry-After is in whole seconds, rounded up.
+            const qint64 remaining = m_rateLimitWindowStart + MOCK_RATE_LIMIT_WINDOW_MS - now;
+            retryAfter = std::chrono::seconds((remaining + 999) / 1000);
+            return true;
+        }
+
+        ++m_rateLimitWindowCount;
+        return false;
+    }
+
+    /** ************************************************************************************************
+    * @brief        Check the bearer token of an API request.
+    *
+    * @param[out]   response: The 401 response to send if the token is missing, unknown or expired.
+    *
+    * @return       True if the token is valid.
+    ***************************************************************************************************/
+    bool MockServer::checkAccessToken(const Request &request, Response &response) const
+    {
+        const QByteArray authorization = request.headers.value("authorization");
+        const QByteArray token = authorization.startsWith("Bearer ") ? authorization.mid(7) : QByteArray();
+
+        const auto iterator = m_accessTokens.constFind(token);
+        if (token.isEmpty() || iterator == m_accessTokens.cend())
+        {
+            response = errorResponse(401, "Invalid access token");
+            return false;
+        }
+
+        const qint64 lifetime = std::chrono::duration_cast<std::chrono::milliseconds>(m_options.tokenLifetime).count();
+        if (m_clock.elapsed() - iterator.value() >= lifetime)
+        {
+            response = errorResponse(401, "The access token expired");
+            return false;
+        }
+
+        return true;
+    }
+
+    /** ************************************************************************************************
+    * @brief        Get the progress of the playback in the current track.
+    ***************************************************************************************************/
+    qint64 MockServer::getProgressMilliseconds() const
+    {
+        const qint64 progress = m_playing ? m_progress + m_clock.elapsed() - m_progressTime : m_progress;
+        return std::min(progress, MOCK_TRACK_DURATION_MS);
+    }
+
+    /** ************************************************************************************************
+    * @brief        Build the current playback object.
+    ***************************************************************************************************/
+    QJsonObject MockServer::buildPlayback() const
+    {
+        return QJsonObject
+        {
+            {"device", QJsonObject
+                {
+                    {"id",                 "mock-device"},
+                    {"is_active",          true},
+                    {"is_private_session", false},
+                    {"is_restricted",      false},
+                    {"name",               "Mock Device"},
+                    {"type",               "Computer"},
+                    {"volume_percent",     50},
+                }},
+            {"shuffle_state",          false},
+            {"repeat_state",           "off"},
+            {"timestamp",              static_cast<qint64>(m_progressTime)},
+            {"context",                QJsonValue()},
+            {"progress_ms",            getProgressMilliseconds()},
+            {"item",                   m_tracks[static_cast<size_t>(m_trackIndex)]},
+            {"currently_playing_type", "track"},
+            {"is_playing",             m_playing},
+        };
+    }
+
+    /** ************************************************************************************************
+    * @brief        Build a track of the mocked playback queue.
+    ***************************************************************************************************/
+    QJsonObject MockServer::buildTrack(int index)
+    {
+        const QString trackId  = QString("mocktrack%1").arg(index, 13, 10, QChar('0'));
+        const QString albumId  = QString("mockalbum%1").arg(index, 13, 10, QChar('0'));
+        const QString artistId = QStringLiteral("mockartist000000000000");
+
+        const QJsonObject artist
+        {
+            {"external_urls", QJsonObject{{"spotify", "https://open.spotify.com/artist/" + artistId}}},
+            {"href",          "https://api.spotify.com/v1/artists/" + artistId},
+            {"id",            artistId},
+            {"name",          "Mock Artist"},
+            {"type",          "artist"},
+            {"uri",           "spotify:artist:" + artistId},
+        };
+
+        const QJsonObject album
+        {
+            {"album_type",             "album"},
+            {"artists",                QJsonArray{artist}},
+            {"external_urls",          QJsonObject{{"spotify", "https://open.spotify.com/album/" + albumId}}},
+            {"href",                   "https://api.spotify.com/v1/albums/" + albumId},
+            {"id",                     albumId},
+            {"images",                 QJsonArray()},
+            {"name",                   QString("Mock Album %1").arg(index)},
+            {"release_date",           "2020-01-01"},
+            {"release_date_precision", "day"},
+            {"type",                   "album"},
+            {"uri",                    "spotify:album:" + albumId},
+        };
+
+        return QJsonObject
+        {
+            {"album",         album},
+            {"artists",       QJsonArray{artist}},
+            {"disc_number",   1},
+            {"duration_ms",   MOCK_TRACK_DURATION_MS},
+            {"explicit",      false},
+            {"external_urls", QJsonObject{{"spotify", "https://open.spotify.com/track/" + trackId}}},
+            {"href",          "https://api.spotify.com/v1/tracks/" + trackId},
+            {"id",            trackId},
+            {"is_local",      false},
+            {"is_playable",   true},
+            {"name",          QString("Mock Track %1").arg(index)},
+            {"popularity",    50},
+            {"track_number",  index + 1},
+            {"type",          "track"},
+            {"uri",           "spotify:track:" + trackId},
+        };
+    }
+
+    /** ************************************************************************************************
+    * @brief        Build the user object.
+    ***************************************************************************************************/
+    QJsonObject MockServer::buildUser()
+    {
+        return QJsonObject
+        {
+            {"country",      "SE"},
+            {"display_name", "Mock User"},
+            {"email",        "mock.user@example.com"},
+            {"href",         "https://api.spotify.com/v1/users/mockuser"},
+            {"id",           "mockuser"},
+            {"product",      "premium"},
+            {"type",         "user"},
+            {"uri",          "spotify:user:mockuser"},
+        };
+    }
+
+    /** ************************************************************************************************
+    * @brief        Build a JSON response with an ETag, or "304 Not Modified" if the client has the same
+    *               body.
+    ***************************************************************************************************/
+    MockServer::Response MockServer::jsonResponse(const Request &request, const QJsonObject &json)
+    {
+        const QByteArray body = QJsonDocument(json).toJson(QJsonDocument::Compact);
+        const QByteArray eTag = '"' + QCryptographicHash::hash(body, QCryptographicHash::Md5).toHex() + '"';
+        const QByteArray headers = "ETag: " + eTag + "\r\n";
+
+        if (request.method == "GET" && request.headers.value("if-none-match") == eTag)
+        {
+            return {304, headers, QByteArray()};
+        }
+
+        return {200, headers + "Content-Type: application/json; charset=utf-8\r\n", body};
+    }
+
+    /** ************************************************************************************************
+    * @brief        Build an error response in the format of the Web API.
+    ***************************************************************************************************/
+    MockServer::Response MockServer::errorResponse(int status, const QString &message)
+    {
+        const QJsonObject json{{"error", QJsonObject{{"status", status}, {"message", message}}}};
+
+        return {status, "Content-Type: application/json; charset=utf-8\r\n",
+                QJsonDocument(json).toJson(QJsonDocument::Compact)};
+    }
+
+    /** ************************************************************************************************
+    * @brief        Get the reason phrase of an HTTP status.
+    ***************************************************************************************************/
+    QByteArray MockServer::reasonPhrase(int status)
+    {
+        static const QHash<int, QByteArray> REASON_PHRASES
+        {
+            {200, "OK"},
+            {204, "No Content"},
+            {302, "Found"},
+            {304, "Not Modified"},
+            {400, "Bad Request"},
+            {401, "Unauthorized"},
+            {404, "Not Found"},
+            {405, "Method Not Allowed"},
+            {429, "Too Many Requests"},
+            {503, "Service Unavailable"},
+        };
+
+        return REASON_PHRASES.value(status, "Unknown");
+    }
+}
@@ -0,0 +1,187 @@
+#ifndef MOCKSERVER_H
+#define MOCKSERVER_H
+
+#include <chrono>
+#include <vector>
+
+#include <QObject>
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QJsonObject>
+#include <QUrlQuery>
+
+#include "Hpack.h"
+#include "TlsServer.h"
+
+class QTcpSocket;
+
+namespace Qtify
+{
+    /** ************************************************************************************************
+    * @class    MockServer
+    *
+    * @brief    HTTP or HTTPS server mocking the parts of the Spotify Web API and accounts service used
+    *           by the RequestHandler.
+    *
+    * @details  Served paths:
+    *           - GET authorize: redirects to the redirect_uri with an authorization code;
+    *           - POST api/token: issues access tokens for the authorization_code and refresh_token
+    *             grants;
+    *           - GET v1/me and GET v1/me/player, with ETags and "304 Not Modified";
+    *           - PUT v1/me/player/play, PUT v1/me/player/pause, POST v1/me/player/next,
+    *             POST v1/me/player/previous and PUT v1/me/player/seek, which update the playback.
+    *           API requests need a token issued by the server. Expired tokens are answered with 401, so
+    *           that the client refreshes them. Before being checked, API requests may be answered with
+    *           429 and Retry-After when the rate limit is exceeded, or with 503 at the given error rate.
+    *           Every reply is delayed by the given latency. Connections are kept alive, their requests
+    *           being answered in order.
+    *           With TLS, the server uses the test certificate of certs/ and can offer HTTP/2 with ALPN. The
+    *           HTTP/2 support is what a client of the API needs: the requests of a connection are answered
+    *           concurrently, server push and priorities are not used, and the flow control of the client
+    *           is not enforced since the replies are smaller than its initial window.
+    ***************************************************************************************************/
+    class MockServer : public QObject
+    {
+        Q_OBJECT
+
+        public:
+            /** ****************************************************************************************
+            * @struct   Options
+            *
+            * @brief    Protocols and faults injected by the server.
+            *******************************************************************************************/
+            struct Options
+            {
+                std::chrono::milliseconds latency{0};          /// Delay of every reply.
+                std::chrono::milliseconds latencyJitter{0};    /// Random delay added to the latency, at most.
+                double errorRate = 0.0;                        /// Share of API requests failing with 503.
+                std::chrono::seconds tokenLifetime{3600};      /// Lifetime of the access tokens.
+                int rateLimit = 0;                             /// API requests per second, 0 for no limit.
+                bool verbose = false;                          /// Log every request.
+                bool tls = false;                              /// Serve HTTPS with the test certificate.
+                bool http2 = false;                            /// Offer HTTP/2 to the TLS clients.
+                std::chrono::milliseconds handshakeLatency{0}; /// Delay before each TLS handshake.
+            };
+
+            explicit MockServer(const Options &options, QObject *parent = nullptr);
+
+            bool listen(const QHostAddress &address, quint16 port);
+            quint16 getPort() const;
+
+        signals:
+            void connectionEncrypted(const QByteArray &protocol);
+
+        private:
+            /** ****************************************************************************************
+            * @struct   Request
+            *
+            * @brief    A parsed HTTP request.
+            *******************************************************************************************/
+            struct Request
+            {
+                QByteArray method;
+                // Path without the leading slash.
+                QString path;
+                QUrlQuery query;
+                // Header values, by lower case name.
+                QHash<QByteArray, QByteArray> headers;
+                QByteArray body;
+            };
+
+            /** ****************************************************************************************
+            * @struct   Response
+            *
+            * @brief    An HTTP response to send.
+            *******************************************************************************************/
+            struct Response
+            {
+                int status;
+                // Header lines, each one ending with CRLF.
+                QByteArray headers;
+                QByteArray body;
+            };
+
+            /** ****************************************************************************************
+            * @struct   Connection
+            *
+            * @brief    State of a client connection.
+            *******************************************************************************************/
+            struct Connection
+            {
+                // Data received and not parsed yet.
+                QByteArray buffer;
+                // A response is waiting for its latency: the next requests wait for it.
+                bool busy = false;
+                // HTTP/2 was negotiated with ALPN.
+                bool http2 = false;
+                // HTTP/2: the client connection preface was received.
+                bool prefaceReceived = false;
+                // HTTP/2: decoder of the header blocks of the requests.
+                Hpack hpack;
+                // HTTP/2: requests being received, by stream identifier.
+                QHash<quint32, Request> streams;
+                // HTTP/2: stream whose header block goes on in CONTINUATION frames, 0 if none.
+                quint32 continuedStream = 0;
+                QByteArray continuedHeaders;
+                bool continuedEndStream = false;
+                // HTTP/2: highest stream identifier opened by the client.
+                quint32 lastStream = 0;
+            };
+
+            void onNewConnection();
+            void onEncrypted();
+            void onReadyRead();
+            void processRequests(QTcpSocket *socket);
+            static bool parseRequest(QByteArray &buffer, Request &request, bool &valid);
+            static void setTarget(Request &request, const QByteArray &target);
+            void send(QTcpSocket *socket, const Response &response, bool close);
+            qint64 getReplyDelay() const;
+
+            void processFrames(QTcpSocket *socket);
+            quint32 handleFrame(QTcpSocket *socket, uchar type, uchar flags, quint32 streamId, QByteArray payload);
+            quint32 handleHeaders(QTcpSocket *socket, quint32 streamId, const QByteArray &block, bool endStream);
+            void answerStream(QTcpSocket *socket, quint32 streamId);
+            void sendStream(QTcpSocket *socket, quint32 streamId, const Response &response);
+            static void writeFrame(QTcpSocket *socket, uchar type, uchar flags, quint32 streamId,
+                                   const QByteArray &payload = QByteArray());
+
+            Response handle(const Request &request);
+            Response handleAuthorize(const Request &request);
+            Response handleToken(const Request &request);
+            Response handleApi(const Request &request);
+            Response handlePlayer(const Request &request, const QString &command);
+            bool isRateLimited(std::chrono::seconds &retryAfter);
+            bool checkAccessToken(const Request &request, Response &response) const;
+
+            qint64 getProgressMilliseconds() const;
+            QJsonObject buildPlayback() const;
+            static QJsonObject buildTrack(int index);
+            static QJsonObject buildUser();
+
+            static Response jsonResponse(const Request &request, const QJsonObject &json);
+            static Response errorResponse(int status, const QString &message);
+            static QByteArray reasonPhrase(int status);
+
+            Options m_options;
+            TlsServer m_server;
+            QHash<QTcpSocket*, Connection> m_connections;
+            // Time since the start of the server, for the token lifetimes and the playback progress.
+            QElapsedTimer m_clock;
+            // Time at which each access token was issued, in milliseconds of m_clock.
+            QHash<QByteArray, qint64> m_accessTokens;
+            int m_issuedTokenCount = 0;
+            // Start of the current rate limit window and number of requests in it.
+            qint64 m_rateLimitWindowStart = 0;
+            int m_rateLimitWindowCount = 0;
+            // Playback state. The progress is m_progress at m_progressTime, plus the time elapsed while
+            // playing.
+            std::vector<QJsonObject> m_tracks;
+            int m_trackIndex = 0;
+            bool m_playing = true;
+            qint64 m_progress = 0;
+            qint64 m_progressTime = 0;
+    };
+}
+
+#endif // MOCKSERVER_H
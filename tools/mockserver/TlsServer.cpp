@@ -0,0 +1,60 @@
+#include "TlsServer.h"
+
+#include <QSslSocket>
+#include <QTimer>
+
+namespace Qtify
+{
+    /** ************************************************************************************************
+    * @brief        Constructor.
+    ***************************************************************************************************/
+    TlsServer::TlsServer(QObject *parent) :
+        QTcpServer(parent)
+    {
+
+    }
+
+    /** ************************************************************************************************
+    * @brief        Set the certificate, private key and protocols of the connections. A null
+    *               configuration serves plain TCP connections.
+    ***************************************************************************************************/
+    void TlsServer::setSslConfiguration(const QSslConfiguration &configuration)
+    {
+        m_sslConfiguration = configuration;
+    }
+
+    /** ************************************************************************************************
+    * @brief        Set the delay before the handshake of each new connection starts.
+    ***************************************************************************************************/
+    void TlsServer::setHandshakeLatency(std::chrono::milliseconds latency)
+    {
+        m_handshakeLatency = latency;
+    }
+
+    /** ************************************************************************************************
+    * @brief        Create the socket of a new connection and start the server side of its handshake.
+    ***************************************************************************************************/
+    void TlsServer::incomingConnection(qintptr socketDescriptor)
+    {
+        if (m_sslConfiguration.isNull())
+        {
+            QTcpServer::incomingConnection(socketDescriptor);
+            return;
+        }
+
+        QSslSocket *socket = new QSslSocket(this);
+        if (!socket->setSocketDescriptor(socketDescriptor))
+        {
+            delete socket;
+            return;
+        }
+
+        socket->setSslConfiguration(m_sslConfiguration);
+        addPendingConnection(socket);
+
+        QTimer::singleShot(m_handshakeLatency, socket, [socket]()
+        {
+            socket->startServerEncryption();
+        });
+    }
+}
@@ -0,0 +1,41 @@
+#ifndef TLSSERVER_H
+#define TLSSERVER_H
+
+#include <chrono>
+
+#include <QSslConfiguration>
+#include <QTcpServer>
+
+namespace Qtify
+{
+    /** ************************************************************************************************
+    * @class    TlsServer
+    *
+    * @brief    TCP server whose connections are QSslSocket objects in server mode, when an SSL
+    *           configuration is set.
+    *
+    * @details  Qt 5 has no QSslServer: the sockets are created in incomingConnection() and the server
+    *           side of the handshake is started on them. They are returned by nextPendingConnection() as
+    *           soon as the TCP connection is accepted: their data must not be read before encrypted() is
+    *           emitted, since it belongs to the handshake. Without an SSL configuration, this is a plain
+    *           QTcpServer.
+    *           The handshakes can be delayed, to mock the round trips they take over a real network.
+    ***************************************************************************************************/
+    class TlsServer : public QTcpServer
+    {
+        public:
+            explicit TlsServer(QObject *parent = nullptr);
+
+            void setSslConfiguration(const QSslConfiguration &configuration);
+            void setHandshakeLatency(std::chrono::milliseconds latency);
+
+        protected:
+            void incomingConnection(qintptr socketDescriptor) override;
+
+        private:
+            QSslConfiguration m_sslConfiguration;
+            std::chrono::milliseconds m_handshakeLatency{0};
+    };
+}
+
+#endif // TLSSERVER_H
@@ -0,0 +1,80 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QHostAddress>
+#include <QDebug>
+
+#include <algorithm>
+#include <chrono>
+
+#include "MockServer.h"
+
+using namespace Qtify;
+
+/** ****************************************************************************************************
+*   Local mock of the Spotify Web API. The faults to inject are given on the command line, see --help.
+*******************************************************************************************************/
+int main(int argc, char *argv[])
+{
+    QCoreApplication application(argc, argv);
+    QCoreApplication::setApplicationName("qtify-mockserver");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Local mock of the Spotify Web API for load and latency tests.");
+    parser.addHelpOption();
+
+    const QCommandLineOption addressOption("address", "Address to listen on.", "address", "127.0.0.1");
+    const QCommandLineOption portOption("port", "Port to listen on.", "port", "8888");
+    const QCommandLineOption latencyOption("latency", "Delay of every reply, in milliseconds.", "ms", "0");
+    const QCommandLineOption jitterOption("jitter", "Random delay added to the latency, at most, in milliseconds.",
+                                          "ms", "0");
+    const QCommandLineOption errorRateOption("error-rate", "Share of API requests failing with 503, from 0 to 1.",
+                                             "rate", "0");
+    const QCommandLineOption tokenLifetimeOption("token-lifetime",
+                                                 "Lifetime of the access tokens, in seconds. Requests with an "
+                                                 "expired token are answered with 401.", "s", "3600");
+    const QCommandLineOption rateLimitOption("rate-limit",
+                                             "API requests allowed per second, beyond which requests are answered "
+                                             "with 429 and Retry-After. 0 for no limit.", "requests", "0");
+    const QCommandLineOption verboseOption("verbose", "Log every request.");
+    const QCommandLineOption tlsOption("tls", "Serve HTTPS with the test certificate of certs/, issued for localhost "
+                                              "and 127.0.0.1. The client must trust it.");
+    const QCommandLineOption http2Option("http2", "Offer HTTP/2 to the clients with ALPN. Needs --tls.");
+    const QCommandLineOption handshakeLatencyOption("handshake-latency",
+                                                    "Delay before each TLS handshake, in milliseconds.", "ms", "0");
+
+    parser.addOptions({addressOption, portOption, latencyOption, jitterOption, errorRateOption,
+                       tokenLifetimeOption, rateLimitOption, verboseOption, tlsOption, http2Option,
+                       handshakeLatencyOption});
+    parser.process(application);
+
+    MockServer::Options options;
+    options.latency          = std::chrono::milliseconds(std::max(parser.value(latencyOption).toInt(), 0));
+    options.latencyJitter    = std::chrono::milliseconds(std::max(parser.value(jitterOption).toInt(), 0));
+    options.errorRate        = qBound(0.0, parser.value(errorRateOption).toDouble(), 1.0);
+    options.tokenLifetime    = std::chrono::seconds(std::max(parser.value(tokenLifetimeOption).toInt(), 1));
+    options.rateLimit        = std::max(parser.value(rateLimitOption).toInt(), 0);
+    options.verbose          = parser.isSet(verboseOption);
+    options.tls              = parser.isSet(tlsOption);
+    options.http2            = parser.isSet(http2Option);
+    options.handshakeLatency = std::chrono::milliseconds(std::max(parser.value(handshakeLatencyOption).toInt(), 0));
+
+    if (options.http2 && !options.tls)
+    {
+        qWarning() << "HTTP/2 is only offered over TLS, add --tls";
+        return 1;
+    }
+
+    const QHostAddress address(parser.value(addressOption));
+    const quint16 port = static_cast<quint16>(parser.value(portOption).toUInt());
+
+    MockServer server(options);
+    if (address.isNull() || !server.listen(address, port))
+    {
+        return 1;
+    }
+
+    const QString baseUrl = QString("%1://%2:%3/").arg(options.tls ? "https" : "http").arg(address.toString()).arg(port);
+    qInfo().noquote() << QString("Serving the mock API: setServiceUrls(%1, %1authorize, %1api/token)").arg(baseUrl);
+
+    return application.exec();
+}
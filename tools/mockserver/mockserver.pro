@@ -0,0 +1,25 @@
+# Local mock of the Spotify Web API, for load and latency tests without network access.
+# Point a RequestHandler at it with setServiceUrls(), see README.md.
+# certs/ holds a self-signed certificate for localhost, whose private key is public: only use it for tests.
+
+QT += network
+QT -= gui
+
+CONFIG += c++14 console
+CONFIG -= app_bundle
+
+TARGET = qtify-mockserver
+
+HEADERS += \
+    Hpack.h \
+    MockServer.h \
+    TlsServer.h
+
+SOURCES += \
+    Hpack.cpp \
+    MockServer.cpp \
+    TlsServer.cpp \
+    main.cpp
+
+RESOURCES += \
+    mockserver.qrc